@@ -141,6 +141,7 @@ static io_stream_t prev_stream = {0};
 const io_stream_t serial_stream = {
     .type = StreamType_Serial,
     .read = uartRead,
+    .read_span = uartReadSpan,
     .write = uartWriteS,
     .write_all = uartWriteS,
     .get_rx_buffer_available = uartRXFree,
@@ -185,6 +186,7 @@ const io_stream_t telnet_stream = {
 const io_stream_t websocket_stream = {
     .type = StreamType_WebSocket,
     .read = WsStreamGetC,
+    .read_span = WsStreamReadSpan,
     .write = WsStreamWriteS,
     .write_all = tcpStreamWriteS,
     .get_rx_buffer_available = WsStreamRxFree,
@@ -852,6 +854,7 @@ IRAM_ATTR static void modeSelect (bool mpg_mode)
         memcpy(&prev_stream, &hal.stream, sizeof(io_stream_t));
         hal.stream.type = StreamType_MPG;
         hal.stream.read = uart2Read;
+        hal.stream.read_span = NULL;
         hal.stream.write = serial_stream.write;
         hal.stream.get_rx_buffer_available = uart2RXFree;
         hal.stream.reset_read_buffer = uart2Flush;
@@ -1260,7 +1263,7 @@ static bool driver_setup (settings_t *settings)
 
   // Set defaults
 
-    IOInitDone = settings->version == 15;
+    IOInitDone = settings->version == 16;
 
     settings_changed(settings);
 
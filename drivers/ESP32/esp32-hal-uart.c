@@ -121,6 +121,7 @@ static void IRAM_ATTR _uart1_isr (void *arg)
             rxbuffer.backup = true;
             rxbuffer.tail = rxbuffer.head;
             hal.stream.read = uartRead; // restore normal input
+            hal.stream.read_span = uartReadSpan;
 
         } else if(!hal.stream.enqueue_realtime_command(c)) {
 
@@ -300,6 +301,29 @@ int16_t uartRead (void)
     return data;
 }
 
+// Copies input up to and including the first end of line character, returns 0 if no data available
+uint16_t uartReadSpan (char *buf, uint16_t max)
+{
+    char c;
+    uint16_t count = 0;
+
+    UART_MUTEX_LOCK(uart1);
+
+    uint16_t bptr = rxbuffer.tail, head = rxbuffer.head;
+
+    while(count < max && bptr != head) {
+        buf[count++] = c = rxbuffer.data[bptr];
+        bptr = (bptr + 1) & (RX_BUFFER_SIZE - 1);
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    rxbuffer.tail = bptr;                         // Update pointer
+    UART_MUTEX_UNLOCK(uart1);
+
+    return count;
+}
+
 bool uartPutC (const char c)
 {
     UART_MUTEX_LOCK(uart1);
@@ -342,9 +366,10 @@ IRAM_ATTR void uartCancel (void)
 IRAM_ATTR bool uartSuspendInput (bool suspend)
 {
     UART_MUTEX_LOCK(uart1);
-    if(suspend)
+    if(suspend) {
         hal.stream.read = uartGetNull;
-    else if(rxbuffer.backup)
+        hal.stream.read_span = NULL;
+    } else if(rxbuffer.backup)
         memcpy(&rxbuffer, &rxbackup, sizeof(stream_rx_buffer_t));
     UART_MUTEX_UNLOCK(uart1);
 
@@ -60,6 +60,7 @@ uint32_t uartAvailable (void);
 uint16_t uartRXFree (void);
 uint32_t uartAvailableForWrite (void);
 int16_t uartRead (void);
+uint16_t uartReadSpan (char *buf, uint16_t max);
 bool uartSuspendInput (bool suspend);
 
 bool uartPutC (const char c);
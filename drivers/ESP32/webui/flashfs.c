@@ -172,6 +172,7 @@ static message_code_t trap_feedback_message (message_code_t message_code)
             file.eol = false;
             report_feedback_message(Message_CycleStartToRerun);
             hal.stream.read = await_cycle_start;
+            hal.stream.read_span = NULL;
             hal.state_change_requested = trap_state_change_request;
         } else
             flashfs_end_job();
@@ -195,10 +196,12 @@ static bool flashfs_suspend (bool suspend)
     if(suspend) {
         hal.stream.reset_read_buffer();
         hal.stream.read = active_stream.read;               // Restore normal stream input for tool change (jog etc)
+        hal.stream.read_span = active_stream.read_span;
         hal.stream.enqueue_realtime_command = active_stream.enqueue_realtime_command;
         hal.report.status_message = report_status_message;  // as well as normal status messages reporting
     } else {
         hal.stream.read = flashfs_read;                      // Resume reading from SD card
+        hal.stream.read_span = NULL;
         hal.stream.enqueue_realtime_command = drop_input_stream;
         hal.report.status_message = trap_status_report;     // and redirect status messages back to us
     }
@@ -220,6 +223,7 @@ status_code_t flashfs_stream_file (char *filename)
             memcpy(&active_stream, &hal.stream, sizeof(io_stream_t));   // Save current stream pointers
             hal.stream.type = StreamType_FlashFs;                       // then redirect to read from SD card instead
             hal.stream.read = flashfs_read;                             // ...
+            hal.stream.read_span = NULL;                                // ...
             hal.stream.enqueue_realtime_command = drop_input_stream;    // Drop input from current stream except realtime commands
 #if M6_ENABLE
             hal.stream.suspend_read = flashfs_suspend;                  // ...
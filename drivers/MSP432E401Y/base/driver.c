@@ -102,6 +102,7 @@ static void enetStreamWriteS (const char *data)
     const io_stream_t ethernet_stream = {
         .type = StreamType_Telnet,
         .read = TCPStreamGetC,
+        .read_span = TCPStreamReadSpan,
         .write = TCPStreamWriteS,
         .write_all = enetStreamWriteS,
         .get_rx_buffer_available = TCPStreamRxFree,
@@ -120,6 +121,7 @@ static void enetStreamWriteS (const char *data)
     const io_stream_t websocket_stream = {
         .type = StreamType_WebSocket,
         .read = WsStreamGetC,
+        .read_span = WsStreamReadSpan,
         .write = WsStreamWriteS,
         .write_all = enetStreamWriteS,
         .get_rx_buffer_available = WsStreamRxFree,
@@ -139,6 +141,7 @@ static void enetStreamWriteS (const char *data)
 const io_stream_t serial_stream = {
     .type = StreamType_Serial,
     .read = serialGetC,
+    .read_span = serialReadSpan,
     .write = serialWriteS,
 #if ETHERNET_ENABLE
     .write_all = enetStreamWriteS,
@@ -1135,6 +1138,7 @@ static void modeSelect (bool mpg_mode)
     if(mpg_mode) {
         normal_stream = hal.stream.type;
         hal.stream.read = serial2GetC;
+        hal.stream.read_span = NULL;
         hal.stream.get_rx_buffer_available = serial2RxFree;
         hal.stream.cancel_read_buffer = serial2RxCancel;
         hal.stream.reset_read_buffer = serial2RxFlush;
@@ -1614,7 +1618,7 @@ static bool driver_setup (settings_t *settings)
 
   // Set defaults
 
-    IOInitDone = settings->version == 15;
+    IOInitDone = settings->version == 16;
 
     settings_changed(settings);
 
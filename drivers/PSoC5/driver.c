@@ -393,7 +393,7 @@ static bool driver_setup (settings_t *settings)
 
 #endif
 
-    return settings->version == 15;
+    return settings->version == 16;
 }
 
 // Initialize HAL pointers
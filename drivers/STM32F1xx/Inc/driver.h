@@ -61,6 +61,10 @@
 #define FLASH_ENABLE 0
 #endif
 
+#if FLASH_ENABLE
+#define FLASH_LOG_SECTORS 8 // Flash pages at end of flash reserved for the settings log, 0 to store the settings in the last page.
+#endif
+
 #if EEPROM_ENABLE|| KEYPAD_ENABLE || (TRINAMIC_ENABLE && TRINAMIC_I2C)
 #define I2C_PORT
 #endif
@@ -26,5 +26,8 @@
 
 bool memcpy_from_flash (uint8_t *dest);
 bool memcpy_to_flash (uint8_t *source);
+bool flash_log_erase (uint_fast8_t sector);
+bool flash_log_write (uint_fast8_t sector, uint32_t offset, uint8_t *source, uint32_t size);
+bool flash_log_read (uint_fast8_t sector, uint32_t offset, uint8_t *dest, uint32_t size);
 
 #endif
@@ -31,6 +31,7 @@
 
 void serialInit(void);
 int16_t serialGetC(void);
+uint16_t serialReadSpan(char *buf, uint16_t max);
 void serialWriteS(const char *s);
 uint16_t serialRxFree(void);
 void serialRxFlush(void);
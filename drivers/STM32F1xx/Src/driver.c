@@ -770,7 +770,7 @@ static bool driver_setup (settings_t *settings)
 
 #endif
 
-    IOInitDone = settings->version == 15;
+    IOInitDone = settings->version == 16;
 
     settings_changed(settings);
 
@@ -886,6 +886,7 @@ bool driver_init (void)
 
 #if USB_ENABLE
     hal.stream.read = usbGetC;
+    hal.stream.read_span = usbReadSpan;
     hal.stream.write = usbWriteS;
     hal.stream.write_all = usbWriteS;
     hal.stream.get_rx_buffer_available = usbRxFree;
@@ -893,6 +894,7 @@ bool driver_init (void)
     hal.stream.cancel_read_buffer = usbRxCancel;
 #else
     hal.stream.read = serialGetC;
+    hal.stream.read_span = serialReadSpan;
     hal.stream.write = serialWriteS;
     hal.stream.write_all = serialWriteS;
     hal.stream.get_rx_buffer_available = serialRxFree;
@@ -910,6 +912,13 @@ bool driver_init (void)
     hal.eeprom.type = EEPROM_Emulated;
     hal.eeprom.memcpy_from_flash = memcpy_from_flash;
     hal.eeprom.memcpy_to_flash = memcpy_to_flash;
+  #if FLASH_LOG_SECTORS
+    hal.eeprom.flash_log.sectors = FLASH_LOG_SECTORS;
+    hal.eeprom.flash_log.sector_size = FLASH_PAGE_SIZE;
+    hal.eeprom.flash_log.erase = flash_log_erase;
+    hal.eeprom.flash_log.write = flash_log_write;
+    hal.eeprom.flash_log.read = flash_log_read;
+  #endif
 #else
     hal.eeprom.type = EEPROM_None;
 #endif
@@ -6,7 +6,8 @@
 
   Copyright (c) 2019 Terje Io
 
-  This code reads/writes the whole RAM-based emulated EPROM contents from/to flash
+  This code reads/writes the whole RAM-based emulated EPROM contents from/to flash,
+  or provides sector based access for the log structured settings store
 
   Grbl is free software: you can redistribute it and/or modify
   it under the terms of the GNU General Public License as published by
@@ -26,6 +27,7 @@
 #include "../grbl/grbl.h"
 
 #include "main.h"
+#include "driver.h"
 #include "stm32f1xx_hal_flash_ex.h"
 
 static const uint8_t *flash_target = (uint8_t *)(FLASH_BANK1_END - FLASH_PAGE_SIZE + 1);    // Last page start adress
@@ -68,3 +70,62 @@ bool memcpy_to_flash (uint8_t *source)
 
     return status == HAL_OK;
 }
+
+//
+// Sector based access for the log structured settings store, a sector is a flash page.
+// The pages are at the end of flash, the last page is shared with the whole image storage above
+// so that settings stored by earlier versions are imported on first use.
+//
+
+#if FLASH_LOG_SECTORS
+
+static const uint8_t *flash_log = (uint8_t *)(FLASH_BANK1_END + 1 - FLASH_LOG_SECTORS * FLASH_PAGE_SIZE);
+
+bool flash_log_erase (uint_fast8_t sector)
+{
+    uint32_t error;
+
+    FLASH_EraseInitTypeDef erase = {
+        .Banks = FLASH_BANK_1,
+        .TypeErase = FLASH_TYPEERASE_PAGES,
+        .NbPages = 1,
+        .PageAddress = (uint32_t)flash_log + sector * FLASH_PAGE_SIZE
+    };
+
+    HAL_FLASH_Unlock();
+
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &error);
+
+    HAL_FLASH_Lock();
+
+    return status == HAL_OK;
+}
+
+bool flash_log_write (uint_fast8_t sector, uint32_t offset, uint8_t *source, uint32_t size)
+{
+    HAL_StatusTypeDef status = HAL_OK;
+    uint32_t address = (uint32_t)flash_log + sector * FLASH_PAGE_SIZE + offset;
+
+    HAL_FLASH_Unlock();
+
+    // Programmed a halfword at a time, source may not be aligned.
+    while(size && status == HAL_OK) {
+        status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, source[0] | (source[1] << 8));
+        source += 2;
+        address += 2;
+        size -= 2;
+    }
+
+    HAL_FLASH_Lock();
+
+    return status == HAL_OK;
+}
+
+bool flash_log_read (uint_fast8_t sector, uint32_t offset, uint8_t *dest, uint32_t size)
+{
+    memcpy(dest, flash_log + sector * FLASH_PAGE_SIZE + offset, size);
+
+    return true;
+}
+
+#endif
@@ -116,6 +116,32 @@ int16_t usbGetC (void)
     return (int16_t)data;
 }
 
+//
+// usbReadSpan - copies input up to and including the first end of line character, returns 0 if no data available
+//
+uint16_t usbReadSpan (char *buf, uint16_t max)
+{
+    char c;
+    uint16_t count = 0, tail = rxbuf.tail, bptr = tail, head = rxbuf.head;
+
+    while(count < max && bptr != head) {
+        buf[count++] = c = rxbuf.data[bptr];
+        bptr = (bptr + 1) & (RX_BUFFER_SIZE - 1);
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    // Keep the tail set by a stop or jog cancel received while copying, the span is cancelled input then.
+    __disable_irq();
+    if(rxbuf.tail == tail)
+        rxbuf.tail = bptr; // Update pointer
+    else
+        count = 0;
+    __enable_irq();
+
+    return count;
+}
+
 void usbBufferInput (uint8_t *data, uint32_t length)
 {
     while(length--) {
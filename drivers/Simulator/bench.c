@@ -0,0 +1,784 @@
+/*
+  bench.c - per stage execution time measurement for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// Measures host execution time of the stages of the streaming pipeline, from the g-code parser down to
+// the stepper interrupt handler. The core is not modified, the stage entry points are intercepted by
+// the linker (see README.md for build options). Since only calls between translation units can be
+// intercepted, mc_line() calls made from mc_arc() and mc_arc_resume() are accounted for by the arc stage.
+//
+// Each stage is accounted both inclusive and exclusive of time spent in nested stages, time spent in
+// the simulator itself is excluded from core time.
+//
+// On x86 hosts the stepper ISR is in addition measured in CPU cycles by the time stamp counter, excluding
+// the overhead of the time measurement. This is a better measure of ISR cost than the time per call since
+// the ISR is short compared to the resolution and overhead of the system clock.
+//
+// Kernels are core functions measured and checked in isolation by bench_kernel(), outside of a job run.
+//
+
+#ifdef BENCHMARK
+
+#include <time.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <math.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES
+#define BENCH_CYCLES_HIST 2048 // Histogram size for median, longer calls are counted in the last entry
+#endif
+
+#include "grbl/grbl.h"
+
+#include "bench.h"
+#include "simulator.h"
+
+#ifdef WALL_PLOTTER
+#include "grbl/wall_plotter.h"
+#endif
+#ifdef MASLOW_ROUTER
+#include "grbl/maslow.h"
+#endif
+
+#define BENCH_MAX_DEPTH 16
+
+typedef struct {
+    uint64_t calls;
+    uint64_t inclusive;     // ns
+    uint64_t exclusive;     // ns
+    uint64_t max;           // ns, longest single call
+} bench_stat_t;
+
+typedef struct {
+    bench_stage_t stage;
+    uint64_t entered;
+} bench_frame_t;
+
+static const char *const stage_name[Stage_N] = {
+    "protocol (other)",
+    "gc_execute_block",
+    "execute_realtime",
+    "mc_line",
+    "mc_arc",
+    "plan_buffer_line",
+    "st_prep_buffer",
+    "stepper ISR",
+    "realtime report",
+    "simulator"
+};
+
+static uint64_t started, last;
+static uint_fast8_t depth, overflow, last_exit_depth = 0;
+static bench_stage_t last_exit = Stage_Protocol;
+static bench_frame_t stack[BENCH_MAX_DEPTH];
+static bench_stat_t stats[Stage_N];
+static uint64_t report_writes;
+#ifdef BENCH_CYCLES
+static uint64_t isr_cycles, isr_calls, tsc_overhead;
+static uint32_t isr_hist[BENCH_CYCLES_HIST];
+#endif
+
+static inline uint64_t now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+void bench_start (void)
+{
+    memset(stats, 0, sizeof(stats));
+    report_writes = 0;
+
+#ifdef BENCH_CYCLES
+    uint_fast8_t idx;
+    uint64_t t;
+
+    // Calibrate time stamp counter read overhead, smallest of a number of back-to-back reads.
+    isr_cycles = isr_calls = 0;
+    memset(isr_hist, 0, sizeof(isr_hist));
+    tsc_overhead = UINT64_MAX;
+    for(idx = 0; idx < 100; idx++) {
+        t = __rdtsc();
+        t = __rdtsc() - t;
+        if(t < tsc_overhead)
+            tsc_overhead = t;
+    }
+#endif
+
+    depth = overflow = 0;
+    stack[0].stage = Stage_Protocol;
+    stack[0].entered = started = last = now_ns();
+    stats[Stage_Protocol].calls = 1;
+}
+
+void bench_enter (bench_stage_t stage)
+{
+    uint64_t t = now_ns();
+
+    // Time between back-to-back realtime polls is spent in a wait loop, charge it to waiting.
+    if(stage == Stage_Realtime && last_exit == Stage_Realtime && last_exit_depth == depth)
+        stats[Stage_Realtime].exclusive += t - last;
+    else
+        stats[stack[depth].stage].exclusive += t - last;
+    last = t;
+    last_exit = Stage_Protocol;
+
+    if(depth == BENCH_MAX_DEPTH - 1)
+        overflow++; // Accounted for by enclosing stage
+    else {
+        stack[++depth].stage = stage;
+        stack[depth].entered = t;
+        stats[stage].calls++;
+    }
+}
+
+void bench_exit (void)
+{
+    uint64_t t = now_ns(), elapsed;
+
+    stats[stack[depth].stage].exclusive += t - last;
+    last = t;
+
+    if(overflow)
+        overflow--;
+    else if(depth) {
+        elapsed = t - stack[depth].entered;
+        stats[stack[depth].stage].inclusive += elapsed;
+        if(elapsed > stats[stack[depth].stage].max)
+            stats[stack[depth].stage].max = elapsed;
+        last_exit = stack[depth--].stage;
+        last_exit_depth = depth;
+    }
+}
+
+void bench_report (FILE *out)
+{
+    uint_fast8_t idx;
+    uint64_t t = now_ns(), total = t - started, core, processing;
+    double sim_s = (double)sim_stats.ticks / (double)sim_config.f_step_timer;
+
+    stats[stack[depth].stage].exclusive += t - last;
+    stats[Stage_Protocol].inclusive = total;
+    last = t;
+
+    core = total - stats[Stage_Simulator].exclusive;
+    processing = stats[Stage_Parser].exclusive + stats[Stage_MotionControl].exclusive + stats[Stage_Arc].exclusive + stats[Stage_Planner].exclusive;
+
+    fprintf(out, "\nStage                  Calls    Incl ms    Excl ms  Excl us/call   Max us  Excl %%\n");
+
+    for(idx = 0; idx < Stage_N; idx++) {
+        bench_stat_t *stat = &stats[idx];
+        fprintf(out, "%-17s %10llu %10.3f %10.3f %13.3f %8.1f %6.1f\n",
+                      stage_name[idx],
+                       (unsigned long long)stat->calls,
+                        (double)stat->inclusive / 1e6,
+                         (double)stat->exclusive / 1e6,
+                          stat->calls ? (double)stat->exclusive / 1e3 / (double)stat->calls : 0.0,
+                           (double)stat->max / 1e3,
+                            total ? 100.0 * (double)stat->exclusive / (double)total : 0.0);
+    }
+
+    fprintf(out, "\nCore time:         %.3f ms, simulator excluded\n", (double)core / 1e6);
+    fprintf(out, "Block processing:  %.3f ms, parser, motion control and planner excluding waits\n", (double)processing / 1e6);
+
+    if(processing) {
+        fprintf(out, "Parser throughput: %.0f blocks/s\n", (double)stats[Stage_Parser].calls * 1e9 / (double)processing);
+        fprintf(out, "Planner input:     %.0f blocks/s\n", (double)stats[Stage_Planner].calls * 1e9 / (double)processing);
+    }
+
+#ifdef BENCH_CYCLES
+    if(isr_calls) {
+        uint_fast16_t median = 0;
+        uint64_t count = isr_hist[0];
+        while(count < (isr_calls + 1) / 2)
+            count += isr_hist[++median];
+        fprintf(out, "Stepper ISR:       %u cycles/call median, %.1f average, time stamp counter\n", (unsigned int)median, (double)isr_cycles / (double)isr_calls);
+    }
+#endif
+
+    if(stats[Stage_Report].calls)
+        fprintf(out, "Realtime reports:  %.3f us/report, %.1f stream writes/report\n", (double)stats[Stage_Report].inclusive / 1e3 / (double)stats[Stage_Report].calls,
+                      (double)report_writes / (double)stats[Stage_Report].calls);
+
+    if(sim_s > 0.0)
+        fprintf(out, "Job rate:          %.0f planner blocks per simulated second\n", (double)stats[Stage_Planner].calls / sim_s);
+}
+
+/*
+ * Kernels
+ */
+
+#define KERNEL_SAMPLES 4096     // Inputs per timing pass, these are cycled through to defeat branch prediction
+#define KERNEL_PASSES 1000
+#define KERNEL_RANDOM 2000000   // Number of random inputs checked
+
+typedef struct {
+    uint64_t calls;
+    uint64_t checks;
+    uint64_t errors;
+} kernel_result_t;
+
+static char kernel_str[KERNEL_SAMPLES][24];
+static float kernel_float[KERNEL_SAMPLES];
+static uint8_t kernel_decimals[KERNEL_SAMPLES];
+
+// Deterministic pseudo random numbers, independent of the C library.
+static uint32_t kernel_rand (void)
+{
+    static uint32_t x = 2463534242UL;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+
+    return x;
+}
+
+static void kernel_timing (FILE *out, const char *name, uint64_t calls, uint64_t elapsed)
+{
+    fprintf(out, "%-20s %.1f ns/call\n", name, (double)elapsed / (double)calls);
+}
+
+static void kernel_fail (kernel_result_t *result, FILE *out, const char *fmt, ...)
+{
+    if(result->errors++ < 20) {
+        va_list args;
+        va_start(args, fmt);
+        vfprintf(out, fmt, args);
+        va_end(args);
+    }
+}
+
+// ftoa() has to output the same digits as printf, which rounds the exact value of the float
+// half to even. printf outputs a minus sign for negative zero, ftoa() does not.
+static void check_ftoa (kernel_result_t *result, FILE *out, float value, uint8_t decimals)
+{
+    char ref[64], *s = ftoa(value, decimals);
+
+    snprintf(ref, sizeof(ref), "%.*f", decimals, value);
+    if(decimals == 0)
+        strcat(ref, ".");
+
+    result->checks++;
+
+    if(strcmp(s, ref) && !(value == 0.0f && !strcmp(s, ref + 1)))
+        kernel_fail(result, out, "ftoa(%.9g, %u): %s, expected %s\n", value, decimals, s, ref);
+}
+
+// read_float() has to return the correctly rounded float as strtof() does, and consume the complete string.
+static void check_read_float (kernel_result_t *result, FILE *out, char *str)
+{
+    float value = NAN, ref = strtof(str, NULL);
+    uint_fast8_t cc = 0;
+
+    result->checks++;
+
+    if(!read_float(str, &cc, &value) || !(value == ref || (value == 0.0f && ref == 0.0f)) || cc != strlen(str))
+        kernel_fail(result, out, "read_float(\"%s\"): %.9g, expected %.9g\n", str, value, ref);
+}
+
+// Random number string with up to 11 integer digits, possibly leading zeros, and up to 19 decimals.
+static void random_number_string (char *s)
+{
+    uint_fast8_t idx, digits = kernel_rand() % 12, decimals = kernel_rand() % 20;
+
+    if(kernel_rand() & 1)
+        *s++ = '-';
+
+    for(idx = 0; idx < digits; idx++)
+        *s++ = '0' + (idx == 0 && kernel_rand() % 3 ? 0 : kernel_rand() % 10);
+
+    if(decimals || !digits) {
+        *s++ = '.';
+        for(idx = 0; idx < decimals; idx++)
+            *s++ = '0' + kernel_rand() % 10;
+        if(!digits && !decimals)
+            *s++ = '7';
+    }
+
+    *s = '\0';
+}
+
+// Times ftoa() and read_float() for coordinates with 3 and 4 decimals in the +/-100000 range and checks them
+// against the C library, for random values or exhaustively. The exhaustive check covers every float below
+// 131072 at 3 and 4 decimals and every string with 4 decimals in the +/-99999.9999 range, 5.6e9 checks.
+static bool kernel_convert (FILE *out, bool exhaustive)
+{
+    uint_fast16_t idx;
+    uint_fast32_t pass;
+    uint64_t t;
+    uint_fast8_t cc;
+    float value;
+    volatile uint32_t sink = 0;
+    kernel_result_t result = {0};
+
+    for(idx = 0; idx < KERNEL_SAMPLES; idx++) {
+        kernel_float[idx] = (float)((int32_t)(kernel_rand() % 2000000001UL) - 1000000000L) / 10000.0f;
+        kernel_decimals[idx] = 3 + (idx & 1);
+        snprintf(kernel_str[idx], sizeof(kernel_str[idx]), "%.4f", kernel_float[idx]);
+    }
+
+    t = now_ns();
+    for(pass = 0; pass < KERNEL_PASSES; pass++) {
+        for(idx = 0; idx < KERNEL_SAMPLES; idx++)
+            sink += (uint8_t)*ftoa(kernel_float[idx], kernel_decimals[idx]);
+    }
+    kernel_timing(out, "ftoa", (uint64_t)KERNEL_PASSES * KERNEL_SAMPLES, now_ns() - t);
+
+    t = now_ns();
+    for(pass = 0; pass < KERNEL_PASSES; pass++) {
+        for(idx = 0; idx < KERNEL_SAMPLES; idx++) {
+            cc = 0;
+            read_float(kernel_str[idx], &cc, &value);
+            sink += cc;
+        }
+    }
+    kernel_timing(out, "read_float", (uint64_t)KERNEL_PASSES * KERNEL_SAMPLES, now_ns() - t);
+
+    if(exhaustive) {
+
+        char s[24];
+        uint32_t bits;
+        int32_t n;
+
+        for(bits = 0; bits < 0x48000000UL; bits++) { // 0 to 131072.0f
+            memcpy(&value, &bits, sizeof(float));
+            check_ftoa(&result, out, value, 3);
+            check_ftoa(&result, out, value, 4);
+            check_ftoa(&result, out, -value, 3);
+        }
+
+        for(n = 0; n < 1000000000L; n++) {
+            snprintf(s, sizeof(s), "%ld.%04ld", (long)(n / 10000), (long)(n % 10000));
+            check_read_float(&result, out, s);
+            *s = '-';
+            snprintf(s + 1, sizeof(s) - 1, "%ld.%04ld", (long)(n / 10000), (long)(n % 10000));
+            check_read_float(&result, out, s);
+        }
+
+    } else for(idx = 0; idx < KERNEL_SAMPLES; idx++) {
+        check_ftoa(&result, out, kernel_float[idx], kernel_decimals[idx]);
+        check_read_float(&result, out, kernel_str[idx]);
+    }
+
+    // Values and strings outside the usual g-code range, up to 20 digits and 0 to 10 decimals.
+    for(pass = 0; pass < KERNEL_RANDOM; pass++) {
+
+        uint32_t bits = kernel_rand();
+
+        random_number_string(kernel_str[0]);
+        check_read_float(&result, out, kernel_str[0]);
+
+        memcpy(&value, &bits, sizeof(float));
+        if(isfinite(value) && fabsf(value) < 1.8e19f)
+            check_ftoa(&result, out, value, kernel_rand() % 11);
+    }
+
+    fprintf(out, "%llu checks, %llu errors\n", (unsigned long long)result.checks, (unsigned long long)result.errors);
+
+    return result.errors == 0;
+}
+
+// Times spindle_compute_pwm_value() for random RPM values in the 0 to 1050 RPM range with a 24000 count PWM period,
+// with the linear model and with two linearization pieces if enabled. When built with SPINDLE_PWM_TABLE_SIZE
+// the table lookup is timed and compared with the calculated value as well, for 100001 RPM values.
+static bool kernel_pwm_model (FILE *out, spindle_pwm_t *pwm_data, const char *model)
+{
+    uint_fast16_t idx;
+    uint_fast32_t pass;
+    uint64_t t;
+    volatile uint32_t sink = 0;
+    bool ok = true;
+
+    spindle_precompute_pwm_values(pwm_data, 120000000UL);
+
+    for(idx = 0; idx < KERNEL_SAMPLES; idx++)
+        kernel_float[idx] = 1050.0f * (float)(kernel_rand() % 1000001UL) / 1000000.0f;
+
+    t = now_ns();
+    for(pass = 0; pass < KERNEL_PASSES; pass++) {
+        for(idx = 0; idx < KERNEL_SAMPLES; idx++)
+            sink += spindle_compute_pwm_value(pwm_data, kernel_float[idx], false);
+    }
+    kernel_timing(out, model, (uint64_t)KERNEL_PASSES * KERNEL_SAMPLES, now_ns() - t);
+
+#ifdef SPINDLE_PWM_TABLE_SIZE
+
+    float table_scale = pwm_data->table_scale;
+    uint_fast16_t table_pwm, calc_pwm, max_error = 0;
+    uint32_t rpm;
+
+    // Table is bypassed when the scale is 0.
+    pwm_data->table_scale = 0.0f;
+
+    t = now_ns();
+    for(pass = 0; pass < KERNEL_PASSES; pass++) {
+        for(idx = 0; idx < KERNEL_SAMPLES; idx++)
+            sink += spindle_compute_pwm_value(pwm_data, kernel_float[idx], false);
+    }
+    kernel_timing(out, "  calculated", (uint64_t)KERNEL_PASSES * KERNEL_SAMPLES, now_ns() - t);
+
+    for(rpm = 0; rpm <= 100000; rpm++) {
+        pwm_data->table_scale = 0.0f;
+        calc_pwm = spindle_compute_pwm_value(pwm_data, (float)rpm * 0.0105f, false);
+        pwm_data->table_scale = table_scale;
+        table_pwm = spindle_compute_pwm_value(pwm_data, (float)rpm * 0.0105f, false);
+        if(table_pwm > calc_pwm ? table_pwm - calc_pwm > max_error : calc_pwm - table_pwm > max_error)
+            max_error = table_pwm > calc_pwm ? table_pwm - calc_pwm : calc_pwm - table_pwm;
+    }
+
+    fprintf(out, "  table error: %u PWM counts max\n", (unsigned int)max_error);
+
+    // Error is at most one count for the linear model, linearization pieces may add more in the intervals containing a piece boundary.
+    ok = pwm_data->n_pieces || max_error <= 1;
+
+#endif
+
+    return ok;
+}
+
+static bool kernel_pwm (FILE *out)
+{
+    static spindle_pwm_t pwm_data;
+    bool ok;
+
+    settings.spindle.rpm_min = 0.0f;
+    settings.spindle.rpm_max = 1000.0f;
+    settings.spindle.pwm_freq = 5000.0f;
+    settings.spindle.pwm_off_value = 0.0f;
+    settings.spindle.pwm_min_value = 0.0f;
+    settings.spindle.pwm_max_value = 100.0f;
+
+    memset(&pwm_data, 0, sizeof(spindle_pwm_t));
+    memset(settings.spindle.pwm_piece, 0, sizeof(settings.spindle.pwm_piece));
+
+    ok = kernel_pwm_model(out, &pwm_data, "linear");
+
+#ifdef ENABLE_SPINDLE_LINEARIZATION
+    settings.spindle.pwm_piece[0] = (pwm_piece_t){ .rpm = 300.0f, .start = 30.0f, .end = 0.0f };
+    settings.spindle.pwm_piece[1] = (pwm_piece_t){ .rpm = 600.0f, .start = 20.0f, .end = -6000.0f };
+
+    ok = kernel_pwm_model(out, &pwm_data, "linearized") && ok;
+#endif
+
+    return ok;
+}
+
+#if defined(WALL_PLOTTER) || defined(MASLOW_ROUTER)
+
+#define SEGMENT_SAMPLES 16      // Points per segment where the path error is evaluated
+#define SEGMENT_FIXED_LENGTH 2.0f // mm, length of the uniform segments used before mc_segment_line()
+
+typedef struct {
+    uint32_t segments;
+    uint64_t samples;
+    float max_error;
+    double sum_error;
+    uint64_t elapsed;
+} segment_result_t;
+
+#ifdef MASLOW_ROUTER
+static maslow_settings_t maslow_settings;
+
+static void maslow_settings_save (void)
+{
+}
+#endif
+
+// Distance of point p from the line from a to b in the XY plane.
+static float line_distance (float *p, float *a, float *b)
+{
+    float dx = b[X_AXIS] - a[X_AXIS], dy = b[Y_AXIS] - a[Y_AXIS];
+
+    return fabsf((p[X_AXIS] - a[X_AXIS]) * dy - (p[Y_AXIS] - a[Y_AXIS]) * dx) / sqrtf(dx * dx + dy * dy);
+}
+
+// Accumulates the deviation from the programmed line from a to b of the path traced by moving the motors
+// linearly from the positions for the segment start to the positions for the segment end, as the stepper does.
+static void segment_path_error (segment_result_t *result, float *start, float *end, float *a, float *b)
+{
+    uint_fast8_t idx, sample;
+    float joints_start[N_AXIS], joints_end[N_AXIS], joints[N_AXIS], point[N_AXIS], error;
+
+    kinematics.transform_from_cartesian(joints_start, start);
+    kinematics.transform_from_cartesian(joints_end, end);
+
+    for(sample = 1; sample < SEGMENT_SAMPLES; sample++) {
+        for(idx = 0; idx < N_AXIS; idx++)
+            joints[idx] = joints_start[idx] + (joints_end[idx] - joints_start[idx]) * (float)sample / (float)SEGMENT_SAMPLES;
+        kinematics.transform_to_cartesian(point, joints);
+        error = line_distance(point, a, b);
+        if(error > result->max_error)
+            result->max_error = error;
+        result->sum_error += error;
+        result->samples++;
+    }
+
+    result->segments++;
+}
+
+static void segment_report (FILE *out, const char *name, segment_result_t *result)
+{
+    fprintf(out, "%-18s %6u segments, path error max %.4f mean %.4f mm", name, (unsigned int)result->segments,
+                  result->max_error, result->sum_error / (double)result->samples);
+    if(result->elapsed)
+        fprintf(out, ", %.1f ns/segment", (double)result->elapsed / (double)result->segments);
+    fprintf(out, "\n");
+}
+
+// Segments the lines of a test path covering most of the work area by mc_segment_line() for a range
+// of arc tolerances ($12) and by uniform segments, and reports the number of segments (planner blocks),
+// the deviation of the traced path from the programmed lines and the time spent per segment.
+static bool kernel_segment (FILE *out)
+{
+    // Test path in fractions of the work area
+    static const float path[][2] = {
+        { 0.2f, 0.3f }, { 0.8f, 0.3f }, { 0.8f, 0.8f }, { 0.2f, 0.8f }, { 0.2f, 0.3f }, { 0.8f, 0.8f }, { 0.5f, 0.4f }
+    };
+    static const float tolerance[] = { 0.002f, 0.01f, 0.05f };
+
+    uint_fast8_t idx, line, pass;
+    uint_fast16_t segment, n_segments;
+    float origin[2], size[2], start[N_AXIS] = {0}, target[N_AXIS] = {0}, a[N_AXIS] = {0}, b[N_AXIS] = {0};
+    char name[24];
+    uint64_t t;
+    plan_line_data_t pl_data;
+    segment_result_t result;
+
+    for(idx = 0; idx < N_AXIS; idx++)
+        settings.steps_per_mm[idx] = 250.0f;
+
+#ifdef WALL_PLOTTER
+    settings.max_travel[X_AXIS] = -200.0f; // Machine width
+    wall_plotter_init();
+    origin[X_AXIS] = origin[Y_AXIS] = 0.0f;
+    size[X_AXIS] = size[Y_AXIS] = 200.0f;
+#else
+    maslow_hal.settings = &maslow_settings;
+    maslow_hal.settings_save = maslow_settings_save;
+    maslow_settings_restore();
+    maslow_init();
+    origin[X_AXIS] = -maslow_settings.machineWidth / 2.0f;
+    origin[Y_AXIS] = -maslow_settings.machineHeight / 2.0f;
+    size[X_AXIS] = maslow_settings.machineWidth;
+    size[Y_AXIS] = maslow_settings.machineHeight;
+#endif
+
+    for(pass = 0; pass <= sizeof(tolerance) / sizeof(float); pass++) {
+
+        memset(&result, 0, sizeof(segment_result_t));
+
+        for(line = 1; line < sizeof(path) / sizeof(path[0]); line++) {
+
+            for(idx = X_AXIS; idx <= Y_AXIS; idx++) {
+                a[idx] = origin[idx] + size[idx] * path[line - 1][idx];
+                b[idx] = origin[idx] + size[idx] * path[line][idx];
+            }
+
+            memcpy(start, a, sizeof(start));
+
+            if(pass < sizeof(tolerance) / sizeof(float)) {
+
+                // The planner position is the start of the line, as after the previous line has been planned.
+                kinematics.plan_target_to_steps(sys_position, a);
+                plan_sync_position();
+
+                settings.arc_tolerance = tolerance[pass];
+                memset(&pl_data, 0, sizeof(plan_line_data_t));
+                pl_data.feed_rate = 1000.0f;
+                memcpy(target, b, sizeof(target));
+
+                t = now_ns();
+                kinematics.segment_line(target, &pl_data, true);
+                while(kinematics.segment_line(target, &pl_data, false)) {
+                    result.elapsed += now_ns() - t;
+                    segment_path_error(&result, start, target, a, b);
+                    memcpy(start, target, sizeof(start));
+                    t = now_ns();
+                }
+                result.elapsed += now_ns() - t;
+
+            } else {
+
+                float length = hypotf(b[X_AXIS] - a[X_AXIS], b[Y_AXIS] - a[Y_AXIS]);
+
+                n_segments = (uint_fast16_t)ceilf(length / SEGMENT_FIXED_LENGTH);
+
+                for(segment = 1; segment <= n_segments; segment++) {
+                    target[X_AXIS] = a[X_AXIS] + (b[X_AXIS] - a[X_AXIS]) * (float)segment / (float)n_segments;
+                    target[Y_AXIS] = a[Y_AXIS] + (b[Y_AXIS] - a[Y_AXIS]) * (float)segment / (float)n_segments;
+                    segment_path_error(&result, start, target, a, b);
+                    memcpy(start, target, sizeof(start));
+                }
+            }
+        }
+
+        if(pass < sizeof(tolerance) / sizeof(float))
+            snprintf(name, sizeof(name), "$12=%g", tolerance[pass]);
+        else
+            snprintf(name, sizeof(name), "%g mm uniform", SEGMENT_FIXED_LENGTH);
+
+        segment_report(out, name, &result);
+    }
+
+    return true;
+}
+
+#endif
+
+int bench_kernel (const char *name, FILE *out)
+{
+    if(!strcmp(name, "convert"))
+        return kernel_convert(out, false) ? 0 : 1;
+
+    if(!strcmp(name, "convert-all"))
+        return kernel_convert(out, true) ? 0 : 1;
+
+    if(!strcmp(name, "pwm"))
+        return kernel_pwm(out) ? 0 : 1;
+
+#if defined(WALL_PLOTTER) || defined(MASLOW_ROUTER)
+    if(!strcmp(name, "segment"))
+        return kernel_segment(out) ? 0 : 1;
+#endif
+
+    fprintf(stderr, "Unknown kernel: %s\n", name);
+
+    return -1;
+}
+
+/*
+ * Linker interception of stage entry points, requires -Wl,--wrap=<function> for each.
+ */
+
+status_code_t __real_gc_execute_block (char *block, char *message);
+bool __real_protocol_execute_realtime (void);
+bool __real_mc_line (float *target, plan_line_data_t *pl_data);
+void __real_mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius, plane_t plane, bool is_clockwise_arc);
+bool __real_mc_arc_resume (bool complete);
+bool __real_plan_buffer_line (float *target, plan_line_data_t *pl_data);
+void __real_st_prep_buffer (void);
+void __real_stepper_driver_interrupt_handler (void);
+void __real_report_realtime_status (void);
+
+status_code_t __wrap_gc_execute_block (char *block, char *message)
+{
+    status_code_t status;
+
+    bench_enter(Stage_Parser);
+    status = __real_gc_execute_block(block, message);
+    bench_exit();
+
+    return status;
+}
+
+bool __wrap_protocol_execute_realtime (void)
+{
+    bool ok;
+
+    bench_enter(Stage_Realtime);
+    ok = __real_protocol_execute_realtime();
+    bench_exit();
+
+    return ok;
+}
+
+bool __wrap_mc_line (float *target, plan_line_data_t *pl_data)
+{
+    bool ok;
+
+    bench_enter(Stage_MotionControl);
+    ok = __real_mc_line(target, pl_data);
+    bench_exit();
+
+    return ok;
+}
+
+void __wrap_mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius, plane_t plane, bool is_clockwise_arc)
+{
+    bench_enter(Stage_Arc);
+    __real_mc_arc(target, pl_data, position, offset, radius, plane, is_clockwise_arc);
+    bench_exit();
+}
+
+bool __wrap_mc_arc_resume (bool complete)
+{
+    bool ok;
+
+    bench_enter(Stage_Arc);
+    ok = __real_mc_arc_resume(complete);
+    bench_exit();
+
+    return ok;
+}
+
+bool __wrap_plan_buffer_line (float *target, plan_line_data_t *pl_data)
+{
+    bool ok;
+
+    bench_enter(Stage_Planner);
+    ok = __real_plan_buffer_line(target, pl_data);
+    bench_exit();
+
+    return ok;
+}
+
+void __wrap_st_prep_buffer (void)
+{
+    bench_enter(Stage_SegmentPrep);
+    __real_st_prep_buffer();
+    bench_exit();
+}
+
+void __wrap_stepper_driver_interrupt_handler (void)
+{
+    bench_enter(Stage_StepperISR);
+#ifdef BENCH_CYCLES
+    uint64_t t = __rdtsc();
+    __real_stepper_driver_interrupt_handler();
+    t = __rdtsc() - t;
+    t = t > tsc_overhead ? t - tsc_overhead : 0;
+    isr_cycles += t;
+    isr_hist[t < BENCH_CYCLES_HIST ? t : BENCH_CYCLES_HIST - 1]++;
+    isr_calls++;
+#else
+    __real_stepper_driver_interrupt_handler();
+#endif
+    bench_exit();
+}
+
+void __wrap_report_realtime_status (void)
+{
+    uint64_t writes = sim_stats.writes;
+
+    bench_enter(Stage_Report);
+    __real_report_realtime_status();
+    bench_exit();
+
+    report_writes += sim_stats.writes - writes;
+}
+
+#endif
@@ -0,0 +1,59 @@
+/*
+  bench.h - per stage execution time measurement for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdio.h>
+
+typedef enum {
+    Stage_Protocol = 0,     // Foreground time not accounted for by any of the stages below
+    Stage_Parser,           // gc_execute_block()
+    Stage_Realtime,         // protocol_execute_realtime() when called from outside protocol.c, e.g. waiting for planner space
+    Stage_MotionControl,    // mc_line()
+    Stage_Arc,              // mc_arc() and mc_arc_resume(), called once per main loop pass
+    Stage_Planner,          // plan_buffer_line()
+    Stage_SegmentPrep,      // st_prep_buffer()
+    Stage_StepperISR,       // stepper_driver_interrupt_handler()
+    Stage_Report,           // report_realtime_status(), including output
+    Stage_Simulator,        // Simulated time keeping and input delivery
+    Stage_N
+} bench_stage_t;
+
+#ifdef BENCHMARK
+
+void bench_start (void);
+void bench_enter (bench_stage_t stage);
+void bench_exit (void);
+void bench_report (FILE *out);
+int bench_kernel (const char *name, FILE *out);
+
+#else
+
+#define bench_start()
+#define bench_enter(stage)
+#define bench_exit()
+#define bench_report(out)
+#define bench_kernel(name, out) -1
+
+#endif
+
+#endif
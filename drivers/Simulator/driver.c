@@ -0,0 +1,411 @@
+/*
+  driver.c - driver code for the host simulator
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "driver.h"
+#include "serial.h"
+#include "flash.h"
+
+#ifdef MASLOW_ROUTER
+#include "grbl/maslow.h"
+
+static maslow_settings_t maslow_settings; // Kept in RAM only, the simulator has no driver settings storage
+
+static void maslow_settings_save (void)
+{
+}
+#endif
+
+static bool pwmEnabled = false, IOInitDone = false, exitRequested = false;
+static uint_fast16_t pwm_value = 0;
+static axes_signals_t dir_outbits = {0}, enable_outbits = {0};
+static spindle_state_t spindle_state = {0};
+static coolant_state_t coolant_state = {0};
+static spindle_pwm_t spindle_pwm;
+static delay_t delay = { .ms = 0, .callback = NULL };
+
+static void stepper_driver_isr (void);
+static void systick_isr (void);
+
+// Millisecond resolution delay function
+// Will return immediately if a callback function is provided
+static void driver_delay_ms (uint32_t ms, void (*callback)(void))
+{
+    if(ms) {
+        delay.ms = ms;
+        sim_systick_start(systick_isr);
+        if(!(delay.callback = callback)) {
+            while(delay.ms)
+                sim_yield();
+        }
+    } else {
+        if(delay.ms) {
+            delay.callback = NULL;
+            delay.ms = 1;
+        }
+        if(callback)
+            callback();
+    }
+}
+
+// Enable steppers.
+static void stepperEnable (axes_signals_t enable)
+{
+    enable_outbits = enable;
+}
+
+// Starts stepper driver timer and forces a stepper driver interrupt callback.
+static void stepperWakeUp (void)
+{
+    stepperEnable((axes_signals_t){AXES_BITMASK});
+
+    sim_stepper_start(SIM_WAKEUP_CYCLES);
+}
+
+// Disables stepper driver interrupts and reset outputs.
+static void stepperGoIdle (bool clear_signals)
+{
+    sim_stepper_stop();
+
+    // Segment buffer ran dry while the planner still holds blocks, the foreground did not keep up.
+    if(sys.state == STATE_CYCLE && plan_get_current_block() != NULL)
+        sim_stats.starved++;
+
+    if(clear_signals)
+        dir_outbits.value = 0;
+}
+
+// Sets up stepper driver interrupt timeout.
+// Called at the start of each segment.
+static void stepperCyclesPerTick (uint32_t cycles_per_tick)
+{
+    sim_stepper_set_period(cycles_per_tick);
+}
+
+// Start a stepper pulse, step pulses are logged with the current simulated time.
+static void stepperPulseStart (stepper_t *stepper)
+{
+    if(stepper->new_block) {
+        stepper->new_block = false;
+        dir_outbits = stepper->dir_outbits;
+    }
+
+    if(stepper->step_outbits.value)
+        sim_log_step(stepper->step_outbits, dir_outbits);
+}
+
+// Enable/disable limit pins interrupt.
+static void limitsEnable (bool on, bool homing)
+{
+}
+
+// Returns limit state as an axes_signals_t bitmap variable.
+// NOTE: limit switches are not simulated, the homing cycle polls this function and simulated time
+//       has to advance while it does.
+static axes_signals_t limitsGetState (void)
+{
+    axes_signals_t signals = {0};
+
+    sim_yield();
+
+    return signals;
+}
+
+// Returns system state as a control_signals_t bitmap variable.
+static control_signals_t systemGetState (void)
+{
+    control_signals_t signals = {0};
+
+    return signals;
+}
+
+// Probe input is not simulated.
+static void probeConfigure (bool is_probe_away)
+{
+}
+
+// Returns the probe pin state. Triggered = true.
+static bool probeGetState (void)
+{
+    return false;
+}
+
+// Start or stop spindle.
+static void spindleSetState (spindle_state_t state, float rpm)
+{
+    spindle_state.on = state.on;
+    spindle_state.ccw = state.on && state.ccw;
+}
+
+// Variable spindle control functions
+
+// Set spindle speed, PWM changes are logged.
+static void spindle_set_speed (uint_fast16_t pwm)
+{
+    pwmEnabled = pwm != spindle_pwm.off_value;
+
+    if(pwmEnabled)
+        spindle_state.on = On;
+    else if(settings.spindle.disable_with_zero_speed)
+        spindle_state.on = Off;
+
+    if(pwm != pwm_value)
+        sim_log_pwm(pwm_value = pwm);
+}
+
+#ifdef SPINDLE_PWM_DIRECT
+
+// Convert spindle speed to PWM value.
+static uint_fast16_t spindleGetPWM (float rpm)
+{
+    return spindle_compute_pwm_value(&spindle_pwm, rpm, false);
+}
+
+#else
+
+// Update spindle speed.
+static void spindleUpdateRPM (float rpm)
+{
+    spindle_set_speed(spindle_compute_pwm_value(&spindle_pwm, rpm, false));
+}
+
+#endif
+
+// Start or stop spindle.
+static void spindleSetStateVariable (spindle_state_t state, float rpm)
+{
+    if (!state.on || rpm == 0.0f) {
+        spindle_set_speed(spindle_pwm.off_value);
+        spindle_state.on = Off;
+    } else {
+        spindle_state.ccw = state.ccw;
+        spindle_set_speed(spindle_compute_pwm_value(&spindle_pwm, rpm, false));
+    }
+}
+
+// Returns spindle state in a spindle_state_t variable.
+static spindle_state_t spindleGetState (void)
+{
+    spindle_state_t state = spindle_state;
+
+    state.on |= pwmEnabled;
+
+    return state;
+}
+
+// end spindle code
+
+// Start/stop coolant (and mist if enabled).
+static void coolantSetState (coolant_state_t mode)
+{
+    coolant_state = mode;
+}
+
+// Returns coolant state in a coolant_state_t variable.
+static coolant_state_t coolantGetState (void)
+{
+    return coolant_state;
+}
+
+// Helper functions for setting/clearing/inverting individual bits atomically (uninterruptable)
+// NOTE: interrupts are only dispatched at foreground yield points, no locking needed.
+static void bitsSetAtomic (volatile uint_fast16_t *ptr, uint_fast16_t bits)
+{
+    *ptr |= bits;
+}
+
+static uint_fast16_t bitsClearAtomic (volatile uint_fast16_t *ptr, uint_fast16_t bits)
+{
+    uint_fast16_t prev = *ptr;
+    *ptr &= ~bits;
+    return prev;
+}
+
+static uint_fast16_t valueSetAtomic (volatile uint_fast16_t *ptr, uint_fast16_t value)
+{
+    uint_fast16_t prev = *ptr;
+    *ptr = value;
+    return prev;
+}
+
+// Called from protocol_exec_rt_system() on each pass of the foreground, this is where simulated time
+// advances while the core is busy. Requests exit when all input is executed and motion is complete.
+static void execute_realtime (uint_fast16_t state)
+{
+    sim_yield();
+
+    if(!exitRequested && serialInputExhausted()) {
+        if(state == STATE_ESTOP || (!(state & ~(STATE_ALARM|STATE_CHECK_MODE|STATE_SLEEP)) && plan_get_current_block() == NULL)) {
+            exitRequested = true;
+            hal.stream.enqueue_realtime_command(CMD_EXIT);
+        }
+    }
+}
+
+// Returning false terminates grbl_enter().
+static bool driver_release (void)
+{
+    return false;
+}
+
+// Configures perhipherals when settings are initialized or changed
+static void settings_changed (settings_t *settings)
+{
+    hal.driver_cap.variable_spindle = spindle_precompute_pwm_values(&spindle_pwm, hal.f_step_timer);
+
+    if(IOInitDone) {
+
+        stepperEnable(settings->steppers.deenergize);
+
+        if(hal.driver_cap.variable_spindle)
+            hal.spindle_set_state = spindleSetStateVariable;
+        else
+            hal.spindle_set_state = spindleSetState;
+    }
+}
+
+// Initializes simulated peripherals for Grbl use
+static bool driver_setup (settings_t *settings)
+{
+    sim_stepper_attach_isr(stepper_driver_isr);
+
+    IOInitDone = settings->version == 16;
+
+    settings_changed(settings);
+
+    hal.stepper_go_idle(true);
+    hal.spindle_set_state((spindle_state_t){0}, 0.0f);
+    hal.coolant_set_state((coolant_state_t){0});
+
+#ifdef MASLOW_ROUTER
+    maslow_hal.settings = &maslow_settings;
+    maslow_hal.settings_save = maslow_settings_save;
+    maslow_settings_restore();
+    maslow_init();
+#endif
+
+    return IOInitDone;
+}
+
+// Initialize HAL pointers, setup serial comms and enable EEPROM.
+// NOTE: Grbl is not yet configured (from EEPROM data), driver_setup() will be called when done.
+bool driver_init (void)
+{
+    sim_init();
+    serialInit();
+
+    hal.info = "Simulator";
+    hal.driver_version = "200315";
+    hal.driver_setup = driver_setup;
+    hal.f_step_timer = sim_config.f_step_timer;
+    hal.rx_buffer_size = RX_BUFFER_SIZE;
+    hal.delay_ms = driver_delay_ms;
+    hal.settings_changed = settings_changed;
+
+    hal.stepper_wake_up = stepperWakeUp;
+    hal.stepper_go_idle = stepperGoIdle;
+    hal.stepper_enable = stepperEnable;
+    hal.stepper_cycles_per_tick = stepperCyclesPerTick;
+    hal.stepper_pulse_start = stepperPulseStart;
+
+    hal.limits_enable = limitsEnable;
+    hal.limits_get_state = limitsGetState;
+
+    hal.coolant_set_state = coolantSetState;
+    hal.coolant_get_state = coolantGetState;
+
+    hal.probe_get_state = probeGetState;
+    hal.probe_configure_invert_mask = probeConfigure;
+
+    hal.spindle_set_state = spindleSetState;
+    hal.spindle_get_state = spindleGetState;
+#ifdef SPINDLE_PWM_DIRECT
+    hal.spindle_get_pwm = spindleGetPWM;
+    hal.spindle_update_pwm = spindle_set_speed;
+#else
+    hal.spindle_update_rpm = spindleUpdateRPM;
+#endif
+
+    hal.system_control_get_state = systemGetState;
+
+    hal.stream.read = serialGetC;
+    hal.stream.read_span = serialReadSpan;
+    hal.stream.write = serialWriteS;
+    hal.stream.write_all = serialWriteS;
+    hal.stream.get_rx_buffer_available = serialRxFree;
+    hal.stream.reset_read_buffer = serialRxFlush;
+    hal.stream.cancel_read_buffer = serialRxCancel;
+    hal.stream.suspend_read = serialSuspendInput;
+
+    hal.execute_realtime = execute_realtime;
+    hal.driver_release = driver_release;
+
+    if(sim_config.eeprom_file) {
+        hal.eeprom.type = EEPROM_Emulated;
+        if(sim_config.flash_sectors) {
+            if(flash_log_init()) {
+                hal.eeprom.flash_log.sectors = sim_config.flash_sectors;
+                hal.eeprom.flash_log.sector_size = sim_config.flash_sector_size;
+                hal.eeprom.flash_log.erase = flash_log_erase;
+                hal.eeprom.flash_log.write = flash_log_write;
+                hal.eeprom.flash_log.read = flash_log_read;
+            }
+        } else {
+            hal.eeprom.memcpy_from_flash = memcpy_from_flash;
+            hal.eeprom.memcpy_to_flash = memcpy_to_flash;
+        }
+    } else
+        hal.eeprom.type = EEPROM_None;
+
+    hal.set_bits_atomic = bitsSetAtomic;
+    hal.clear_bits_atomic = bitsClearAtomic;
+    hal.set_value_atomic = valueSetAtomic;
+
+  // Driver capabilities, used for announcing and negotiating (with Grbl) driver functionality.
+
+    hal.driver_cap.spindle_dir = On;
+    hal.driver_cap.variable_spindle = On;
+    hal.driver_cap.spindle_pwm_linearization = On;
+    hal.driver_cap.mist_control = On;
+    hal.driver_cap.amass_level = 3;
+
+    return hal.version == 6;
+}
+
+/* interrupt handlers */
+
+// Main stepper driver.
+static void stepper_driver_isr (void)
+{
+    sim_stats.isr_count++;
+    hal.stepper_interrupt_callback();
+}
+
+// Interrupt handler for 1 ms interval timer
+static void systick_isr (void)
+{
+    if(delay.ms && !(--delay.ms)) {
+        sim_systick_stop();
+        if(delay.callback) {
+            delay.callback();
+            delay.callback = NULL;
+        }
+    }
+}
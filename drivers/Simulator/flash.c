@@ -0,0 +1,162 @@
+/*
+  flash.c - file backed "flash" storage of settings for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "grbl/grbl.h"
+
+#include "flash.h"
+#include "simulator.h"
+
+bool memcpy_from_flash (uint8_t *dest)
+{
+    bool ok;
+    FILE *file;
+
+    if((ok = (file = fopen(sim_config.eeprom_file, "rb")) != NULL)) {
+        ok = fread(dest, 1, hal.eeprom.size, file) == hal.eeprom.size;
+        fclose(file);
+    }
+
+    return ok;
+}
+
+bool memcpy_to_flash (uint8_t *source)
+{
+    bool ok;
+    FILE *file;
+
+    if((ok = (file = fopen(sim_config.eeprom_file, "wb")) != NULL)) {
+        ok = fwrite(source, 1, hal.eeprom.size, file) == hal.eeprom.size;
+        fclose(file);
+    }
+
+    return ok;
+}
+
+//
+// Sector based flash storage for the log structured settings store, with NOR flash semantics:
+// erase sets all bytes of a sector to 0xFF and only erased bytes may be written.
+//
+
+static FILE *flash_file = NULL;
+static uint8_t *flash = NULL;
+static uint32_t *erases = NULL;
+
+bool flash_log_init (void)
+{
+    uint32_t size = sim_config.flash_sectors * sim_config.flash_sector_size;
+
+    if((flash = malloc(size)) == NULL || (erases = calloc(sim_config.flash_sectors, sizeof(uint32_t))) == NULL)
+        return false;
+
+    memset(flash, 0xFF, size);
+
+    if((flash_file = fopen(sim_config.eeprom_file, "r+b")) != NULL)
+        fread(flash, 1, size, flash_file); // Sectors not yet written to file are erased
+    else if((flash_file = fopen(sim_config.eeprom_file, "w+b")) == NULL)
+        return false;
+
+    return true;
+}
+
+static bool flash_log_sync (uint32_t address, uint32_t size)
+{
+    return fseek(flash_file, address, SEEK_SET) == 0 && fwrite(flash + address, 1, size, flash_file) == size && fflush(flash_file) == 0;
+}
+
+// Simulates power loss when the byte count set by -p is reached by an erase (source NULL) or write.
+// Bytes before the cut are erased or written, a byte being written has only its upper bits programmed.
+// Flash content is then saved and the simulator exits with code 3.
+static void flash_power_loss (uint32_t address, uint32_t size, uint8_t *source)
+{
+    if(sim_config.flash_power_loss < 0)
+        return;
+
+    if((uint32_t)sim_config.flash_power_loss >= size) {
+        sim_config.flash_power_loss -= size;
+        return;
+    }
+
+    if(source) {
+        memcpy(flash + address, source, sim_config.flash_power_loss);
+        flash[address + sim_config.flash_power_loss] &= source[sim_config.flash_power_loss] | 0x0F;
+    } else
+        memset(flash + address, 0xFF, sim_config.flash_power_loss);
+
+    flash_log_sync(0, sim_config.flash_sectors * sim_config.flash_sector_size);
+    fclose(flash_file);
+    fflush(stdout);
+
+    exit(3);
+}
+
+bool flash_log_erase (uint_fast8_t sector)
+{
+    uint_fast8_t idx;
+
+    if(sector >= sim_config.flash_sectors)
+        return false;
+
+    flash_power_loss(sector * sim_config.flash_sector_size, sim_config.flash_sector_size, NULL);
+
+    memset(flash + sector * sim_config.flash_sector_size, 0xFF, sim_config.flash_sector_size);
+
+    erases[sector]++;
+    sim_stats.flash_erases++;
+    sim_stats.flash_erases_max = max(sim_stats.flash_erases_max, erases[sector]);
+    sim_stats.flash_erases_min = erases[0];
+    for(idx = 1; idx < sim_config.flash_sectors; idx++)
+        sim_stats.flash_erases_min = min(sim_stats.flash_erases_min, erases[idx]);
+
+    return flash_log_sync(sector * sim_config.flash_sector_size, sim_config.flash_sector_size);
+}
+
+bool flash_log_write (uint_fast8_t sector, uint32_t offset, uint8_t *source, uint32_t size)
+{
+    uint32_t idx, address = sector * sim_config.flash_sector_size + offset;
+
+    if(sector >= sim_config.flash_sectors || (offset & 0x07) || (size & 0x07) || offset + size > sim_config.flash_sector_size)
+        return false;
+
+    for(idx = 0; idx < size; idx++) {
+        if(flash[address + idx] != 0xFF)
+            return false;
+    }
+
+    flash_power_loss(address, size, source);
+
+    memcpy(flash + address, source, size);
+    sim_stats.flash_written += size;
+
+    return flash_log_sync(address, size);
+}
+
+bool flash_log_read (uint_fast8_t sector, uint32_t offset, uint8_t *dest, uint32_t size)
+{
+    if(sector >= sim_config.flash_sectors || offset + size > sim_config.flash_sector_size)
+        return false;
+
+    memcpy(dest, flash + sector * sim_config.flash_sector_size + offset, size);
+
+    return true;
+}
@@ -0,0 +1,32 @@
+/*
+  flash.h - file backed "flash" storage of settings for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _FLASH_H_
+#define _FLASH_H_
+
+bool memcpy_from_flash (uint8_t *dest);
+bool memcpy_to_flash (uint8_t *source);
+bool flash_log_init (void);
+bool flash_log_erase (uint_fast8_t sector);
+bool flash_log_write (uint_fast8_t sector, uint32_t offset, uint8_t *source, uint32_t size);
+bool flash_log_read (uint_fast8_t sector, uint32_t offset, uint8_t *dest, uint32_t size);
+
+#endif
@@ -0,0 +1,114 @@
+#!/usr/bin/env python3
+#
+# flash_powerloss.py - power loss test of the log structured settings store, run with the host simulator
+#
+# Part of GrblHAL
+#
+# Each trial writes a base set of coordinate system offsets and settings to a fresh flash file, then runs a
+# second batch of changes with power lost after a random number of bytes erased or written (grblsim -p).
+# The settings read back must match the base values with some prefix of the second batch applied, and a
+# third batch written after the restart must be stored on top of them. A settings reset (error 7) counts
+# as a failure as well.
+#
+# Usage: flash_powerloss.py [-s <simulator>] [-f <flash file>] [-n <trials>] [-r <seed>] [<sectors>[x<sector size>]]
+#
+
+import argparse
+import os
+import random
+import re
+import subprocess
+import sys
+
+NAMES = ['G54', 'G55', 'G56', 'G57', 'G58', 'G59', '$110', '$120']
+
+def changes (start, count):
+    return [(NAMES[idx % len(NAMES)], round(100.0 + idx * 0.001, 3)) for idx in range(start, start + count)]
+
+def command (change):
+    name, value = change
+    if name.startswith('G'):
+        return 'G10 L2 P%d X%.3f\n' % (NAMES.index(name) + 1, value)
+    return '%s=%.3f\n' % (name, value)
+
+def apply (state, batch):
+    state = dict(state)
+    for name, value in batch:
+        state[name] = value
+    return state
+
+def matches (a, b):
+    return len(a) == len(NAMES) and all(abs(a[name] - b[name]) < 1e-9 for name in NAMES)
+
+class Simulator:
+
+    def __init__ (self, args):
+        self.args = args
+
+    def run (self, lines, power_loss = None):
+        cmd = [self.args.sim, '-e', self.args.file, '-l', self.args.geometry]
+        if power_loss is not None:
+            cmd += ['-p', str(power_loss)]
+        return subprocess.run(cmd, input = ''.join(lines), capture_output = True, text = True)
+
+    def write (self, batch, power_loss = None):
+        return self.run([command(change) for change in batch], power_loss)
+
+    def read (self):
+        out = self.run(['$#\n', '$$\n']).stdout
+        state = {name: float(value) for name, value in re.findall(r'\[(G5[4-9]):([-\d.]+)', out)}
+        for name, value in re.findall(r'^(\$1[12]0)=([-\d.]+)', out, re.M):
+            state[name] = float(value)
+        return state, 'error:7' in out
+
+def main ():
+    parser = argparse.ArgumentParser(description = 'Power loss test of the flash log settings store.')
+    parser.add_argument('geometry', nargs = '?', default = '4', help = 'flash sectors[xsector size], as for grblsim -l')
+    parser.add_argument('-s', dest = 'sim', default = './grblsim', help = 'simulator executable')
+    parser.add_argument('-f', dest = 'file', default = 'powerloss.bin', help = 'flash file, deleted before each trial')
+    parser.add_argument('-n', dest = 'trials', type = int, default = 100, help = 'number of trials')
+    parser.add_argument('-r', dest = 'seed', type = int, default = 1, help = 'random seed')
+    args = parser.parse_args()
+
+    random.seed(args.seed)
+    sim = Simulator(args)
+    failed = cut = 0
+
+    base, batch, more = changes(1, 100), changes(101, 200), changes(301, 40)
+    start = apply({}, base)
+    prefixes = [apply(start, batch[:count]) for count in range(len(batch) + 1)]
+
+    if os.path.exists(args.file):
+        os.remove(args.file)
+    sim.write(base)
+    if not matches(sim.read()[0], start):
+        print('%s: settings are not stored, check that the flash geometry can hold the log' % args.geometry)
+        return 1
+
+    for trial in range(args.trials):
+
+        if os.path.exists(args.file):
+            os.remove(args.file)
+
+        sim.write(base)
+        power_loss = random.randint(0, len(batch) * 80)
+        if sim.write(batch, power_loss).returncode == 3:
+            cut += 1
+
+        state, reset = sim.read()
+        ok = not reset and any(matches(state, prefix) for prefix in prefixes)
+
+        sim.write(more)
+        after, reset = sim.read()
+        ok = ok and not reset and matches(after, apply(state, more))
+
+        if not ok:
+            failed += 1
+            print('FAIL trial %d power loss %d: %s -> %s' % (trial, power_loss, state, after))
+
+    print('%s: %d trials, %d with power loss, %d failed' % (args.geometry, args.trials, cut, failed))
+
+    return 1 if failed else 0
+
+if __name__ == '__main__':
+    sys.exit(main())
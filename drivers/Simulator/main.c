@@ -0,0 +1,126 @@
+/*
+  main.c - An embedded CNC Controller with rs274/ngc (g-code) support
+
+  Startup entry point for the host simulator
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "grbl/grbllib.h"
+#include "driver.h"
+#include "bench.h"
+
+static void usage (char *name)
+{
+    fprintf(stderr, "Usage: %s [-f step timer Hz] [-q foreground us/poll] [-b baud] [-o step log] [-e settings file] [-l flash sectors[xsector size]] [-p power loss bytes] [-k kernel] [gcode file]\n", name);
+    fprintf(stderr, "G-code is read from stdin if no file is given, controller output is written to stdout.\n");
+}
+
+int main (int argc, char **argv)
+{
+    int opt;
+    char *kernel = NULL;
+
+    while((opt = getopt(argc, argv, "f:q:b:o:e:l:p:k:h")) != -1) switch(opt) {
+
+        case 'f':
+            sim_config.f_step_timer = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+
+        case 'q':
+            sim_config.fg_quantum_us = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+
+        case 'b':
+            sim_config.baud_rate = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+
+        case 'o':
+            if((sim_config.step_log = fopen(optarg, "w")) == NULL) {
+                perror(optarg);
+                return 1;
+            }
+            break;
+
+        case 'e':
+            sim_config.eeprom_file = optarg;
+            break;
+
+        case 'l':
+            {
+                char *size;
+                sim_config.flash_sectors = (uint_fast8_t)strtoul(optarg, &size, 10);
+                if(*size == 'x')
+                    sim_config.flash_sector_size = (uint32_t)strtoul(size + 1, NULL, 10);
+            }
+            break;
+
+        case 'p':
+            sim_config.flash_power_loss = (int32_t)strtol(optarg, NULL, 10);
+            break;
+
+        case 'k':
+            kernel = optarg;
+            break;
+
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 1;
+    }
+
+    if(sim_config.f_step_timer < 1000 || (sim_config.flash_sectors && (sim_config.eeprom_file == NULL || sim_config.flash_sector_size < 64 || (sim_config.flash_sector_size & 0x07))) ||
+        (sim_config.flash_power_loss >= 0 && sim_config.flash_sectors == 0)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if(kernel) {
+        if((opt = bench_kernel(kernel, stdout)) < 0)
+            usage(argv[0]);
+        return opt < 0 ? 1 : opt;
+    }
+
+    if(optind < argc) {
+        if((sim_config.input = fopen(argv[optind], "r")) == NULL) {
+            perror(argv[optind]);
+            return 1;
+        }
+    } else
+        sim_config.input = stdin;
+
+    bench_start();
+
+    grbl_enter();
+
+    fflush(stdout);
+
+    sim_report(stderr);
+    bench_report(stderr);
+
+    if(sim_config.step_log)
+        fclose(sim_config.step_log);
+
+    if(sim_config.input != stdin)
+        fclose(sim_config.input);
+
+    return 0;
+}
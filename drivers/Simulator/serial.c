@@ -0,0 +1,188 @@
+/*
+  serial.c - simulated serial port for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// Input is read from the configured file as if sent by a streaming sender using hardware handshake:
+// characters "arrive" at the configured baud rate (or immediately if 0) as long as there is room in the
+// input buffer. Realtime commands are picked off on arrival, as done by the MCU drivers UART interrupt.
+// Output goes to stdout.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "serial.h"
+#include "simulator.h"
+
+static stream_rx_buffer_t rxbuffer = {0}, rxbackup;
+static uint64_t next_arrival = 0;
+static bool input_eof = false, last_eol = true, drained = false;
+
+void serialInit (void)
+{
+    memset(&rxbuffer, 0, sizeof(stream_rx_buffer_t));
+    next_arrival = 0;
+    input_eof = sim_config.input == NULL;
+    last_eol = true;
+    drained = false;
+}
+
+// Fetches next character from input file, adds a final end of line if missing.
+static int16_t input_getc (void)
+{
+    int c = input_eof ? EOF : fgetc(sim_config.input);
+
+    if(c == EOF) {
+        input_eof = true;
+        if(!last_eol) {
+            last_eol = true;
+            c = ASCII_LF;
+        }
+    } else
+        last_eol = c == ASCII_LF || c == ASCII_CR;
+
+    return c == EOF ? SERIAL_NO_DATA : (int16_t)c;
+}
+
+// Simulated UART receive interrupt, called whenever simulated time advances.
+void serialPoll (uint64_t ticks, uint32_t f_clock)
+{
+    int16_t c;
+    uint_fast16_t bptr;
+    uint64_t char_time = sim_config.baud_rate ? (uint64_t)f_clock * 10 / sim_config.baud_rate : 0;
+
+    while(!input_eof && next_arrival <= ticks) {
+
+        bptr = (rxbuffer.head + 1) & (RX_BUFFER_SIZE - 1);  // Get next head pointer
+
+        if(bptr == rxbuffer.tail)                           // If buffer full sender has to wait (handshake)
+            break;
+
+        if((c = input_getc()) == SERIAL_NO_DATA)
+            break;
+
+        if(c == CMD_TOOL_ACK && !rxbuffer.backup) {
+            memcpy(&rxbackup, &rxbuffer, sizeof(stream_rx_buffer_t));
+            rxbuffer.backup = true;
+            rxbuffer.tail = rxbuffer.head;
+            hal.stream.read = serialGetC; // restore normal input
+            hal.stream.read_span = serialReadSpan;
+        } else if(!hal.stream.enqueue_realtime_command((char)c)) {
+            rxbuffer.data[rxbuffer.head] = (char)c;         // Add data to buffer
+            rxbuffer.head = bptr;                           // and update pointer
+        }
+
+        next_arrival = (next_arrival > ticks ? next_arrival : ticks) + char_time;
+    }
+}
+
+// Returns true when all input has been read and executed by the core.
+bool serialInputExhausted (void)
+{
+    return drained;
+}
+
+//
+// serialGetC - returns -1 if no data available
+//
+int16_t serialGetC (void)
+{
+    int16_t data;
+    uint_fast16_t bptr = rxbuffer.tail;
+
+    if(bptr == rxbuffer.head) {
+        drained = input_eof;    // Core is polling for more input after executing the last line
+        return SERIAL_NO_DATA;  // no data available
+    }
+
+    data = rxbuffer.data[bptr++];                   // Get next character, increment tmp pointer
+    rxbuffer.tail = bptr & (RX_BUFFER_SIZE - 1);    // and update pointer
+
+    return data;
+}
+
+//
+// serialReadSpan - copies input up to and including the first end of line character, returns 0 if no data available
+//
+uint16_t serialReadSpan (char *buf, uint16_t max)
+{
+    char c;
+    uint16_t count = 0;
+    uint_fast16_t bptr = rxbuffer.tail, head = rxbuffer.head;
+
+    while(count < max && bptr != head) {
+        buf[count++] = c = rxbuffer.data[bptr];
+        bptr = (bptr + 1) & (RX_BUFFER_SIZE - 1);
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    if(count)
+        rxbuffer.tail = bptr;   // Consume input
+    else
+        drained = input_eof;    // Core is polling for more input after executing the last line
+
+    return count;
+}
+
+uint16_t serialRxFree (void)
+{
+    uint_fast16_t head = rxbuffer.head, tail = rxbuffer.tail;
+
+    return (RX_BUFFER_SIZE - 1) - BUFCOUNT(head, tail, RX_BUFFER_SIZE);
+}
+
+void serialRxFlush (void)
+{
+    rxbuffer.tail = rxbuffer.head;
+    rxbuffer.overflow = false;
+}
+
+void serialRxCancel (void)
+{
+    serialRxFlush();
+    rxbuffer.data[rxbuffer.head] = ASCII_CAN;
+    rxbuffer.head = (rxbuffer.tail + 1) & (RX_BUFFER_SIZE - 1);
+}
+
+void serialWriteS (const char *data)
+{
+    sim_stats.writes++;
+    fputs(data, stdout);
+}
+
+// "dummy" version of serialGetC
+static int16_t serialGetNull (void)
+{
+    return SERIAL_NO_DATA;
+}
+
+bool serialSuspendInput (bool suspend)
+{
+    if(suspend) {
+        hal.stream.read = serialGetNull;
+        hal.stream.read_span = NULL;
+    }
+    else if(rxbuffer.backup)
+        memcpy(&rxbuffer, &rxbackup, sizeof(stream_rx_buffer_t));
+
+    return rxbuffer.tail != rxbuffer.head;
+}
@@ -0,0 +1,41 @@
+/*
+  serial.h - simulated serial port for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SERIAL_H_
+#define _SERIAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "grbl/grbl.h"
+
+void serialInit (void);
+void serialPoll (uint64_t ticks, uint32_t f_clock);
+bool serialInputExhausted (void);
+int16_t serialGetC (void);
+uint16_t serialReadSpan (char *buf, uint16_t max);
+void serialWriteS (const char *data);
+bool serialSuspendInput (bool suspend);
+uint16_t serialRxFree (void);
+void serialRxFlush (void);
+void serialRxCancel (void);
+
+#endif
@@ -0,0 +1,222 @@
+/*
+  simulator.c - simulated time base and event scheduler for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// The simulator runs the core in lockstep with a virtual MCU: time only advances when the foreground
+// yields (polls for realtime events, waits in a delay or for input), and "interrupts" are dispatched at
+// their exact scheduled times from these yield points. Interrupt code thus always runs to completion
+// before the foreground resumes, exactly as on a single core MCU, and every run is reproducible.
+//
+// Step pulses are logged with their timestamps in stepper timer cycles, the log can be diffed
+// between builds to verify that a change does not alter the generated motion.
+//
+
+#include <string.h>
+
+#include "simulator.h"
+#include "serial.h"
+#include "bench.h"
+
+#define TIMER_OFF UINT64_MAX
+
+typedef struct {
+    uint64_t next;          // Time of next interrupt, TIMER_OFF if disabled
+    uint32_t period;
+    void (*isr)(void);
+} sim_timer_t;
+
+sim_config_t sim_config = {
+    .f_step_timer = SIM_F_STEP_TIMER,
+    .fg_quantum_us = SIM_FG_QUANTUM_US,
+    .flash_sector_size = SIM_FLASH_SECTOR_SIZE,
+    .flash_power_loss = -1
+};
+
+sim_stats_t sim_stats;
+
+static bool in_isr = false;
+static uint64_t fg_quantum;
+static sim_timer_t stepper_timer = { .next = TIMER_OFF }, systick_timer = { .next = TIMER_OFF };
+
+void sim_init (void)
+{
+    memset(&sim_stats, 0, sizeof(sim_stats_t));
+    memset(sim_stats.min_interval, 0xFF, sizeof(sim_stats.min_interval));
+
+    if((fg_quantum = (uint64_t)sim_config.f_step_timer * sim_config.fg_quantum_us / 1000000UL) == 0)
+        fg_quantum = 1;
+
+    if(sim_config.step_log)
+        fprintf(sim_config.step_log, "# f_step_timer=%u\n# S,ticks,step_mask,dir_mask,motor positions\n# P,ticks,pwm\n", sim_config.f_step_timer);
+}
+
+// Dispatch interrupt handler, no nesting of interrupts.
+static inline void sim_fire (sim_timer_t *timer)
+{
+    uint64_t now = timer->next;
+
+    in_isr = true;
+    timer->isr();
+    in_isr = false;
+
+    // Reload timer unless disabled or restarted by the handler.
+    if(timer->next == now)
+        timer->next = now + timer->period;
+}
+
+// Advance simulated time, dispatching all interrupts that falls due in the interval.
+void sim_advance (uint64_t ticks)
+{
+    uint64_t target = sim_stats.ticks + ticks;
+
+    bench_enter(Stage_Simulator);
+
+    while(true) {
+
+        sim_timer_t *timer = stepper_timer.next <= systick_timer.next ? &stepper_timer : &systick_timer;
+
+        if(timer->next > target)
+            break;
+
+        sim_stats.ticks = timer->next;
+        sim_fire(timer);
+    }
+
+    sim_stats.ticks = target;
+
+    serialPoll(sim_stats.ticks, sim_config.f_step_timer);
+
+    bench_exit();
+}
+
+// Called by the foreground whenever it polls for events, time does not advance during interrupts.
+void sim_yield (void)
+{
+    if(!in_isr)
+        sim_advance(fg_quantum);
+}
+
+void sim_stepper_attach_isr (void (*isr)(void))
+{
+    stepper_timer.isr = isr;
+}
+
+void sim_stepper_start (uint32_t delay)
+{
+    stepper_timer.period = delay;
+    stepper_timer.next = sim_stats.ticks + delay;
+}
+
+void sim_stepper_stop (void)
+{
+    stepper_timer.next = TIMER_OFF;
+}
+
+// New period takes effect on next reload.
+void sim_stepper_set_period (uint32_t cycles_per_tick)
+{
+    stepper_timer.period = cycles_per_tick;
+}
+
+void sim_systick_start (void (*isr)(void))
+{
+    systick_timer.isr = isr;
+    systick_timer.period = sim_config.f_step_timer / 1000;
+    if(systick_timer.next == TIMER_OFF)
+        systick_timer.next = sim_stats.ticks + systick_timer.period;
+}
+
+void sim_systick_stop (void)
+{
+    systick_timer.next = TIMER_OFF;
+}
+
+void sim_log_step (axes_signals_t step_outbits, axes_signals_t dir_outbits)
+{
+    uint_fast8_t idx;
+
+    sim_stats.motion_ticks = sim_stats.ticks;
+
+    for(idx = 0; idx < N_AXIS; idx++) {
+        if(step_outbits.value & bit(idx)) {
+            sim_stats.steps[idx]++;
+            sim_stats.position[idx] += (dir_outbits.value & bit(idx)) ? -1 : 1;
+            if(sim_stats.last_step[idx] && sim_stats.ticks - sim_stats.last_step[idx] < sim_stats.min_interval[idx])
+                sim_stats.min_interval[idx] = (uint32_t)(sim_stats.ticks - sim_stats.last_step[idx]);
+            sim_stats.last_step[idx] = sim_stats.ticks;
+        }
+    }
+
+    if(sim_config.step_log) {
+        fprintf(sim_config.step_log, "S,%llu,%02X,%02X", (unsigned long long)sim_stats.ticks, step_outbits.value, dir_outbits.value);
+        for(idx = 0; idx < N_AXIS; idx++)
+            fprintf(sim_config.step_log, ",%d", sim_stats.position[idx]);
+        fputc('\n', sim_config.step_log);
+    }
+}
+
+void sim_log_pwm (uint_fast16_t pwm_value)
+{
+    if(sim_config.step_log)
+        fprintf(sim_config.step_log, "P,%llu,%u\n", (unsigned long long)sim_stats.ticks, (unsigned int)pwm_value);
+}
+
+void sim_report (FILE *out)
+{
+    uint_fast8_t idx;
+    double f = (double)sim_config.f_step_timer;
+
+    fprintf(out, "Simulated time:    %.6f s\n", (double)sim_stats.ticks / f);
+    fprintf(out, "Motion end:        %.6f s\n", (double)sim_stats.motion_ticks / f);
+    fprintf(out, "Stepper ISRs:      %llu\n", (unsigned long long)sim_stats.isr_count);
+    fprintf(out, "Stepper starved:   %u\n", sim_stats.starved);
+
+#ifdef STEP_SEGMENT_STATISTICS
+    st_stats_t *segments = st_get_stats();
+
+    fprintf(out, "Step segments:     %u, %u underruns, %u low water, queue limit %u (max %u)\n", segments->segments, segments->underruns, segments->low_water,
+                  (unsigned int)segments->depth, (unsigned int)segments->max_depth);
+#endif
+
+    plan_stats_t *plan = plan_get_stats();
+
+    fprintf(out, "Planner recalcs:   %u, %.1f blocks avg, %u max, %u deferred\n", plan->recalculations,
+                  plan->recalculations ? (double)plan->blocks / (double)plan->recalculations : 0.0, plan->max_blocks, plan->deferred);
+
+    pool_stats_t *pool = pool_get_output_command_stats();
+
+    fprintf(out, "Output commands:   %u max of %u, %u waits, %u failed\n", pool->high_water, pool->size, pool->waits, pool->failed);
+
+    pool = pool_get_message_stats();
+
+    fprintf(out, "Messages:          %u max of %u, %u waits, %u failed, %u dropped\n", pool->high_water, pool->size, pool->waits, pool->failed, protocol_get_messages_dropped());
+
+    if(sim_config.flash_sectors)
+        fprintf(out, "Flash log:         %u erases, %u - %u per sector, %llu bytes written\n", sim_stats.flash_erases,
+                      sim_stats.flash_erases_min, sim_stats.flash_erases_max, (unsigned long long)sim_stats.flash_written);
+
+    for(idx = 0; idx < N_AXIS; idx++) {
+        fprintf(out, "Motor %s:           %u steps, position %d", axis_letter[idx], sim_stats.steps[idx], sim_stats.position[idx]);
+        if(sim_stats.min_interval[idx] != UINT32_MAX)
+            fprintf(out, ", max rate %.1f steps/s", f / (double)sim_stats.min_interval[idx]);
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,80 @@
+/*
+  simulator.h - simulated time base and event scheduler for the host simulator driver
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SIMULATOR_H_
+#define _SIMULATOR_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "grbl/grbl.h"
+
+#define SIM_F_STEP_TIMER    24000000UL  // Default simulated stepper timer clock
+#define SIM_FG_QUANTUM_US   10          // Default simulated time consumed by one foreground poll
+#define SIM_WAKEUP_CYCLES   500         // Delay from stepper wake up to first stepper interrupt
+#define SIM_FLASH_SECTOR_SIZE 2048      // Default flash sector size for log structured settings storage
+
+typedef struct {
+    uint32_t f_step_timer;  // Stepper timer clock, also the resolution of the simulated time base
+    uint32_t fg_quantum_us; // Simulated time consumed each time the foreground polls for realtime events
+    uint32_t baud_rate;     // Simulated serial line speed, 0 for input to be available immediately
+    FILE *input;            // G-code input
+    FILE *step_log;         // Step pulse log, NULL if not wanted
+    char *eeprom_file;      // Settings storage file, NULL for volatile settings
+    uint_fast8_t flash_sectors;     // Number of flash sectors in settings file for log structured storage, 0 for whole image storage
+    uint32_t flash_sector_size;     // Size of flash sectors in bytes
+    int32_t flash_power_loss;       // Number of bytes erased or written to flash before simulated power loss, negative for none
+} sim_config_t;
+
+typedef struct {
+    uint64_t ticks;                 // Current simulated time in stepper timer cycles
+    uint64_t motion_ticks;          // Time of last step pulse output
+    uint64_t isr_count;             // Number of stepper interrupts executed
+    uint64_t writes;                // Number of output stream writes
+    uint32_t starved;               // Number of times the stepper went idle with blocks left in the planner
+    uint32_t steps[N_AXIS];         // Number of step pulses output per motor
+    int32_t position[N_AXIS];       // Motor positions, in steps
+    uint32_t min_interval[N_AXIS];  // Shortest time between two step pulses per motor, in timer cycles
+    uint64_t last_step[N_AXIS];     // Time of last step pulse per motor
+    uint32_t flash_erases;          // Number of flash sector erases
+    uint32_t flash_erases_min;      // Lowest number of erases of a flash sector
+    uint32_t flash_erases_max;      // Highest number of erases of a flash sector
+    uint64_t flash_written;         // Number of bytes written to flash
+} sim_stats_t;
+
+extern sim_config_t sim_config;
+extern sim_stats_t sim_stats;
+
+void sim_init (void);
+void sim_yield (void);
+void sim_advance (uint64_t ticks);
+void sim_stepper_attach_isr (void (*isr)(void));
+void sim_stepper_start (uint32_t delay);
+void sim_stepper_stop (void);
+void sim_stepper_set_period (uint32_t cycles_per_tick);
+void sim_systick_start (void (*isr)(void));
+void sim_systick_stop (void);
+void sim_log_step (axes_signals_t step_outbits, axes_signals_t dir_outbits);
+void sim_log_pwm (uint_fast16_t pwm_value);
+void sim_report (FILE *out);
+
+#endif
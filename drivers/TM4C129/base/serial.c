@@ -131,6 +131,38 @@ int16_t serialGetC (void)
     return (int16_t)c;
 }
 
+//
+// serialReadSpan - copies input up to and including the first end of line character, returns 0 if no data available
+//
+uint16_t serialReadSpan (char *buf, uint16_t max)
+{
+    char c;
+    uint16_t count = 0;
+    uint_fast16_t tail = rxbuffer.tail, bptr = tail, head = rxbuffer.head;
+
+    while(count < max && bptr != head) {
+        buf[count++] = c = rxbuffer.data[bptr];
+        bptr = (bptr + 1) & (RX_BUFFER_SIZE - 1);
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    // Keep the tail set by a stop or jog cancel received while copying, the span is cancelled input then.
+    IntMasterDisable();
+    if(rxbuffer.tail == tail)
+        rxbuffer.tail = bptr; // Update pointer
+    else
+        count = 0;
+    IntMasterEnable();
+
+ #ifdef RTS_PORT
+    if (rxbuffer.rts_state && BUFCOUNT(rxbuffer.head, rxbuffer.tail, RX_BUFFER_SIZE) < RX_BUFFER_LWM)   // Clear RTS if
+        GPIOPinWrite(RTS_PORT, RTS_PIN, rxbuffer.rts_state = 0);                                        // buffer count is below low water mark
+ #endif
+
+    return count;
+}
+
 // "dummy" version of serialGetC
 static int16_t serialGetNull (void)
 {
@@ -201,9 +233,10 @@ void serialWriteS (const char *data)
 
 bool serialSuspendInput (bool suspend)
 {
-    if(suspend)
+    if(suspend) {
         hal.stream.read = serialGetNull;
-    else if(rxbuffer.backup)
+        hal.stream.read_span = NULL;
+    } else if(rxbuffer.backup)
         memcpy(&rxbuffer, &rxbackup, sizeof(stream_rx_buffer_t));
 
     return rxbuffer.tail != rxbuffer.head;
@@ -252,6 +285,7 @@ static void uart_interrupt_handler (void)
             rxbuffer.backup = true;
             rxbuffer.tail = rxbuffer.head;
             hal.stream.read = serialGetC; // restore normal input
+            hal.stream.read_span = serialReadSpan;
 
         } else if(!hal.stream.enqueue_realtime_command((char)c)) {
 
@@ -111,6 +111,7 @@
 
 void serialInit (void);
 int16_t serialGetC (void);
+uint16_t serialReadSpan (char *buf, uint16_t max);
 bool serialPutC (const char data);
 void serialWriteS (const char *data);
 bool serialSuspendInput (bool suspend);
@@ -60,6 +60,11 @@
 // Experimental - testing required and homing needs to be worked out.
 //#define WALL_PLOTTER // Default disabled. Uncomment to enable.
 
+// Maslow router and wall plotter kinematics split lines into segments that keep the tool path within
+// the arc tolerance setting ($12) of the programmed line. Segments grow up to this length when the
+// deviation allows it, flat regions of the workspace thus need far fewer planner blocks.
+// #define KINEMATICS_SEGMENT_MAX_LENGTH 25.0f // mm. Uncomment to override default in kinematics.h.
+
 // Enable CoreXY kinematics. Use ONLY with CoreXY machines.
 // IMPORTANT: If homing is enabled, you must reconfigure the homing cycle #defines above to
 // #define HOMING_CYCLE_0 X_AXIS_BIT and #define HOMING_CYCLE_1 Y_AXIS_BIT
@@ -214,6 +219,14 @@
 
 // #define ENABLE_SPINDLE_LINEARIZATION        // Uncomment to enable spindle RPM linearization. Requires compatible driver if enabled.
 #define SPINDLE_NPWM_PIECES                 4 // Maximum number of pieces for spindle RPM linearization, do not change unless more are needed.
+// Uncomment to convert spindle RPM to PWM with a lookup table precomputed by spindle_precompute_pwm_values() when
+// settings are changed. Conversion is then a clamp, an indexed load and a linear interpolation between table entries
+// instead of floating point math and a search of the linearization pieces. The table spans the RPM range from $31
+// to $30, the result may differ by one PWM count from the calculated value. With linearization enabled the error is
+// larger in the table intervals containing a piece boundary, set more table intervals if this is a problem.
+// Requires a driver that converts RPM by spindle_compute_pwm_value(), uses (SPINDLE_PWM_TABLE_SIZE + 1) *
+// sizeof(uint_fast16_t) bytes of RAM.
+// #define SPINDLE_PWM_TABLE_SIZE            256 // Number of RPM intervals in the table, 2 - 1024.
 #define DEFAULT_SPINDLE_RPM_OVERRIDE      100 // 100%. Don't change this value.
 #define MAX_SPINDLE_RPM_OVERRIDE          200 // Percent of programmed spindle speed (100-255). Usually 200%.
 #define MIN_SPINDLE_RPM_OVERRIDE           10 // Percent of programmed spindle speed (1-100). Usually 10%.
@@ -241,6 +254,10 @@
 #define REPORT_WCO_REFRESH_BUSY_COUNT 30        // (2-255)
 #define REPORT_WCO_REFRESH_IDLE_COUNT 10        // (2-255) Must be less than or equal to the busy count
 
+// Size of the buffer the realtime status report is composed in before being output with a single stream write.
+// Reports exceeding the buffer size, e.g. due to driver provided data, are output in several writes.
+// #define REPORT_RT_BUFFER_SIZE 256 // Uncomment to override default in report.h.
+
 // The temporal resolution of the acceleration management subsystem. A higher number gives smoother
 // acceleration, particularly noticeable on machines that run at very high feedrates, but may negatively
 // impact performance. The correct value for this parameter is machine dependent, so it's advised to
@@ -319,6 +336,27 @@
 // much greater than this. The default setting should capture most, if not all, full arc error situations.
 #define ARC_ANGULAR_TRAVEL_EPSILON 5E-7f // Float (radians)
 
+// Enables native arc motion. G2/G3 arcs are planned as a single circular or helical planner block and
+// the step segment generator computes segment end points on the arc, instead of the arc being
+// approximated by short line segments each occupying a planner block. The planner look-ahead then
+// spans real geometry and there are no speed reductions at chord junctions, the arc speed is limited
+// by centripetal acceleration computed from the radius instead. The arc tolerance setting is not used.
+// NOTE: The arc speed is capped so that the centripetal acceleration alone does not exceed the plane axes
+// acceleration, the tangential acceleration along the arc is limited separately. While the arc speed
+// changes both add up and the acceleration of a plane axis may momentarily exceed its setting.
+// NOTE: Not available with kinematics or backlash compensation.
+//#define ENABLE_NATIVE_ARCS // Default disabled. Uncomment to enable.
+
+// Enables laser raster scanlines. A scanline is loaded as base64 encoded pixel power values (0-255) with
+// one or more $L=<data> commands and executed by the next G1 motion as a single planner block. The pixels
+// are spread evenly along the motion and the stepper interrupt sets the laser PWM at each pixel boundary,
+// pixel power is the programmed S value scaled by the pixel value. This avoids parsing and planning a
+// g-code block per pixel for photo engraving. Requires laser mode ($32=1) and direct PWM spindle control.
+// NOTE: Uses BLOCK_BUFFER_SIZE bytes and SEGMENT_BUFFER_SIZE * 2 bytes of RAM per pixel of the maximum
+// scanline length. Not available with kinematics.
+//#define ENABLE_LASER_RASTER // Default disabled. Uncomment to enable.
+//#define LASER_RASTER_MAX_PIXELS 192 // Uncomment to override default in planner.h.
+
 // Time delay increments performed during a dwell. The default value is set at 50ms, which provides
 // a maximum time delay of roughly 55 minutes, more than enough for most any application. Increasing
 // this delay will increase the maximum dwell time linearly, but also reduces the responsiveness of
@@ -331,8 +369,27 @@
 // available RAM, like when re-compiling for MCU with ample amounts of RAM. Or decrease if the MCU begins to
 // crash due to the lack of available RAM or if the CPU is having trouble keeping up with planning
 // new incoming motions as they are executed.
+// NOTE: The velocity profile data used by the look-ahead planner is kept separate from the remaining block
+// data, recalculation cost does not depend on the size of the latter. Sizes up to several hundred blocks are
+// supported for MCUs with plenty of RAM, longer look-ahead allows higher feed rates for short line segments.
 // #define BLOCK_BUFFER_SIZE 16 // Uncomment to override default in planner.h.
 
+// The maximum number of planner blocks processed by the look-ahead recalculation when a new block is added.
+// Blocks left are processed by subsequent main loop iterations, this bounds the time spent in the planner
+// for each block so that the step segment buffer can be kept filled with large planner buffers.
+// Override and feed hold resume replans are bounded too, these proceed from the executing block with the
+// blocks not yet replanned held at a complete stop. Set to 0 to always recalculate the complete plan.
+// #define PLANNER_RECALC_LIMIT 32 // Uncomment to override default in planner.h.
+
+// Number of entries in the preallocated pools for output commands synchronized with motion (M62, M63 and M67)
+// and for block messages from (MSG,...) comments, and max message length. Entries are released when the block
+// they belong to is executed, when a pool is exhausted the parser waits for queued blocks to be executed.
+// Jobs with many output commands or messages per block may thus get a shorter look-ahead than the planner
+// buffer size allows.
+// #define OUTPUT_COMMAND_POOL_SIZE 36 // Uncomment to override default in pool.h, BLOCK_BUFFER_SIZE.
+// #define MESSAGE_POOL_SIZE 9 // Uncomment to override default in pool.h, BLOCK_BUFFER_SIZE / 4.
+// #define MESSAGE_LENGTH_MAX 80 // Uncomment to override default in pool.h, longer messages are truncated.
+
 // Governs the size of the intermediary step segment buffer between the step execution algorithm
 // and the planner blocks. Each segment is set of steps executed at a constant velocity over a
 // fixed time defined by ACCELERATION_TICKS_PER_SECOND. They are computed such that the planner
@@ -341,6 +398,45 @@
 // before having to come back and refill this buffer, currently at ~50msec of step moves.
 // #define SEGMENT_BUFFER_SIZE 6 // Uncomment to override default in stepper.h.
 
+// Interpolates the step interval within segments of acceleration and deceleration ramps instead of
+// executing each segment at a constant step rate. The segment generator computes the interval of the
+// first step and the change per step from the speeds at the start and end of the segment, keeping the
+// segment execution time, and the stepper interrupt updates the step timer every step. Smooths out the
+// velocity staircase from the segment time quantization that can excite resonances with high microstepping.
+// NOTE: Calls hal.stepper_cycles_per_tick() from every stepper interrupt during ramps, drivers with an
+// expensive implementation, e.g. timer prescaler selection, may limit the maximum step rate.
+//#define STEP_RATE_INTERPOLATION // Default disabled. Uncomment to enable.
+
+// Sets rate adjusted laser power (M4 in laser mode) from the speed the steps of a segment are executed at,
+// the average speed of the segment, instead of the speed at the end of the segment. Power then no longer
+// lags the velocity profile by a segment, giving a constant energy per mm in acceleration ramps and corners.
+// With STEP_RATE_INTERPOLATION and direct PWM spindle control the power is also set for every tick of a ramp
+// segment, from the interpolated step interval.
+// NOTE: With STEP_RATE_INTERPOLATION the stepper interrupt performs an integer division and calls
+// hal.spindle_update_pwm() for every tick of a ramp segment of a rate adjusted laser motion.
+//#define LASER_POWER_RATE_SYNC // Default disabled. Uncomment to enable.
+
+// Adapts the step segment time and the number of queued step segments to the motion being executed.
+// Segments in acceleration and deceleration ramps and of spindle synchronized motions are executed over
+// half the time set by ACCELERATION_TICKS_PER_SECOND, for a finer velocity and position resolution. Cruise
+// segments are lengthened in proportion to the step rate above ADAPTIVE_SEGMENT_STEP_RATE, up to
+// ADAPTIVE_SEGMENT_CRUISE_MAX times, to reduce the foreground load at high step rates. Arcs traced by
+// the segment generator are not lengthened.
+// The number of queued segments starts at ADAPTIVE_SEGMENT_MIN_DEPTH and is increased each time the stepper
+// interrupt takes the last queued segment while motion is pending, i.e. the foreground is busy. It is slowly
+// decreased again while the foreground keeps up, a shallow queue gives a faster feed hold and override response.
+// NOTE: SEGMENT_BUFFER_SIZE - 1 is the maximum number of queued segments.
+//#define ADAPTIVE_STEP_SEGMENTS // Default disabled. Uncomment to enable.
+// #define ADAPTIVE_SEGMENT_STEP_RATE 10000 // Uncomment to override default in stepper.h, steps/s.
+// #define ADAPTIVE_SEGMENT_CRUISE_MAX 4 // Uncomment to override default in stepper.h.
+// #define ADAPTIVE_SEGMENT_MIN_DEPTH 6 // Uncomment to override default in stepper.h, SEGMENT_BUFFER_SIZE / 2.
+
+// Enables step segment buffer statistics, returned by st_get_stats(): the number of segments prepared,
+// how many times the stepper interrupt found the segment buffer empty or took the last queued segment
+// while motion was pending, and the current and largest limit of queued segments. Adds a few instructions
+// to the stepper interrupt, intended for tuning and testing.
+//#define STEP_SEGMENT_STATISTICS // Default disabled. Uncomment to enable.
+
 // Configures the position after a probing cycle during Grbl's check mode. Disabled sets
 // the position to the probe target, when enabled sets the position to the start position.
 // #define SET_CHECK_MODE_PROBE_TO_START // Default disabled. Uncomment to enable.
@@ -121,6 +121,7 @@
 #define DEFAULT_DIRECTION_INVERT_MASK 0
 #define DEFAULT_STEPPER_IDLE_LOCK_TIME 25 // msec (0-254, 255 keeps steppers enabled)
 #define DEFAULT_JUNCTION_DEVIATION 0.01f // mm
+#define DEFAULT_JERK (0.0f*60*60*60) // mm/min^3, 0 = trapezoidal velocity profiles
 #define DEFAULT_ARC_TOLERANCE 0.002f // mm
 #define DEFAULT_REPORT_INCHES 0 // false
 #define DEFAULT_INVERT_LIMIT_PINS 0 // false
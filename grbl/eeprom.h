@@ -35,6 +35,16 @@ typedef struct {
     uint16_t size;
 } eeprom_driver_area_t;
 
+// Sector based flash storage, used by the EEPROM emulation for a wear-levelled log of changes to the settings.
+// Writes are to offsets and of sizes that are multiples of 8 bytes, to erased flash only.
+typedef struct {
+    uint_fast8_t sectors;   // Number of flash sectors reserved for settings storage, 0 if not available
+    uint32_t sector_size;   // Size of a sector (erase unit) in bytes, multiple of 8
+    bool (*erase)(uint_fast8_t sector);
+    bool (*write)(uint_fast8_t sector, uint32_t offset, uint8_t *source, uint32_t size);
+    bool (*read)(uint_fast8_t sector, uint32_t offset, uint8_t *dest, uint32_t size);
+} eeprom_flash_log_t;
+
 typedef struct {
     eeprom_type type;
     uint16_t size;
@@ -45,6 +55,7 @@ typedef struct {
     bool (*memcpy_from_with_checksum)(uint8_t *destination, uint32_t source, uint32_t size);
     bool (*memcpy_from_flash)(uint8_t *dest);
     bool (*memcpy_to_flash)(uint8_t *source);
+    eeprom_flash_log_t flash_log; // Optional, used instead of memcpy_to_flash() if available
 } eeprom_io_t;
 
 #endif
@@ -28,6 +28,7 @@
 #include "grbl.h"
 
 static uint8_t *noepromdata = 0;
+static uint8_t *dirty_chunks = 0; // Bitmap of changed EEPROM_LOG_CHUNK_SIZE chunks not yet written to the flash log
 static eeprom_io_t physical_eeprom;
 static bool dirty;
 
@@ -97,8 +98,12 @@ inline static uint8_t ram_get_byte (uint32_t addr)
 
 inline static void ram_put_byte (uint32_t addr, uint8_t new_value)
 {
-    dirty = dirty || noepromdata[addr] != new_value;
-    noepromdata[addr] = new_value;
+    if(noepromdata[addr] != new_value) {
+        dirty = true;
+        if(dirty_chunks)
+            dirty_chunks[addr / (EEPROM_LOG_CHUNK_SIZE * 8)] |= 1 << ((addr / EEPROM_LOG_CHUNK_SIZE) & 0x07);
+        noepromdata[addr] = new_value;
+    }
 }
 
 // Extensions added as part of Grbl
@@ -167,6 +172,364 @@ static bool memcpy_from_ram_with_checksum (uint8_t *destination, uint32_t source
     return checksum == ram_get_byte(source);
 }
 
+//
+// Log structured flash storage, used when the driver provides sector based flash access.
+//
+// The RAM copy is stored in a ring of flash sectors as a log of records, each record holds a range of
+// changed EEPROM_LOG_CHUNK_SIZE chunks. On sync only the changed chunks are appended, erasing a sector
+// only when the log moves into it. When the ring is about to fill up a snapshot of the complete RAM copy
+// is written to the free sectors, the sectors holding older data are then free for reuse. Sectors are
+// used in turn, so erases are spread evenly.
+// On startup the log is replayed from the start of the last complete snapshot. Records are protected by
+// a checksum and a CRC, the changes of a sync are discarded unless all its records are valid, as is a
+// later snapshot not completed. Thus power loss while writing loses the changes being written only.
+//
+
+#define LOG_SECTOR_DATA     0x4C4F4744 // Sector magic, sector with delta and snapshot continuation records
+#define LOG_SECTOR_SNAPSHOT 0x4C4F4753 // Sector magic, sector starting with a snapshot
+
+typedef enum {
+    LogRecord_Delta = 1,
+    LogRecord_DeltaEnd,     // Last record of the changes written by a sync
+    LogRecord_Snapshot,
+    LogRecord_SnapshotEnd,
+    LogRecord_Erased = 0xFF
+} log_record_type_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;       // Sequence number, incremented for each sector written
+} log_sector_t;
+
+typedef struct {
+    uint16_t addr;      // Start address of data in the RAM copy
+    uint16_t size;      // Size of data, multiple of EEPROM_LOG_CHUNK_SIZE
+    uint16_t crc;       // CRC-16 of data
+    uint8_t type;       // log_record_type_t
+    uint8_t checksum;   // Checksum of the fields above
+} log_record_t;
+
+typedef struct {
+    eeprom_flash_log_t *flash;
+    uint32_t image_size;            // Size of RAM copy, rounded up to multiple of EEPROM_LOG_CHUNK_SIZE
+    uint32_t offset;                // Offset of next record in head sector
+    uint32_t seq;                   // Sequence number of head sector
+    uint_fast8_t head;              // Sector appended to
+    uint_fast8_t used;              // Number of sectors with data in use, from start of last snapshot to head
+    uint_fast8_t snapshot_sectors;  // Number of sectors needed for a snapshot
+} flash_log_t;
+
+static flash_log_t flog;
+
+// Max size of record data that fits in the head sector
+static inline uint32_t log_space (void)
+{
+    return flog.offset + sizeof(log_record_t) + EEPROM_LOG_CHUNK_SIZE > flog.flash->sector_size
+            ? 0
+            : (flog.flash->sector_size - flog.offset - sizeof(log_record_t)) & ~(EEPROM_LOG_CHUNK_SIZE - 1);
+}
+
+static bool log_open_sector (uint32_t magic)
+{
+    // The next sector holds the start of the data in use when all sectors are used, it must not be erased.
+    if(flog.used >= flog.flash->sectors)
+        return false;
+
+    log_sector_t sector = {
+        .magic = magic,
+        .seq = ++flog.seq
+    };
+    uint_fast8_t head = flog.head;
+
+    flog.head = (flog.head + 1) % flog.flash->sectors;
+
+    // On failure stay at the current head, marked as full, so that the next attempt reuses the same sector.
+    // An erased sector left between sectors in use would end the log on replay.
+    if(!(flog.flash->erase(flog.head) && flog.flash->write(flog.head, 0, (uint8_t *)&sector, sizeof(log_sector_t)))) {
+        flog.head = head;
+        flog.offset = flog.flash->sector_size;
+        return false;
+    }
+
+    flog.used++;
+    flog.offset = sizeof(log_sector_t);
+
+    return true;
+}
+
+static bool log_write_record (log_record_type_t type, uint32_t addr, uint32_t size)
+{
+    log_record_t record = {
+        .addr = (uint16_t)addr,
+        .size = (uint16_t)size,
+        .crc = calc_crc16(noepromdata + addr, size),
+        .type = (uint8_t)type
+    };
+
+    record.checksum = calc_checksum((uint8_t *)&record, offsetof(log_record_t, checksum));
+
+    bool ok = flog.flash->write(flog.head, flog.offset, (uint8_t *)&record, sizeof(log_record_t)) &&
+               flog.flash->write(flog.head, flog.offset + sizeof(log_record_t), noepromdata + addr, size);
+
+    flog.offset = ok ? flog.offset + sizeof(log_record_t) + size : flog.flash->sector_size;
+
+    return ok;
+}
+
+// Write the complete RAM copy, starting in a new sector. Sectors with older data are free for reuse when done.
+// If writing fails the log is rewound to the last complete snapshot, a new attempt reuses the same sectors.
+static bool log_write_snapshot (void)
+{
+    bool ok;
+    uint32_t addr = 0, size;
+    uint_fast8_t used = flog.used, head = flog.head;
+
+    memset(dirty_chunks, 0, flog.image_size / (EEPROM_LOG_CHUNK_SIZE * 8) + 1);
+
+    if((ok = log_open_sector(LOG_SECTOR_SNAPSHOT))) {
+        do {
+            if((size = log_space()) == 0) {
+                if(!(ok = log_open_sector(LOG_SECTOR_DATA)))
+                    break;
+                size = log_space();
+            }
+            size = min(size, flog.image_size - addr);
+            ok = log_write_record(addr + size == flog.image_size ? LogRecord_SnapshotEnd : LogRecord_Snapshot, addr, size);
+            addr += size;
+        } while(ok && addr < flog.image_size);
+    }
+
+    if(ok)
+        flog.used -= used;
+    else {
+        // Keep the last complete snapshot, mark all data as changed for a new attempt at next sync. The head sector
+        // is marked as full so that the attempt starts in a new sector, sectors of the failed snapshot are not in use.
+        flog.head = head;
+        flog.used = used;
+        flog.offset = flog.flash->sector_size;
+        memset(dirty_chunks, 0xFF, flog.image_size / (EEPROM_LOG_CHUNK_SIZE * 8) + 1);
+    }
+
+    return ok;
+}
+
+static inline bool chunk_is_dirty (uint32_t chunk)
+{
+    return !!(dirty_chunks[chunk >> 3] & (1 << (chunk & 0x07)));
+}
+
+// Append changed chunks to the log. The records are written to a single sector and the last one is marked,
+// changes are discarded on replay unless all of them were written.
+static bool log_write_changes (void)
+{
+    bool ok = true;
+    uint32_t chunk, chunks = flog.image_size / EEPROM_LOG_CHUNK_SIZE, first, last = 0, size = 0;
+
+    if(flog.used == 0)
+        return log_write_snapshot();
+
+    for(chunk = 0; chunk < chunks; chunk++) {
+        if(chunk_is_dirty(chunk)) {
+            if(chunk == 0 || !chunk_is_dirty(chunk - 1)) {
+                last = chunk;
+                size += sizeof(log_record_t);
+            }
+            size += EEPROM_LOG_CHUNK_SIZE;
+        }
+    }
+
+    if(size == 0)
+        return true;
+
+    // Compact to a snapshot if the changes are too large for a sector or if the free sectors left
+    // after opening a new one cannot hold a snapshot.
+    if(size > flog.flash->sector_size - flog.offset) {
+        if(size > flog.flash->sector_size - sizeof(log_sector_t) || flog.used + 1 + flog.snapshot_sectors > flog.flash->sectors)
+            return log_write_snapshot();
+        ok = log_open_sector(LOG_SECTOR_DATA);
+    }
+
+    chunk = 0;
+    while(ok && chunk < chunks) {
+
+        if(!chunk_is_dirty(chunk)) {
+            chunk++;
+            continue;
+        }
+
+        first = chunk;
+        while(chunk < chunks && chunk_is_dirty(chunk)) {
+            dirty_chunks[chunk >> 3] &= ~(1 << (chunk & 0x07));
+            chunk++;
+        }
+
+        ok = log_write_record(first == last ? LogRecord_DeltaEnd : LogRecord_Delta, first * EEPROM_LOG_CHUNK_SIZE, (chunk - first) * EEPROM_LOG_CHUNK_SIZE);
+    }
+
+    if(!ok) // Write failed, mark all data as changed for a new attempt at next sync.
+        memset(dirty_chunks, 0xFF, flog.image_size / (EEPROM_LOG_CHUNK_SIZE * 8) + 1);
+
+    return ok;
+}
+
+// Check record data in flash against the record CRC.
+static bool log_check_record (uint_fast8_t sector, uint32_t offset, log_record_t *record)
+{
+    uint32_t idx;
+    uint16_t crc = 0xFFFF;
+    uint8_t data[EEPROM_LOG_CHUNK_SIZE];
+
+    for(idx = 0; idx < record->size; idx += EEPROM_LOG_CHUNK_SIZE) {
+        if(!flog.flash->read(sector, offset + idx, data, EEPROM_LOG_CHUNK_SIZE))
+            return false;
+        crc = calc_crc16_update(crc, data, EEPROM_LOG_CHUNK_SIZE);
+    }
+
+    return crc == record->crc;
+}
+
+// Read and validate record header and check data, returns false at end of records or if record is invalid.
+static bool log_read_record (uint_fast8_t sector, uint32_t offset, log_record_t *record)
+{
+    return offset + sizeof(log_record_t) <= flog.flash->sector_size &&
+            flog.flash->read(sector, offset, (uint8_t *)record, sizeof(log_record_t)) &&
+             record->checksum == calc_checksum((uint8_t *)record, offsetof(log_record_t, checksum)) &&
+              record->type >= LogRecord_Delta && record->type <= LogRecord_SnapshotEnd &&
+               record->size && !(record->size & (EEPROM_LOG_CHUNK_SIZE - 1)) && record->addr + record->size <= flog.image_size &&
+                offset + sizeof(log_record_t) + record->size <= flog.flash->sector_size &&
+                 log_check_record(sector, offset + sizeof(log_record_t), record);
+}
+
+// Read the records of a sector to the RAM copy, returns offset past last valid record. Changes not completely
+// written are skipped. Sets snapshot_end if a snapshot end record is read, torn to true if the sector has an
+// invalid record or changes not completely written.
+static uint32_t log_read_sector (uint_fast8_t sector, bool *snapshot_end, bool *torn)
+{
+    log_record_t record;
+    uint32_t offset = sizeof(log_sector_t), end = offset, committed = offset;
+
+    while(log_read_record(sector, end, &record)) {
+        end += sizeof(log_record_t) + record.size;
+        if(record.type != LogRecord_Delta)
+            committed = end;
+    }
+
+    *torn = committed != end || (end + sizeof(log_record_t) <= flog.flash->sector_size &&
+             !(flog.flash->read(sector, end, (uint8_t *)&record, sizeof(log_record_t)) &&
+                record.type == LogRecord_Erased && record.addr == 0xFFFF && record.size == 0xFFFF));
+
+    while(offset < committed) {
+        flog.flash->read(sector, offset, (uint8_t *)&record, sizeof(log_record_t));
+        flog.flash->read(sector, offset + sizeof(log_record_t), noepromdata + record.addr, record.size);
+        if(record.type == LogRecord_SnapshotEnd)
+            *snapshot_end = true;
+        offset += sizeof(log_record_t) + record.size;
+    }
+
+    return end;
+}
+
+// Read sector header, returns false if the sector is not part of the log.
+static bool log_read_header (uint_fast8_t sector, log_sector_t *header)
+{
+    return flog.flash->read(sector, 0, (uint8_t *)header, sizeof(log_sector_t)) &&
+            (header->magic == LOG_SECTOR_DATA || header->magic == LOG_SECTOR_SNAPSHOT);
+}
+
+// Find the log in flash and replay it to the RAM copy, returns false if no complete snapshot is found.
+static bool log_load (void)
+{
+    bool end = false, torn = false;
+    log_sector_t header, prev;
+    uint32_t seq_max = 0, seq_limit = UINT32_MAX;
+    uint_fast8_t idx, sectors = flog.flash->sectors, first, length, start, complete = 0, stop;
+
+    flog.used = 0;
+
+    do {
+        // Find head, the sector with the highest sequence number below the limit.
+        length = start = 0;
+        flog.seq = 0;
+        flog.head = sectors - 1;
+        for(idx = 0; idx < sectors; idx++) {
+            if(log_read_header(idx, &header) && header.seq < seq_limit && (length == 0 || header.seq > flog.seq)) {
+                flog.head = idx;
+                flog.seq = header.seq;
+                length = 1;
+            }
+        }
+
+        if(length == 0)
+            return false;
+
+        seq_max = max(seq_max, flog.seq);
+        seq_limit = flog.seq;
+
+        // Walk back to the oldest sector written in sequence before head.
+        first = flog.head;
+        header.seq = flog.seq;
+        while(length < sectors) {
+            idx = (first + sectors - 1) % sectors;
+            if(!log_read_header(idx, &prev) || prev.seq >= header.seq)
+                break;
+            header.seq = prev.seq;
+            first = idx;
+            length++;
+        }
+
+        // Find the start of the last complete snapshot. If there is none the sectors are left over from a failed
+        // snapshot, the log continues in sectors written before them.
+        for(idx = 0; idx < length; idx++) {
+            if(log_read_header((first + idx) % sectors, &header) && header.magic == LOG_SECTOR_SNAPSHOT)
+                start = idx + 1;
+            log_read_sector((first + idx) % sectors, &end, &torn);
+            if(end) {
+                complete = start;
+                end = false;
+            }
+        }
+    } while(complete == 0);
+
+    flog.seq = seq_max; // Sectors written from now on must follow any left over sector
+
+    // Discard a later snapshot not completed, its sectors are free for reuse.
+    stop = start > complete ? start - 1 : length;
+
+    // Replay from the start of the last complete snapshot.
+    for(idx = complete - 1; idx < stop; idx++)
+        flog.offset = log_read_sector((first + idx) % sectors, &end, &torn);
+
+    flog.head = (first + stop - 1) % sectors;
+    flog.used = stop - complete + 1;
+    if(torn || stop < length)
+        flog.offset = flog.flash->sector_size; // Do not append to a sector with a torn record or followed by a discarded snapshot.
+
+    return true;
+}
+
+// Check flash geometry and allocate the map of changed chunks, returns false if the log cannot be used.
+static bool log_init (uint32_t image_size)
+{
+    uint32_t capacity;
+    eeprom_flash_log_t *flash = &physical_eeprom.flash_log;
+
+    if(flash->sectors < 2 || flash->erase == NULL || flash->write == NULL || flash->read == NULL ||
+        flash->sector_size < sizeof(log_sector_t) + sizeof(log_record_t) + EEPROM_LOG_CHUNK_SIZE)
+        return false;
+
+    // A snapshot has one record per sector, the free sectors must always be able to hold one.
+    capacity = (flash->sector_size - sizeof(log_sector_t) - sizeof(log_record_t)) & ~(EEPROM_LOG_CHUNK_SIZE - 1);
+
+    flog.flash = flash;
+    flog.image_size = image_size;
+    flog.snapshot_sectors = (image_size + capacity - 1) / capacity;
+
+    if(flog.snapshot_sectors * 2 > flash->sectors)
+        return false;
+
+    return (dirty_chunks = calloc(image_size / (EEPROM_LOG_CHUNK_SIZE * 8) + 1, 1)) != NULL;
+}
+
 //
 // Try to allocate RAM for EEPROM emulation and switch over to RAM based copy
 // Changes to RAM based copy will be written to EEPROM when Grbl is in IDLE state
@@ -177,10 +540,11 @@ bool eeprom_emu_init()
         hal.eeprom.size = GRBL_EEPROM_SIZE;
 
     uint_fast16_t idx = hal.eeprom.size;
+    uint32_t size = (hal.eeprom.size + EEPROM_LOG_CHUNK_SIZE - 1) & ~(EEPROM_LOG_CHUNK_SIZE - 1); // Rounded up for flash log records
 
     memcpy(&physical_eeprom, &hal.eeprom, sizeof(eeprom_io_t)); // save pointers to physical EEPROM handler functions
 
-    if((noepromdata = malloc(hal.eeprom.size)) != 0) {
+    if((noepromdata = malloc(size)) != 0) {
 
         if(physical_eeprom.type == EEPROM_Physical) {
 
@@ -193,6 +557,10 @@ bool eeprom_emu_init()
                 idx--;
                 ram_put_byte(idx, physical_eeprom.get_byte(idx));
             } while(idx);
+        } else if(physical_eeprom.type != EEPROM_None && log_init(size)) {
+            // Load from flash log, on first use import settings from whole image storage if available.
+            if(!log_load() && hal.eeprom.memcpy_from_flash && hal.eeprom.memcpy_from_flash(noepromdata))
+                log_write_snapshot();
         } else if(hal.eeprom.memcpy_from_flash)
             hal.eeprom.memcpy_from_flash(noepromdata);
 
@@ -269,7 +637,10 @@ void eeprom_emu_sync_physical ()
         } while(idx);
 #endif
 
-    } else if(hal.eeprom.memcpy_to_flash)
+    } else if(dirty_chunks)
+        log_write_changes();
+
+    else if(hal.eeprom.memcpy_to_flash)
         hal.eeprom.memcpy_to_flash(noepromdata);
 
     settings_dirty.is_dirty = false;
@@ -22,6 +22,10 @@
 #ifndef __noeeprom_h__
 #define __noeeprom_h__
 
+#ifndef EEPROM_LOG_CHUNK_SIZE
+#define EEPROM_LOG_CHUNK_SIZE 16 // Granularity in bytes of changes written to the flash log, multiple of 8
+#endif
+
 typedef struct {
     bool is_dirty;
     bool global_settings;
@@ -59,7 +59,10 @@ tool_data_t tool_table;
 
 static scale_factor_t scale_factor;
 static gc_thread_data thread;
-static output_command_t *output_commands = NULL; // Linked list
+static output_command_t *output_commands = NULL, *output_commands_tail; // Linked list
+#ifdef ENABLE_LASER_RASTER
+static plan_raster_t raster_line; // Scanline loaded by $L commands, executed by the next G1 motion
+#endif
 
 // Simple hypotenuse computation function.
 inline static float hypot_f (float x, float y)
@@ -117,6 +120,10 @@ inline static float gc_get_block_offset (parser_block_t *gc_block, uint_fast8_t
 
 void gc_init(bool cold_start)
 {
+#ifdef ENABLE_LASER_RASTER
+    raster_line.pixels = 0;
+#endif
+
     if(cold_start) {
         memset(&gc_state, 0, sizeof(parser_state_t));
       #ifdef N_TOOLS
@@ -132,11 +139,8 @@ void gc_init(bool cold_start)
     }
 
     // Clear any pending output commands
-    while(output_commands) {
-        output_command_t *next = output_commands->next;
-        free(output_commands);
-        output_commands = next;
-    }
+    output_commands_release(output_commands);
+    output_commands = NULL;
 
     // Load default override status
     gc_state.modal.override_ctrl = sys.override.control;
@@ -160,23 +164,41 @@ void gc_set_laser_ppimode (bool on)
     gc_state.is_laser_ppi_mode = on;
 }
 
+#ifdef ENABLE_LASER_RASTER
+
+// Append base64 encoded pixel power values to the scanline to be executed by the next G1 motion.
+status_code_t gc_raster_load (char *data)
+{
+    int32_t pixels;
+
+    if(!settings.flags.laser_mode)
+        return Status_SettingDisabled;
+
+    if((pixels = decode_base64(&raster_line.power[raster_line.pixels], data, LASER_RASTER_MAX_PIXELS - raster_line.pixels)) < 0) {
+        raster_line.pixels = 0; // Discard partial scanline.
+        return Status_InvalidStatement;
+    }
+
+    raster_line.pixels += pixels;
+
+    return Status_OK;
+}
+
+#endif
+
 // Add output command to linked list
 static bool add_output_command (output_command_t *command)
 {
     output_command_t *add_cmd;
 
-    if((add_cmd = malloc(sizeof(output_command_t)))) {
-
-        memcpy(add_cmd, command, sizeof(output_command_t));
+    if((add_cmd = output_command_alloc(command))) {
 
         if(output_commands == NULL)
             output_commands = add_cmd;
-        else {
-            output_command_t *cmd = output_commands;
-            while(cmd->next)
-                cmd = cmd->next;
-            cmd->next = add_cmd;
-        }
+        else
+            output_commands_tail->next = add_cmd;
+
+        output_commands_tail = add_cmd;
     }
 
     return add_cmd != NULL;
@@ -437,9 +459,18 @@ status_code_t gc_execute_block(char *block, char *message)
 
                     case 61:
                         word_bit.group = ModalGroup_G13;
-                        if (mantissa != 0) // [G61.1 not supported]
+                        if (mantissa == 0)
+                            gc_block.modal.control = ControlMode_ExactPath; // G61
+                        else if (mantissa == 10) {
+                            gc_block.modal.control = ControlMode_ExactStop; // G61.1
+                            mantissa = 0; // Set to zero to indicate valid non-integer G command.
+                        } else
                             FAIL(Status_GcodeUnsupportedCommand);
-                        // gc_block.modal.control = CONTROL_MODE_EXACT_PATH; // G61
+                        break;
+
+                    case 64:
+                        word_bit.group = ModalGroup_G13;
+                        gc_block.modal.control = ControlMode_PathBlending; // G64
                         break;
 
                     case 96: case 97:
@@ -1211,7 +1242,18 @@ status_code_t gc_execute_block(char *block, char *message)
             FAIL(Status_SettingReadFail);
     }
 
-    // [16. Set path control mode ]: N/A. Only G61. G61.1 and G64 NOT SUPPORTED.
+    // [16. Set path control mode ]: G64 takes an optional P word, the path tolerance. Corners are only rounded
+    // when a tolerance is given, without it the junction speed is limited by the junction deviation as in G61.
+    if (bit_istrue(command_words, bit(ModalGroup_G13))) { // Check if called in block
+        gc_block.values.path_tolerance = 0.0f;
+        if (gc_block.modal.control == ControlMode_PathBlending && bit_istrue(value_words, bit(Word_P))) {
+            if (gc_block.values.p < 0.0f)
+                FAIL(Status_NegativeValue); // [P < 0]
+            gc_block.values.path_tolerance = gc_block.modal.units_imperial ? gc_block.values.p * MM_PER_INCH : gc_block.values.p;
+            bit_false(value_words, bit(Word_P));
+        }
+    }
+
     // [17. Set distance mode ]: N/A. Only G91.1. G90.1 NOT SUPPORTED.
     // [18. Set retract mode ]: N/A.
 
@@ -1908,8 +1950,8 @@ status_code_t gc_execute_block(char *block, char *message)
     plan_data.line_number = gc_state.line_number; // Record data for planner use.
 
     // [1. Comments feedback ]: Extracted in protocol.c if HAL entry point provided
-    if(message && (plan_data.message = malloc(strlen(message) + 1)))
-        strcpy(plan_data.message, message);
+    if(message)
+        plan_data.message = message_alloc(message);
 
     // [2. Set feed rate mode ]:
     gc_state.modal.feed_mode = gc_block.modal.feed_mode;
@@ -2146,8 +2188,13 @@ status_code_t gc_execute_block(char *block, char *message)
         system_flag_wco_change();
     }
 
-    // [16. Set path control mode ]: G61.1/G64 NOT SUPPORTED
-    // gc_state.modal.control = gc_block.modal.control; // NOTE: Always default.
+    // [16. Set path control mode ]:
+    if (bit_istrue(command_words, bit(ModalGroup_G13))) {
+        gc_state.modal.control = gc_block.modal.control;
+        gc_state.path_tolerance = gc_block.values.path_tolerance;
+    }
+    plan_data.condition.exact_stop = gc_state.modal.control == ControlMode_ExactStop; // Set condition flags for planner use.
+    plan_data.path_tolerance = gc_state.path_tolerance;
 
     // [17. Set distance mode ]:
     gc_state.modal.distance_incremental = gc_block.modal.distance_incremental;
@@ -2233,7 +2280,17 @@ status_code_t gc_execute_block(char *block, char *message)
                 //??    gc_state.distance_per_rev = plan_data.feed_rate;
                     // check initial feed rate - fail if zero?
                 }
-                mc_line(gc_block.values.xyz, &plan_data);
+              #ifdef ENABLE_LASER_RASTER
+                if(raster_line.pixels) {
+                    plan_data.raster = &raster_line;
+                    mc_line(gc_block.values.xyz, &plan_data);
+                    raster_line.pixels = 0; // Scanline is copied by the planner.
+                } else
+              #endif
+                if(gc_state.modal.control == ControlMode_PathBlending && gc_state.path_tolerance > 0.0f)
+                    mc_blend_line(gc_block.values.xyz, &plan_data, gc_state.position);
+                else
+                    mc_line(gc_block.values.xyz, &plan_data);
                 break;
 
             case MotionMode_Seek:
@@ -2345,11 +2402,8 @@ status_code_t gc_execute_block(char *block, char *message)
             gc_update_pos = GCUpdatePos_None;
 
         //  Clean out any remaining output commands (may linger on error)
-        while(plan_data.output_commands) {
-            output_command_t *next = plan_data.output_commands;
-            free(plan_data.output_commands);
-            plan_data.output_commands = next;
-        }
+        output_commands_release(plan_data.output_commands);
+        plan_data.output_commands = NULL;
 
         // As far as the parser is concerned, the position is now == target. In reality the
         // motion control system might still be processing the action and the real tool position
@@ -2426,11 +2480,8 @@ status_code_t gc_execute_block(char *block, char *message)
             }
 
             // Clear any pending output commands
-            while(output_commands) {
-                output_command_t *next = output_commands->next;
-                free(output_commands);
-                output_commands = next;
-            }
+            output_commands_release(output_commands);
+            output_commands = NULL;
 
             hal.report.feedback_message(Message_ProgramEnd);
         }
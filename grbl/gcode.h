@@ -247,7 +247,11 @@ typedef enum {
 //#define CUTTER_COMP_DISABLE 0 // G40 (Default: Must be zero)
 
 // Modal Group G13: Control mode
-//#define CONTROL_MODE_EXACT_PATH 0 // G61 (Default: Must be zero)
+typedef enum {
+    ControlMode_ExactPath = 0,      // G61 (Default: Must be zero)
+    ControlMode_ExactStop = 1,      // G61.1
+    ControlMode_PathBlending = 2    // G64
+} control_mode_t;
 
 // Modal Group G8: Tool length offset
 typedef enum {
@@ -396,7 +400,7 @@ typedef struct {
     // uint8_t cutter_comp;              // {G40} NOTE: Don't track. Only default supported.
     tool_offset_mode_t tool_offset_mode; // {G43,G43.1,G49}
     coord_system_t coord_system;         // {G54,G55,G56,G57,G58,G59,G59.1,G59.2,G59.3}
-    // uint8_t control;                  // {G61} NOTE: Don't track. Only default supported.
+    control_mode_t control;              // {G61,G61.1,G64}
     program_flow_t program_flow;         // {M0,M1,M2,M30}
     coolant_state_t coolant;             // {M7,M8,M9}
     spindle_state_t spindle;             // {M3,M4,M5}
@@ -414,6 +418,7 @@ typedef struct {
     float ijk[3];              // I,J,K Axis arc offsets
     float k;                   // G33 distance per revolution
     float p;                   // G10 or dwell parameters
+    float path_tolerance;      // G64 P value in mm
     float q;                   // User defined M-code parameter (G82 peck drilling, not supported)
     float r;                   // Arc radius or retract position
     float s;                   // Spindle speed
@@ -486,6 +491,7 @@ typedef struct {
     spindle_t spindle;                  // RPM
     float feed_rate;                    // Millimeters/min
     float distance_per_rev;             // Millimeters/rev
+    float path_tolerance;               // G64 path tolerance in mm, 0 for no corner blending
     float position[N_AXIS];             // Where the interpreter considers the tool to be at this point in the code
     int32_t line_number;                // Last line number sent
     uint8_t tool_pending;               // Tool to be selected on next M6
@@ -535,6 +541,11 @@ status_code_t gc_execute_block(char *block, char *message);
 
 void gc_set_laser_ppimode (bool on);
 
+#ifdef ENABLE_LASER_RASTER
+// Append base64 encoded pixel power values to the laser raster scanline executed by the next G1 motion.
+status_code_t gc_raster_load (char *data);
+#endif
+
 // Gets axes scaling state.
 axes_signals_t gc_get_g51_state (void);
 float *gc_get_scaling (void);
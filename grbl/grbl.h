@@ -50,6 +50,7 @@
 #include "gcode.h"
 #include "limits.h"
 #include "planner.h"
+#include "pool.h"
 #include "motion_control.h"
 #include "protocol.h"
 #include "state_machine.h"
@@ -91,6 +92,15 @@
 #if (REPORT_OVERRIDE_REFRESH_IDLE_COUNT < 1)
   #error "Override refresh must be greater than zero."
 #endif
+#if defined(ENABLE_NATIVE_ARCS) && (defined(KINEMATICS_API) || defined(ENABLE_BACKLASH_COMPENSATION))
+  #error "ENABLE_NATIVE_ARCS cannot be used with kinematics or backlash compensation."
+#endif
+#if defined(ENABLE_LASER_RASTER) && (defined(KINEMATICS_API) || !defined(SPINDLE_PWM_DIRECT))
+  #error "ENABLE_LASER_RASTER cannot be used with kinematics and requires direct PWM spindle control."
+#endif
+#if (REPORT_RT_BUFFER_SIZE <= BINARY_STATUS_FRAME_SIZE)
+  #error "Realtime report buffer is too small for the binary status frame."
+#endif
 
 // ---------------------------------------------------------------------------------------
 
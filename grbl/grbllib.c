@@ -154,7 +154,6 @@ int grbl_enter (void)
 #endif
 */
     sys.mpg_mode = false;
-    sys.message = NULL;
 
     driver_ok = driver_ok && hal.driver_setup(&settings);
 
@@ -193,9 +192,6 @@ int grbl_enter (void)
         bool prior_mpg_mode = sys.mpg_mode;
         uint_fast16_t prior_state = sys.state;
 
-        if(sys.message)
-            free(sys.message);
-
         memset(&sys, 0, sizeof(system_t)); // Clear system struct variable.
         set_state(prior_state);
         sys.override.feed_rate = DEFAULT_FEED_OVERRIDE;          // Set to 100%
@@ -216,8 +212,10 @@ int grbl_enter (void)
         hal.stream.reset_read_buffer(); // Clear input stream buffer
         gc_init(cold_start); // Set g-code parser to default state
         hal.limits_enable(settings.limits.flags.hard_enabled, false);
+        mc_arc_reset(); // Discard any pending arc segments.
         plan_reset(); // Clear block buffer and planner variables
         st_reset(); // Clear stepper subsystem variables.
+        pool_reset(); // Release any message and output command entries still in use.
         limits_set_homing_axes(); // Set axes to be homed from settings.
 #ifdef ENABLE_BACKLASH_COMPENSATION
         mc_backlash_init(); // Init backlash configuration.
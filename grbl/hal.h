@@ -101,6 +101,8 @@ typedef struct {
     stream_write_ptr write; // write to current I/O stream only
     stream_write_ptr write_all; // write to all active output streams
     int16_t (*read)(void);
+    uint16_t (*read_span)(char *buf, uint16_t max); // Optional, copies input up to and including the first end of line character
+                                                    // or max characters, returns count. Must be NULL when read is redirected.
     void (*reset_read_buffer)(void);
     void (*cancel_read_buffer)(void);
     bool (*suspend_read)(bool await);
@@ -22,10 +22,17 @@
 #ifndef _kinematics_h_
 #define _kinematics_h_
 
+#ifndef KINEMATICS_SEGMENT_MAX_LENGTH
+#define KINEMATICS_SEGMENT_MAX_LENGTH 25.0f // mm
+#endif
+#define KINEMATICS_SEGMENT_MIN_LENGTH 0.1f  // mm
+
 typedef struct {
     void (*convert_array_steps_to_mpos)(float *position, int32_t *steps);
     void (*plan_target_to_steps) (int32_t *target_steps, float *target);
     bool (*segment_line) (float *target, plan_line_data_t *pl_data, bool init);
+    void (*transform_from_cartesian)(float *target, float *position); // Optional, motor positions in mm without rounding to steps, required by mc_segment_line()
+    void (*transform_to_cartesian)(float *position, float *target);   // Optional, inverse of the above, required by mc_segment_line()
     uint_fast8_t (*limits_get_axis_mask)(uint_fast8_t idx);
     void (*limits_set_target_pos)(uint_fast8_t idx);
     void (*limits_set_machine_positions)(axes_signals_t cycle);
@@ -31,7 +31,6 @@
 #ifdef MASLOW_ROUTER
 
 #include "maslow.h"
-#include "driver.h"
 
 #define A_MOTOR X_AXIS // Must be X_AXIS
 #define B_MOTOR Y_AXIS // Must be Y_AXIS
@@ -195,7 +194,7 @@ status_code_t maslow_setting (setting_type_t param, float value, char *svalue)
     }
 
     if(status == Status_OK)
-        hal.eeprom.memcpy_to_with_checksum(hal.eeprom.driver_area.address, (uint8_t *)&driver_settings, sizeof(driver_settings));
+        maslow_hal.settings_save();
 
     return status;
 }
@@ -302,8 +301,8 @@ void maslow_settings_report (setting_type_t setting)
 
 void maslow_settings_restore (void)
 {
-    memcpy(&driver_settings.maslow, &maslow_defaults, sizeof(maslow_settings_t));
-    hal.eeprom.memcpy_to_with_checksum(hal.eeprom.driver_area.address, (uint8_t *)&driver_settings, sizeof(driver_settings_t));
+    memcpy(maslow_hal.settings, &maslow_defaults, sizeof(maslow_settings_t));
+    maslow_hal.settings_save();
 
 }
 
@@ -333,25 +332,6 @@ void verifyValidTarget (float* xTarget, float* yTarget)
 
 }
 
-// Maslow CNC calculation only. Returns x or y-axis "steps" based on Maslow motor steps.
-// converts current position two-chain intersection (steps) into x / y cartesian in STEPS..
-static void maslow_convert_array_steps_to_mpos (float *position, int32_t *steps)
-{
-    float a_len = ((float)steps[A_MOTOR] / settings.steps_per_mm[A_MOTOR]);
-    float b_len = ((float)steps[B_MOTOR] / settings.steps_per_mm[B_MOTOR]);
-
-    a_len = (machine.xCordOfMotor_x2_pow - powf(b_len, 2.0f) + powf(a_len, 2.0f)) / machine.xCordOfMotor_x4;
-    position[X_AXIS] = a_len - machine.xCordOfMotor;
-    a_len = maslow_hal.settings->distBetweenMotors - a_len;
-    position[Y_AXIS] = machine.yCordOfMotor - sqrtf(powf(b_len, 2.0f) - powf(a_len, 2.0f));
-    position[Z_AXIS] = steps[Z_AXIS] / settings.steps_per_mm[Z_AXIS];
-
-// back out any correction factor
-   position[X_AXIS] /= maslow_hal.settings->XcorrScaling;
-   position[Y_AXIS] /= maslow_hal.settings->YcorrScaling;
-//
-}
-
 // calculate left and right (A_MOTOR/B_MOTOR) chain lengths from X-Y cartesian coordinates  (in mm)
 // target is an absolute position in the frame
 inline static void triangularInverse (int32_t *target_steps, float *target)
@@ -369,76 +349,69 @@ inline static void triangularInverse (int32_t *target_steps, float *target)
     target_steps[B_MOTOR] = (int32_t)lround(sqrt(pow((double)machine.xCordOfMotor - xxx, 2.0f) + yyp) * settings.steps_per_mm[B_MOTOR]);
 }
 
-// Transform absolute position from cartesian coordinate system (mm) to maslow coordinate system (step)
-static void maslow_target_to_steps (int32_t *target_steps, float *target)
+// Transform cartesian position (mm) to chain lengths (mm), used for line segmentation.
+static void maslow_transform_from_cartesian (float *target, float *position)
 {
     uint_fast8_t idx = N_AXIS - 1;
 
     do {
-        target_steps[idx] = lroundf(target[idx] * settings.steps_per_mm[idx]);
+        target[idx] = position[idx];
     } while(--idx > Y_AXIS);
 
-    triangularInverse(target_steps, target);
-}
+    float xxx = position[A_MOTOR] * maslow_hal.settings->XcorrScaling;
+    float yyp = machine.yCordOfMotor - position[B_MOTOR] * maslow_hal.settings->YcorrScaling;
 
-static uint_fast8_t maslow_limits_get_axis_mask (uint_fast8_t idx)
-{
-    return ((idx == A_MOTOR) || (idx == B_MOTOR)) ? (bit(X_AXIS) | bit(Y_AXIS)) : bit(idx);
+    yyp *= yyp;
+    target[A_MOTOR] = sqrtf(powf(machine.xCordOfMotor + xxx, 2.0f) + yyp);
+    target[B_MOTOR] = sqrtf(powf(machine.xCordOfMotor - xxx, 2.0f) + yyp);
 }
 
-// MASLOW is circular in motion, so long lines must be divided up
-static bool maslow_segment_line (float *target, plan_line_data_t *pl_data, bool init)
+// Transform chain lengths (mm) to cartesian position (mm), used for line segmentation.
+static void maslow_transform_to_cartesian (float *position, float *target)
 {
-    static uint_fast16_t iterations;
-    static bool segmented;
-    static float delta[N_AXIS], segment_target[N_AXIS];
-//    static plan_line_data_t plan;
-
-    uint_fast8_t idx = N_AXIS;
-
-    if(init) {
-
-        float max_delta = 0.0f;
-
-        do {
-            idx--;
-            delta[idx] = target[idx] - gc_state.position[idx];
-            max_delta = max(max_delta, fabs(delta[idx]));
-        } while(idx);
-
-        if((segmented = !(pl_data->condition.rapid_motion || pl_data->condition.jog_motion) &&
-                          max_delta > MAX_SEG_LENGTH_MM && !(delta[X_AXIS] == 0.0f && delta[Y_AXIS] == 0.0f))) {
-
-            idx = N_AXIS;
-            iterations = (uint_fast16_t)ceilf(max_delta / MAX_SEG_LENGTH_MM);
+    uint_fast8_t idx = N_AXIS - 1;
+    float a_len = target[A_MOTOR], b_len = target[B_MOTOR];
 
-            memcpy(segment_target, gc_state.position, sizeof(segment_target));
-//            memcpy(&plan, pl_data, sizeof(plan_line_data_t));
+    do {
+        position[idx] = target[idx];
+    } while(--idx > Y_AXIS);
 
-            do {
-                delta[--idx] /= (float)iterations;
-                target[idx] = gc_state.position[idx];
-            } while(idx);
+    a_len = (machine.xCordOfMotor_x2_pow - powf(b_len, 2.0f) + powf(a_len, 2.0f)) / machine.xCordOfMotor_x4;
+    position[X_AXIS] = (a_len - machine.xCordOfMotor) / maslow_hal.settings->XcorrScaling;
+    a_len = maslow_hal.settings->distBetweenMotors - a_len;
+    position[Y_AXIS] = (machine.yCordOfMotor - sqrtf(powf(b_len, 2.0f) - powf(a_len, 2.0f))) / maslow_hal.settings->YcorrScaling;
+}
 
-        } else
-            iterations = 1;
+// Maslow CNC calculation only. Returns machine position in mm converted from system position steps,
+// the two-chain intersection of the chain lengths.
+static void maslow_convert_array_steps_to_mpos (float *position, int32_t *steps)
+{
+    uint_fast8_t idx = N_AXIS;
+    float target[N_AXIS];
 
-        iterations++; // return at least one iteration
+    do {
+        idx--;
+        target[idx] = (float)steps[idx] / settings.steps_per_mm[idx];
+    } while(idx);
 
-    } else {
+    maslow_transform_to_cartesian(position, target);
+}
 
-        iterations--;
+// Transform absolute position from cartesian coordinate system (mm) to maslow coordinate system (step)
+static void maslow_target_to_steps (int32_t *target_steps, float *target)
+{
+    uint_fast8_t idx = N_AXIS - 1;
 
-        if(segmented && iterations) do {
-            idx--;
-            segment_target[idx] += delta[idx];
-            target[idx] = segment_target[idx];
-//            memcpy(pl_data, &plan, sizeof(plan_line_data_t));
-        } while(idx);
+    do {
+        target_steps[idx] = lroundf(target[idx] * settings.steps_per_mm[idx]);
+    } while(--idx > Y_AXIS);
 
-    }
+    triangularInverse(target_steps, target);
+}
 
-    return iterations != 0;
+static uint_fast8_t maslow_limits_get_axis_mask (uint_fast8_t idx)
+{
+    return ((idx == A_MOTOR) || (idx == B_MOTOR)) ? (bit(X_AXIS) | bit(Y_AXIS)) : bit(idx);
 }
 
 static void maslow_limits_set_target_pos (uint_fast8_t idx) // fn name?
@@ -542,7 +515,7 @@ static void maslow_limits_set_machine_positions (axes_signals_t cycle)
 }
 
 // TODO: format output in grbl fashion: [...]
-status_code_t maslow_tuning (uint_fast16_t state, char *line, char *lcline)
+static status_code_t maslow_tuning (uint_fast16_t state, char *line, char *lcline)
 {
     status_code_t retval = Status_OK;
 
@@ -744,7 +717,9 @@ void maslow_init (void)
     kinematics.limits_set_machine_positions = maslow_limits_set_machine_positions;
     kinematics.plan_target_to_steps = maslow_target_to_steps;
     kinematics.convert_array_steps_to_mpos = maslow_convert_array_steps_to_mpos;
-    kinematics.segment_line = maslow_segment_line;
+    kinematics.transform_from_cartesian = maslow_transform_from_cartesian;
+    kinematics.transform_to_cartesian = maslow_transform_to_cartesian;
+    kinematics.segment_line = mc_segment_line; // MASLOW is circular in motion, so long lines must be divided up
 
     hal.driver_sys_command_execute = maslow_tuning;
 }
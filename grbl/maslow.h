@@ -36,7 +36,6 @@
 
 #define FP_SCALING 1024.0f
 #define SPROCKET_RADIUS_MM (10.1f)
-#define MAX_SEG_LENGTH_MM 2.0f /* long lines must be segmented due to circular motion */
 
   // PID position loop factors              X: Kp = 25000 Ki = 15000 Kd = 22000 Imax = 5000
   // 14.000 fixed point arithmatic S13.10
@@ -147,6 +146,7 @@ typedef struct {
 
 typedef struct {
     maslow_settings_t *settings;
+    void (*settings_save)(void); // Writes the driver settings, which hold the Maslow settings, to non-volatile storage
     void (*pid_settings_changed)(uint_fast8_t idx);
     void (*move)(uint_fast8_t idx, int_fast16_t distance);
     void (*reset_pid)(uint_fast8_t idx);
@@ -163,6 +163,5 @@ void maslow_init (void);
 status_code_t maslow_setting (setting_type_t param, float value, char *svalue);
 void maslow_settings_report (setting_type_t setting);
 void maslow_settings_restore (void);
-static status_code_t maslow_tuning (uint_fast16_t state, char *line, char *lcline);
 
 #endif
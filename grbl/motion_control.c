@@ -54,6 +54,15 @@ void mc_sync_backlash_position (void)
 
 #endif
 
+// Path blending state for mc_blend_line(). The last line is held back until the next line is known.
+static struct {
+    bool pending;               // Line held back
+    float millimeters;          // Programmed length of line (mm)
+    float unit_vec[N_AXIS];     // Direction of line
+    float target[N_AXIS];       // End of line (mm), the corner with the next line
+    plan_line_data_t pl_data;
+} blend = {0};
+
 // Execute linear motion in absolute millimeter coordinates. Feed rate given in millimeters/second
 // unless invert_feed_rate is true. Then the feed_rate means that the motion should be completed in
 // (1 minute)/feed_rate time.
@@ -63,6 +72,8 @@ void mc_sync_backlash_position (void)
 // in the planner and to let backlash compensation or canned cycle integration simple and direct.
 bool mc_line (float *target, plan_line_data_t *pl_data)
 {
+    if(blend.pending && !mc_blend_resume(true)) // Queue any held back blended line first.
+        return false;
 
     // If enabled, check for soft limit violations. Placed here all line motions are picked up
     // from everywhere in Grbl.
@@ -170,6 +181,173 @@ bool mc_line (float *target, plan_line_data_t *pl_data)
     return !ABORTED;
 }
 
+#ifdef KINEMATICS_API
+
+// Line segmentation state for mc_segment_line().
+static struct {
+    bool segmented;
+    bool pending;               // Unsegmented line not yet returned
+    float distance;             // Remaining distance of line (mm)
+    float segment_length;       // Length of last segment (mm)
+    float unit_vec[N_AXIS];     // Direction of line
+    float position[N_AXIS];     // Start of next segment (mm)
+    float joints[N_AXIS];       // Motor positions at start of next segment (mm)
+    float target[N_AXIS];       // End of line (mm)
+} seg = {0};
+
+// Returns the distance between the midpoint of a segment of the line and the point reached when the
+// motors are halfway between the positions for its start and end, and the segment end point in end
+// and joints_end. Returns NaN if the midpoint is not reachable.
+static float segment_error (float length, float *end, float *joints_end)
+{
+    uint_fast8_t idx = N_AXIS;
+    float joints_mid[N_AXIS], mid[N_AXIS], error = 0.0f;
+
+    do {
+        idx--;
+        end[idx] = seg.position[idx] + seg.unit_vec[idx] * length;
+    } while(idx);
+
+    kinematics.transform_from_cartesian(joints_end, end);
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        joints_mid[idx] = (seg.joints[idx] + joints_end[idx]) * 0.5f;
+    } while(idx);
+
+    kinematics.transform_to_cartesian(mid, joints_mid);
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        mid[idx] -= (seg.position[idx] + end[idx]) * 0.5f;
+        error += mid[idx] * mid[idx];
+    } while(idx);
+
+    return sqrtf(error);
+}
+
+// Splits feed motions into segments with a deviation from the straight line, estimated at the segment
+// midpoint, within the arc tolerance. Since the deviation grows with the square of the segment length
+// the length is scaled from the error of a trial segment, starting out from twice the length of the
+// previous segment. Segments are thus long where the kinematics is close to linear and short where
+// it is not, e.g. near the edges of the work area for cable driven machines.
+bool mc_segment_line (float *target, plan_line_data_t *pl_data, bool init)
+{
+    uint_fast8_t idx = N_AXIS;
+
+    if(init) {
+
+        int32_t *position_steps = plan_get_position(), steps[N_AXIS];
+
+        // The line starts at the end of the previous line unless the planner position has been changed since,
+        // e.g. by homing, probing or a reset. Then the line starts at the planner position.
+        kinematics.plan_target_to_steps(steps, seg.target);
+        if(memcmp(steps, position_steps, sizeof(steps)))
+            kinematics.convert_array_steps_to_mpos(seg.target, position_steps);
+
+        memcpy(seg.position, seg.target, sizeof(seg.position));
+        memcpy(seg.target, target, sizeof(seg.target));
+
+        seg.distance = 0.0f;
+        do {
+            idx--;
+            seg.unit_vec[idx] = seg.target[idx] - seg.position[idx];
+            seg.distance += seg.unit_vec[idx] * seg.unit_vec[idx];
+        } while(idx);
+        seg.distance = sqrtf(seg.distance);
+
+        if((seg.segmented = !(pl_data->condition.rapid_motion || pl_data->condition.jog_motion) &&
+                             seg.distance > KINEMATICS_SEGMENT_MIN_LENGTH &&
+                              !(seg.unit_vec[X_AXIS] == 0.0f && seg.unit_vec[Y_AXIS] == 0.0f))) {
+
+            idx = N_AXIS;
+            do {
+                idx--;
+                seg.unit_vec[idx] /= seg.distance;
+            } while(idx);
+
+            kinematics.transform_from_cartesian(seg.joints, seg.position);
+
+            if(seg.segment_length < KINEMATICS_SEGMENT_MIN_LENGTH)
+                seg.segment_length = KINEMATICS_SEGMENT_MIN_LENGTH;
+
+            // Inverse time applies to the line, convert to the corresponding feed rate for the segments.
+            if(pl_data->condition.inverse_time) {
+                pl_data->feed_rate *= seg.distance;
+                pl_data->condition.inverse_time = Off;
+            }
+        } else
+            seg.pending = true;
+
+        return true;
+    }
+
+    if(!seg.segmented) {
+        bool pending = seg.pending;
+        seg.pending = false;
+        return pending;
+    }
+
+    if(seg.distance <= 0.0f)
+        return false;
+
+    uint_fast8_t retries = 4;
+    float length = min(seg.segment_length * 2.0f, KINEMATICS_SEGMENT_MAX_LENGTH), error, scale;
+    float end[N_AXIS], joints_end[N_AXIS];
+
+    do {
+        // Do not leave a remainder shorter than the minimum segment length.
+        if(seg.distance - length < KINEMATICS_SEGMENT_MIN_LENGTH)
+            length = seg.distance;
+
+        error = segment_error(length, end, joints_end);
+
+        if(error <= settings.arc_tolerance || length <= KINEMATICS_SEGMENT_MIN_LENGTH)
+            break;
+
+        scale = error > 0.0f ? 0.9f * sqrtf(settings.arc_tolerance / error) : 0.5f; // Error is NaN if not reachable.
+        length *= scale < 0.25f ? 0.25f : (scale > 0.9f ? 0.9f : scale);
+
+        if(length < KINEMATICS_SEGMENT_MIN_LENGTH)
+            length = KINEMATICS_SEGMENT_MIN_LENGTH;
+
+    } while(--retries);
+
+    if(length >= seg.distance) {
+        seg.distance = 0.0f;
+        memcpy(target, seg.target, sizeof(seg.target));
+    } else {
+        seg.distance -= length;
+        seg.segment_length = length;
+        memcpy(target, end, sizeof(end));
+        memcpy(seg.position, end, sizeof(end));
+        memcpy(seg.joints, joints_end, sizeof(joints_end));
+    }
+
+    return true;
+}
+
+#endif
+
+// Arc generator state. Segments are generated on demand by mc_arc_resume() as planner space frees up.
+static struct {
+    bool active;
+    plane_t plane;
+    uint16_t segments;          // Number of segments, the last segment ends at target
+    uint16_t segment;           // Last segment generated
+    uint_fast8_t count;         // Segments generated since last exact radius vector correction
+    float center[2];            // Circle center
+    float r0[2];                // Radius vector from center to start position
+    float r[2];                 // Radius vector from center to last segment end point
+    float theta_per_segment;
+    float linear_per_segment;
+    float cos_T, sin_T;
+    float position[N_AXIS];     // End point of last segment
+    float target[N_AXIS];
+    plan_line_data_t pl_data;
+} arc = {0};
 
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_X defines circle plane in tool space, axis_linear is
@@ -178,9 +356,15 @@ bool mc_line (float *target, plan_line_data_t *pl_data)
 // The arc is approximated by generating a huge number of tiny, linear segments. The chordal tolerance
 // of each segment is configured in settings.arc_tolerance, which is defined to be the maximum normal
 // distance from segment to the circle when the end points both lie on the circle.
+// NOTE: Only the segments fitting in the planner buffer are queued here, the arc generator takes ownership
+//       of the message and output commands in pl_data and the remaining segments are queued by mc_arc_resume()
+//       from the protocol loop. position is not changed.
 void mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
               plane_t plane, bool is_clockwise_arc)
 {
+    if(!mc_arc_resume(true)) // Complete any pending arc first.
+        return;
+
     float center_axis0 = position[plane.axis_0] + offset[plane.axis_0];
     float center_axis1 = position[plane.axis_1] + offset[plane.axis_1];
     float r_axis0 = -offset[plane.axis_0];  // Radius vector from center to current location
@@ -199,24 +383,107 @@ void mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *o
             angular_travel += 2.0f * M_PI;
     }
 
+#ifdef ENABLE_NATIVE_ARCS
+
+    // Plan the arc as a single block, the step segment generator computes the segment end points on the arc.
+    plan_arc_t arc_data = {
+        .plane = plane,
+        .center[0] = center_axis0,
+        .center[1] = center_axis1,
+        .r0[0] = r_axis0,
+        .r0[1] = r_axis1,
+        .angular_travel = angular_travel
+    };
+
+    // Soft limits are checked at the target by mc_line(), the arc may extend beyond the box spanned by its
+    // start and target in the plane axes so also check the points on the arc where a plane axis is at its extreme.
+    if(settings.limits.flags.soft_enabled && !pl_data->condition.jog_motion) {
+
+        uint_fast8_t quadrant = 4;
+        float extreme[N_AXIS], angle, start_angle = atan2f(r_axis1, r_axis0);
+
+        memcpy(extreme, target, sizeof(extreme));
+
+        do {
+            angle = (float)--quadrant * (float)(M_PI / 2.0) - start_angle;   // CCW angle from start to extreme,
+            if(angular_travel < 0.0f)                                       // or CW angle for clockwise arcs.
+                angle = -angle;
+            while(angle < 0.0f)
+                angle += 2.0f * M_PI;
+            while(angle >= 2.0f * M_PI)
+                angle -= 2.0f * M_PI;
+            if(angle <= fabsf(angular_travel)) {
+                extreme[plane.axis_0] = center_axis0 + (quadrant == 0 ? radius : (quadrant == 2 ? -radius : 0.0f));
+                extreme[plane.axis_1] = center_axis1 + (quadrant == 1 ? radius : (quadrant == 3 ? -radius : 0.0f));
+                if(!system_check_travel_limits(extreme)) {
+                    limits_soft_check(extreme);
+                    return;
+                }
+            }
+        } while(quadrant);
+    }
+
+    pl_data->arc = &arc_data;
+    mc_line(target, pl_data);
+    pl_data->arc = NULL;
+
+    return;
+
+#endif
+
     // NOTE: Segment end points are on the arc, which can lead to the arc diameter being smaller by up to
     // (2x) settings.arc_tolerance. For 99% of users, this is just fine. If a different arc segment fit
     // is desired, i.e. least-squares, midpoint on arc, just change the mm_per_arc_segment calculation.
     // For the intended uses of Grbl, this value shouldn't exceed 2000 for the strictest of cases.
-    uint16_t segments = (uint16_t)floorf(fabsf(0.5f * angular_travel * radius) / sqrtf(settings.arc_tolerance * (2.0f * radius - settings.arc_tolerance)));
+    uint32_t segments = (uint32_t)floorf(fabsf(0.5f * angular_travel * radius) / sqrtf(settings.arc_tolerance * (2.0f * radius - settings.arc_tolerance)));
+
+    // With a coarse arc tolerance the junction speed between segments, computed by the planner from the
+    // junction deviation, may be lower than the speed the machine can follow the arc at. Add segments
+    // until the junction speed limit allows the lower of the feed rate and the centripetal acceleration
+    // limited speed, but not so many that segments become shorter than the distance travelled in one
+    // step segment (DT_SEGMENT) since the planner would then starve. Segments are never fewer than
+    // required by the arc tolerance.
+    if(!(pl_data->condition.inverse_time || pl_data->condition.rapid_motion) && pl_data->feed_rate > 0.0f && settings.junction_deviation > 0.0f) {
+
+        float acceleration = min(settings.acceleration[plane.axis_0], settings.acceleration[plane.axis_1]);
+        float speed = min(pl_data->feed_rate, sqrtf(acceleration * radius));
+        float max_segments = fabsf(angular_travel * radius) * (float)(ACCELERATION_TICKS_PER_SECOND * 60) / speed;
+        float accel_segments = min(max_segments, fabsf(angular_travel) * speed / sqrtf(8.0f * acceleration * settings.junction_deviation));
+
+        if(accel_segments > (float)segments)
+            segments = (uint32_t)accel_segments;
+    }
+
+    if(segments > UINT16_MAX)
+        segments = UINT16_MAX;
+
+    arc.active = true;
+    arc.plane = plane;
+    arc.segments = (uint16_t)segments;
+    arc.segment = arc.count = 0;
+    arc.center[0] = center_axis0;
+    arc.center[1] = center_axis1;
+    arc.r0[0] = arc.r[0] = r_axis0;
+    arc.r0[1] = arc.r[1] = r_axis1;
+    memcpy(arc.position, position, sizeof(arc.position));
+    memcpy(arc.target, target, sizeof(arc.target));
+    memcpy(&arc.pl_data, pl_data, sizeof(plan_line_data_t));
+
+    pl_data->message = NULL;            // Message and output commands are now owned by the arc generator,
+    pl_data->output_commands = NULL;    // they are queued with the first segment.
 
     if (segments) {
 
         // Multiply inverse feed_rate to compensate for the fact that this movement is approximated
         // by a number of discrete segments. The inverse feed_rate should be correct for the sum of
         // all segments.
-        if (pl_data->condition.inverse_time) {
-            pl_data->feed_rate *= segments;
-            pl_data->condition.inverse_time = Off; // Force as feed absolute mode over arc segments.
+        if (arc.pl_data.condition.inverse_time) {
+            arc.pl_data.feed_rate *= segments;
+            arc.pl_data.condition.inverse_time = Off; // Force as feed absolute mode over arc segments.
         }
 
-        float theta_per_segment = angular_travel/segments;
-        float linear_per_segment = (target[plane.axis_linear] - position[plane.axis_linear]) / segments;
+        arc.theta_per_segment = angular_travel / segments;
+        arc.linear_per_segment = (target[plane.axis_linear] - position[plane.axis_linear]) / segments;
 
     /* Vector rotation by transformation matrix: r is the original vector, r_T is the rotated vector,
        and phi is the angle of rotation. Solution approach by Jens Geisler.
@@ -245,45 +512,220 @@ void mc_arc (float *target, plan_line_data_t *pl_data, float *position, float *o
     */
 
         // Computes: cos_T = 1 - theta_per_segment^2/2, sin_T = theta_per_segment - theta_per_segment^3/6) in ~52usec
-        float cos_T = 2.0f - theta_per_segment * theta_per_segment;
-        float sin_T = theta_per_segment * 0.16666667f * (cos_T + 4.0f);
-        cos_T *= 0.5f;
+        arc.cos_T = 2.0f - arc.theta_per_segment * arc.theta_per_segment;
+        arc.sin_T = arc.theta_per_segment * 0.16666667f * (arc.cos_T + 4.0f);
+        arc.cos_T *= 0.5f;
+    }
 
-        float sin_Ti;
-        float cos_Ti;
-        float r_axisi;
-        uint32_t i, count = 0;
+    mc_arc_resume(false);
+}
+
+// Queue segments of a pending arc, if complete is false only until the planner buffer is full.
+// Called from the protocol loop, a pending arc has to be completed before any other motion is queued.
+// Returns false if aborted.
+bool mc_arc_resume (bool complete)
+{
+    float r_axisi, cos_Ti, sin_Ti;
 
-        for (i = 1; i < segments; i++) { // Increment (segments-1).
+    while(arc.active) {
 
-            if (count < N_ARC_CORRECTION) {
+        if(ABORTED)
+            arc.active = false; // Discard remaining segments on system abort or cancel.
+        else if(!complete && plan_check_full_buffer())
+            break;              // Continue when there is room for more segments.
+        else if(++arc.segment < arc.segments) { // Intermediate segment.
+
+            if (arc.count < N_ARC_CORRECTION) {
                 // Apply vector rotation matrix. ~40 usec
-                r_axisi = r_axis0 * sin_T + r_axis1 * cos_T;
-                r_axis0 = r_axis0 * cos_T - r_axis1 * sin_T;
-                r_axis1 = r_axisi;
-                count++;
+                r_axisi = arc.r[0] * arc.sin_T + arc.r[1] * arc.cos_T;
+                arc.r[0] = arc.r[0] * arc.cos_T - arc.r[1] * arc.sin_T;
+                arc.r[1] = r_axisi;
+                arc.count++;
             } else {
                 // Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments. ~375 usec
                 // Compute exact location by applying transformation matrix from initial radius vector(=-offset).
-                cos_Ti = cosf(i * theta_per_segment);
-                sin_Ti = sinf(i * theta_per_segment);
-                r_axis0 = -offset[plane.axis_0] * cos_Ti + offset[plane.axis_1] * sin_Ti;
-                r_axis1 = -offset[plane.axis_0] * sin_Ti - offset[plane.axis_1] * cos_Ti;
-                count = 0;
+                cos_Ti = cosf(arc.segment * arc.theta_per_segment);
+                sin_Ti = sinf(arc.segment * arc.theta_per_segment);
+                arc.r[0] = arc.r0[0] * cos_Ti - arc.r0[1] * sin_Ti;
+                arc.r[1] = arc.r0[0] * sin_Ti + arc.r0[1] * cos_Ti;
+                arc.count = 0;
             }
 
             // Update arc_target location
-            position[plane.axis_0] = center_axis0 + r_axis0;
-            position[plane.axis_1] = center_axis1 + r_axis1;
-            position[plane.axis_linear] += linear_per_segment;
+            arc.position[arc.plane.axis_0] = arc.center[0] + arc.r[0];
+            arc.position[arc.plane.axis_1] = arc.center[1] + arc.r[1];
+            arc.position[arc.plane.axis_linear] += arc.linear_per_segment;
 
             // Bail mid-circle on system abort. Runtime command check already performed by mc_line.
-            if(!mc_line(position, pl_data))
-                return;
+            arc.active = mc_line(arc.position, &arc.pl_data);
+
+        } else {
+            // Ensure last segment arrives at target location.
+            mc_line(arc.target, &arc.pl_data);
+            arc.active = false;
+        }
+
+        if(!arc.active) {
+            // Message is not queued with a segment if no motion was planned, e.g. in check mode.
+            if(arc.pl_data.message)
+                protocol_message(arc.pl_data.message);
+            output_commands_release(arc.pl_data.output_commands);
         }
     }
-    // Ensure last segment arrives at target location.
-    mc_line(target, pl_data);
+
+    return !ABORTED;
+}
+
+// Discard any pending arc without releasing its message and output commands and any held back blended
+// line, called on soft reset before the pools are reset.
+void mc_arc_reset (void)
+{
+    arc.active = blend.pending = false;
+}
+
+// Execute linear motion in path blending mode (G64 P). The line is held back until the next line is known,
+// the corner between them is then rounded by a circular blend tangent to both lines that deviates no more
+// than the path tolerance from the corner point. The tangent points are limited to the half of the lines
+// nearest the corner so that blends do not overlap. The blend is queued as line segments with the arc
+// tolerance, capped to a quarter of the path tolerance, as chordal tolerance and with segments added
+// so that the junction speed between them is not lower than the speed the blend can be followed at.
+// Corners that are near straight or reversing are not blended, nor are lines carrying a message or output
+// commands or lines in inverse time or spindle synchronized motion. position == start of line.
+// NOTE: The held back line is queued by the next motion, by protocol_buffer_synchronize() or by
+//       mc_blend_resume() from the protocol loop when the planner has run empty.
+void mc_blend_line (float *target, plan_line_data_t *pl_data, float *position)
+{
+    uint_fast8_t idx = N_AXIS;
+    float millimeters = 0.0f, unit_vec[N_AXIS];
+
+    if(sys.state == STATE_CHECK_MODE || pl_data->message || pl_data->output_commands ||
+        pl_data->condition.inverse_time || pl_data->condition.spindle.synchronized) {
+        mc_line(target, pl_data);
+        return;
+    }
+
+    do {
+        idx--;
+        unit_vec[idx] = target[idx] - position[idx];
+        millimeters += unit_vec[idx] * unit_vec[idx];
+    } while(idx);
+
+    if((millimeters = sqrtf(millimeters)) == 0.0f) {
+        mc_line(target, pl_data);
+        return;
+    }
+
+    if(settings.limits.flags.soft_enabled)
+        limits_soft_check(target);
+
+    idx = N_AXIS;
+    do {
+        unit_vec[--idx] /= millimeters;
+    } while(idx);
+
+    if(blend.pending) {
+
+        float cos_theta = 0.0f; // Cosine of the direction change at the corner.
+
+        idx = N_AXIS;
+        do {
+            idx--;
+            cos_theta += blend.unit_vec[idx] * unit_vec[idx];
+        } while(idx);
+
+        blend.pending = false;
+
+        if(cos_theta < 0.999999f && cos_theta > -0.999999f) {
+
+            // Trig half angle identities. Blend radius from the deviation d of its midpoint from the corner
+            // point: r = d * cos(theta/2) / (1 - cos(theta/2)), distance from corner to tangent points is
+            // r * tan(theta/2). The chordal tolerance of the segments is subtracted from the deviation.
+            float cos_theta_d2 = sqrtf(0.5f * (1.0f + cos_theta)), sin_theta_d2 = sqrtf(0.5f * (1.0f - cos_theta));
+            float tolerance = min(settings.arc_tolerance, 0.25f * pl_data->path_tolerance);
+            float radius = (pl_data->path_tolerance - tolerance) * cos_theta_d2 / (1.0f - cos_theta_d2);
+            float tangent = radius * sin_theta_d2 / cos_theta_d2;
+
+            if(tangent > 0.5f * min(blend.millimeters, millimeters)) {
+                tangent = 0.5f * min(blend.millimeters, millimeters);
+                radius = tangent * cos_theta_d2 / sin_theta_d2;
+            }
+
+            float theta = acosf(cos_theta), center[N_AXIS], r0[N_AXIS], point[N_AXIS];
+            uint32_t segment, segments = radius > tolerance ? (uint32_t)ceilf(0.5f * theta * radius / sqrtf(tolerance * (2.0f * radius - tolerance))) : 1;
+
+            // Add segments until the junction speed between segments allows the speed the blend can be followed at,
+            // see mc_arc() for details.
+            if(pl_data->feed_rate > 0.0f && settings.junction_deviation > 0.0f) {
+
+                float acceleration = min(limit_value_by_axis_maximum(settings.acceleration, blend.unit_vec),
+                                          limit_value_by_axis_maximum(settings.acceleration, unit_vec));
+                float speed = min(pl_data->feed_rate, sqrtf(acceleration * radius));
+                float max_segments = theta * radius * (float)(ACCELERATION_TICKS_PER_SECOND * 60) / speed;
+                float accel_segments = min(max_segments, theta * speed / sqrtf(8.0f * acceleration * settings.junction_deviation));
+
+                if(accel_segments > (float)segments)
+                    segments = (uint32_t)accel_segments;
+            }
+
+            // Blend start point and circle: point = center + r0 * cos(angle) + unit_vec * radius * sin(angle).
+            idx = N_AXIS;
+            do {
+                idx--;
+                point[idx] = blend.target[idx] - blend.unit_vec[idx] * tangent;
+                center[idx] = blend.target[idx] + (unit_vec[idx] - blend.unit_vec[idx]) * (0.5f * radius / (sin_theta_d2 * cos_theta_d2));
+                r0[idx] = point[idx] - center[idx];
+            } while(idx);
+
+            if(!mc_line(point, &blend.pl_data))
+                return;
+
+            for(segment = 1; segment < segments; segment++) {
+
+                float angle = theta * (float)segment / (float)segments, cos_a = cosf(angle), sin_a = sinf(angle) * radius;
+
+                idx = N_AXIS;
+                do {
+                    idx--;
+                    point[idx] = center[idx] + r0[idx] * cos_a + blend.unit_vec[idx] * sin_a;
+                } while(idx);
+
+                if(!mc_line(point, pl_data))
+                    return;
+            }
+
+            // Ensure last segment arrives at the tangent point of the next line.
+            idx = N_AXIS;
+            do {
+                idx--;
+                point[idx] = blend.target[idx] + unit_vec[idx] * tangent;
+            } while(idx);
+
+            if(!mc_line(point, pl_data))
+                return;
+
+        } else if(!mc_line(blend.target, &blend.pl_data))
+            return;
+    }
+
+    blend.pending = true;
+    blend.millimeters = millimeters;
+    memcpy(blend.unit_vec, unit_vec, sizeof(unit_vec));
+    memcpy(blend.target, target, sizeof(blend.target));
+    memcpy(&blend.pl_data, pl_data, sizeof(plan_line_data_t));
+}
+
+// Queue a held back blended line, if complete is false only when the planner has run empty.
+// Called from the protocol loop, the line has to be queued before any other motion.
+// Returns false if aborted, the line is then discarded.
+bool mc_blend_resume (bool complete)
+{
+    if(blend.pending && (complete || ABORTED || plan_get_current_block() == NULL)) {
+        blend.pending = false;
+        if(!ABORTED)
+            mc_line(blend.target, &blend.pl_data);
+    }
+
+    return !ABORTED;
 }
 
 
@@ -40,10 +40,33 @@ bool mc_line(float *target, plan_line_data_t *pl_data);
 // Execute an arc in offset mode format. position == current xyz, target == target xyz,
 // offset == offset from current xyz, axis_XXX defines circle plane in tool space, axis_linear is
 // the direction of helical travel, radius == circle radius, is_clockwise_arc boolean. Used
-// for vector transformation direction.
+// for vector transformation direction. Segments not fitting in the planner buffer are queued later
+// by mc_arc_resume().
 void mc_arc(float *target, plan_line_data_t *pl_data, float *position, float *offset, float radius,
   plane_t plane, bool is_clockwise_arc);
 
+// Queue segments of a pending arc, if complete is false only until the planner buffer is full.
+// Returns false if aborted.
+bool mc_arc_resume (bool complete);
+
+// Discard any pending arc and any held back blended line, called on soft reset.
+void mc_arc_reset (void);
+
+// Execute linear motion in path blending mode (G64 P), the corner with the next line is rounded within
+// the path tolerance in pl_data. position == current xyz. The line is held back until the next motion.
+void mc_blend_line (float *target, plan_line_data_t *pl_data, float *position);
+
+// Queue a held back blended line, if complete is false only when the planner has run empty.
+// Returns false if aborted.
+bool mc_blend_resume (bool complete);
+
+#ifdef KINEMATICS_API
+// Line segmentation for kinematics where linear motor motion does not result in a straight line, to be
+// assigned to kinematics.segment_line. Segment lengths are adapted to the kinematics at the current position
+// to keep the deviation from the straight line within the arc tolerance.
+bool mc_segment_line (float *target, plan_line_data_t *pl_data, bool init);
+#endif
+
 // Execute canned cycle (drill)
 void mc_canned_drill (motion_mode_t motion, float *target, plan_line_data_t *pl_data, float *position, plane_t plane, uint32_t repeats, gc_canned_t *canned);
 
@@ -23,22 +23,36 @@
 #include "grbl.h"
 
 #define MAX_PRECISION 10
+#define MAX_SIG_DIGITS 19 // Max significant digits read by read_float(), fits in uint64_t
+
+static char buf[20 + MAX_PRECISION + 3]; // uint64_t digits, decimal point, sign and terminator
+
+static const uint64_t pow10_int[MAX_SIG_DIGITS + 1] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL
+};
 
-static char buf[STRLEN_COORDVALUE + 1];
-
-static const float froundvalues[MAX_PRECISION + 1] =
-{
-    0.5,                // 0
-    0.05,               // 1
-    0.005,              // 2
-    0.0005,             // 3
-    0.00005,            // 4
-    0.000005,           // 5
-    0.0000005,          // 6
-    0.00000005,         // 7
-    0.000000005,        // 8
-    0.0000000005,       // 9
-    0.00000000005       // 10
+// Powers of ten exactly representable as float
+static const float pow10_float[MAX_PRECISION + 1] = {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
 };
 
 char const *const axis_letter[N_AXIS] = {
@@ -74,76 +88,187 @@ char *uitoa (uint32_t n)
 }
 
 // Convert float to string by immediately converting to integers.
-// Number of decimal places, which are tracked by a counter, must be set by the user.
-// The integers is then efficiently converted to a string.
+// The binary value is scaled by the power of ten for the number of decimal places and rounded half to even
+// using 64 bit integer arithmetic, the result is thus exactly rounded for all values less than 2^64.
 char *ftoa (float n, uint8_t decimal_places)
 {
-    bool isNegative;
+    union {
+        float f;
+        uint32_t u;
+    } bits = { .f = n };
+    bool isNegative = n < 0.0f;
+    int_fast16_t exp = (int_fast16_t)((bits.u >> 23) & 0xFF);
+    uint_fast8_t digits = 0;
+    uint64_t value = bits.u & 0x7FFFFF;
+    uint32_t v;
     char *bptr = buf + sizeof(buf);
 
     *--bptr = '\0';
 
-    if ((isNegative = n < 0.0f))
-        n = -n;
+    if(decimal_places > MAX_PRECISION)
+        decimal_places = MAX_PRECISION;
+
+    // Value is mantissa * 2^exp
+    if(exp)
+        value |= 0x800000;
+    else
+        exp = 1; // Subnormal
+    exp -= 150;
+
+    if(exp >= 0) {
+        // Integer, no fractional digits to compute.
+        value = exp > 40 ? UINT64_MAX : value << exp;
+        while(digits < decimal_places) {
+            *--bptr = '0';
+            digits++;
+        }
+        *--bptr = '.';
+    } else {
+        if(exp < -58)
+            value = 0; // Scaled value below 2^58 is less than half of the last decimal place
+        else {
+            uint_fast8_t shift = (uint_fast8_t)-exp;
+            uint64_t scaled = value * pow10_int[decimal_places], half = 1ULL << (shift - 1), rem;
+
+            value = scaled >> shift;
+            rem = scaled & ((half << 1) - 1);
+
+            if(rem > half || (rem == half && (value & 1)))
+                value++;
+        }
+        if(decimal_places == 0)
+            *--bptr = '.'; // Always add decimal point (TODO: is this really needed?)
+    }
 
-    n += froundvalues[decimal_places];
+    // Get digits, using 32 bit arithmetic when value allows.
 
-    uint32_t a = (uint32_t)n;
+    while(value > UINT32_MAX) {
+        *--bptr = '0' + (char)(value % 10);
+        value /= 10;
+        if(++digits == decimal_places)
+            *--bptr = '.';
+    }
 
-    if (decimal_places) {
+    v = (uint32_t)value;
 
-        n -= (float)a;
+    while(digits < decimal_places) {
+        *--bptr = '0' + (char)(v % 10);
+        v /= 10;
+        if(++digits == decimal_places)
+            *--bptr = '.';
+    }
 
-        uint_fast8_t decimals = decimal_places;
-        while (decimals >= 2) { // Quickly convert values expected to be E0 to E-4.
-            n *= 100.0f;
-            decimals -= 2;
-        }
+    if(v || digits <= decimal_places) do {
+        *--bptr = '0' + (char)(v % 10);
+        v /= 10;
+    } while(v);
 
-        if (decimals)
-            n *= 10.0f;
+    if(isNegative)
+        *--bptr = '-';
 
-        uint32_t b = (uint32_t)n;
+    return bptr;
+}
 
-        while(decimal_places--) {
-            if(b) {
-                *--bptr = (b % 10) + '0'; // Get digit
-                b /= 10;
-            } else
-                *--bptr = '0';
+// Returns n / d correctly rounded to float, sticky is set if n is truncated.
+// Binary long division in 64 bit integer arithmetic, used when the float division in read_float() is not exact.
+static float udiv_to_float (uint64_t n, uint64_t d, bool sticky)
+{
+    bool carry, round;
+    int_fast16_t exp = 0;
+    uint_fast8_t bits = 0, shift;
+    uint64_t q = n / d, r = n % d;
+    union {
+        float f;
+        uint32_t u;
+    } result;
+
+    while(bits < 64 && (q >> bits))
+        bits++;
+
+    // Extend quotient with fractional bits until 24 bits, round bit and one more are available.
+    while(bits < 26) {
+        carry = (r >> 63) != 0;
+        r <<= 1;
+        q <<= 1;
+        if(carry || r >= d) {
+            r -= d;
+            q |= 1;
         }
+        exp--;
+        if(q)
+            bits++;
     }
 
-    *--bptr = '.'; // Always add decimal point (TODO: is this really needed?)
-
-    if(a == 0)
-        *--bptr = '0';
+    shift = bits - 24;
+    round = ((q >> (shift - 1)) & 1) != 0;
+    sticky = sticky || r != 0 || (q & ((1ULL << (shift - 1)) - 1)) != 0;
+    q >>= shift;
+    exp += shift;
 
-    else while(a) {
-        *--bptr = (a % 10) + '0'; // Get digit
-        a /= 10;
+    if(round && (sticky || (q & 1)) && ++q == (1UL << 24)) {
+        q >>= 1;
+        exp++;
     }
 
-    if(isNegative)
-        *--bptr = '-';
+    result.u = ((uint32_t)(exp + 150) << 23) | ((uint32_t)q & 0x7FFFFF);
 
-    return bptr;
+    return result.f;
 }
 
-// Extracts a floating point value from a string. The following code is based loosely on
-// the avr-libc strtod() function by Michael Stumpf and Dmitry Xmelkov and many freely
-// available conversion method examples, but has been highly optimized for Grbl. For known
-// CNC applications, the typical decimal value is expected to be in the range of E0 to E-4.
-// Scientific notation is officially not supported by g-code, and the 'E' character may
-// be a g-code word on some CNC systems. So, 'E' notation will not be recognized.
+// Returns the sign of n / 10^k - (value(u) + value(u + 1)) / 2, where u is the bit pattern of a positive normal float
+// and value(u + 1) = (mantissa + 1) * 2^exp also when the exponent of u + 1 is one higher.
+// The comparison is exact and fits in 64 bits for n < 2^30, k <= MAX_PRECISION and u within a few units of n / 10^k.
+static int_fast8_t cmp_midpoint (uint32_t n, uint_fast8_t k, uint32_t u)
+{
+    int_fast16_t exp = (int_fast16_t)(u >> 23) - 150;
+    uint64_t lhs = n, rhs = (uint64_t)(((u & 0x7FFFFF) | 0x800000) * 2 + 1) * pow10_int[k];
+
+    // Compare n * 2^(1 - exp) with (2 * mantissa + 1) * 10^k
+    if(exp <= 1)
+        lhs <<= 1 - exp;
+    else
+        rhs <<= exp - 1;
+
+    return lhs > rhs ? 1 : (lhs < rhs ? -1 : 0);
+}
+
+// Returns n / 10^k correctly rounded to float for n < 2^30 and k <= MAX_PRECISION, used when n is too large to be
+// converted exactly. The float division is then within two units in the last place of the result, it is corrected
+// by comparing n / 10^k with the midpoints to the neighbouring floats, rounding ties to even.
+static float udiv_pow10_to_float (uint32_t n, uint_fast8_t k)
+{
+    union {
+        float f;
+        uint32_t u;
+    } result = { .f = (float)n / pow10_float[k] };
+    int_fast8_t cmp;
+
+    while((cmp = cmp_midpoint(n, k, result.u)) > 0 || (cmp == 0 && (result.u & 1)))
+        result.u++;
+
+    while((cmp = cmp_midpoint(n, k, result.u - 1)) < 0 || (cmp == 0 && (result.u & 1)))
+        result.u--;
+
+    return result.f;
+}
+
+// Extracts a floating point value from a string. For known CNC applications, the typical decimal value
+// is expected to be in the range of E0 to E-4. Scientific notation is officially not supported by g-code,
+// and the 'E' character may be a g-code word on some CNC systems. So, 'E' notation will not be recognized.
+// Up to MAX_SIG_DIGITS significant digits are converted to an integer, this is converted to float by a single
+// exact float division when the integer and the power of ten are exactly representable, else by a float division
+// corrected in integer arithmetic for up to nine digits and by 64 bit integer division for more. The result is
+// correctly rounded in all cases.
 // NOTE: Thanks to Radu-Eosif Mihailescu for identifying the issues with using strtod().
 bool read_float (char *line, uint_fast8_t *char_counter, float *float_ptr)
 {
     char c, *ptr = line + *char_counter;
-    int_fast8_t exp = 0;
+    int_fast16_t exp = 0;
     uint_fast8_t ndigit = 0;
     uint32_t intval = 0;
-    bool isnegative, isdecimal = false;
+    uint64_t intval64 = 0;
+    bool isnegative, isdecimal = false, isnumber = false, truncated = false;
+    float fval;
 
     // Grab first character and increment pointer. No spaces assumed in line.
     c = *ptr++;
@@ -152,17 +277,26 @@ bool read_float (char *line, uint_fast8_t *char_counter, float *float_ptr)
     if ((isnegative = (c == '-')) || c == '+')
         c = *ptr++;
 
-    // Extract number into fast integer. Track decimal in terms of exponent value.
+    // Extract significant digits into integer, 32 bit for the first nine. Track decimal in terms of exponent value.
     while(true) {
         c -= '0';
         if (c <= 9) {
-            ndigit++;
-            if (ndigit <= MAX_INT_DIGITS) {
+            isnumber = true;
+            if (ndigit < MAX_SIG_DIGITS) {
                 if (isdecimal)
                     exp--;
-                intval = (((intval << 2) + intval) << 1) + c; // intval*10 + c
-            } else if (!isdecimal)
-                exp++;  // Drop overflow digits
+                if (c || ndigit) { // Skip leading zeros
+                    if (ndigit < 9)
+                        intval = (((intval << 2) + intval) << 1) + c; // intval*10 + c
+                    else
+                        intval64 = (ndigit == 9 ? (uint64_t)intval : intval64) * 10 + c;
+                    ndigit++;
+                }
+            } else {
+                if (!isdecimal)
+                    exp++;  // Drop overflow digits
+                truncated = truncated || c;
+            }
         } else if (c == (('.'-'0') & 0xff) && !isdecimal)
             isdecimal = true;
          else
@@ -172,24 +306,30 @@ bool read_float (char *line, uint_fast8_t *char_counter, float *float_ptr)
     }
 
     // Return if no digits have been read.
-    if (!ndigit)
+    if (!isnumber)
         return(false);
 
-    // Convert integer into floating point.
-    float fval = (float)intval;
-
-    // Apply decimal. Should perform no more than two floating point multiplications for the
-    // expected range of E0 to E-4.
-    if (fval != 0.0f) {
-        while (exp <= -2) {
-            fval *= 0.01f;
-            exp += 2;
-        }
-        if (exp < 0)
-            fval *= 0.1f;
-        else if (exp > 0) do {
-            fval *= 10.0f;
-        } while (--exp > 0);
+    if (ndigit == 0)
+        fval = 0.0f;
+    else if (ndigit <= 9 && intval < (1UL << 24) && exp <= 0 && exp >= -MAX_PRECISION)
+        fval = (float)intval / pow10_float[-exp]; // Exact operands, division is correctly rounded
+    else if (ndigit <= 9 && exp <= 0 && exp >= -MAX_PRECISION)
+        fval = udiv_pow10_to_float(intval, (uint_fast8_t)-exp);
+    else {
+        if (ndigit <= 9)
+            intval64 = intval;
+        if (exp > 0) {
+            fval = udiv_to_float(intval64, 1, truncated);
+            do {
+                fval *= 10.0f;
+            } while (--exp > 0);
+        } else if (exp < -MAX_SIG_DIGITS) {
+            fval = udiv_to_float(intval64, pow10_int[MAX_SIG_DIGITS], truncated);
+            do {
+                fval *= 0.1f;
+            } while (++exp < -MAX_SIG_DIGITS);
+        } else
+            fval = udiv_to_float(intval64, pow10_int[-exp], truncated);
     }
 
     // Assign floating point value with correct sign.
@@ -272,6 +412,64 @@ uint8_t calc_checksum (uint8_t *data, uint32_t size) {
     return checksum;
 }
 
+uint16_t calc_crc16 (const uint8_t *data, uint32_t size)
+{
+    return calc_crc16_update(0xFFFF, data, size);
+}
+
+uint16_t calc_crc16_update (uint16_t crc, const uint8_t *data, uint32_t size)
+{
+    uint_fast8_t bits;
+
+    while(size--) {
+        crc ^= (uint16_t)*data++ << 8;
+        bits = 8;
+        do {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+        } while(--bits);
+    }
+
+    return crc;
+}
+
+int32_t decode_base64 (uint8_t *out, const char *in, uint32_t size)
+{
+    char c;
+    int32_t count = 0;
+    uint_fast8_t bits = 0;
+    uint32_t value = 0;
+
+    while((c = *in++) && c != '=') {
+
+        if(c >= 'A' && c <= 'Z')
+            c -= 'A';
+        else if(c >= 'a' && c <= 'z')
+            c -= 'a' - 26;
+        else if(c >= '0' && c <= '9')
+            c -= '0' - 52;
+        else if(c == '+')
+            c = 62;
+        else if(c == '/')
+            c = 63;
+        else
+            return -1;
+
+        value = (value << 6) | (uint8_t)c;
+        if((bits += 6) >= 8) {
+            if((uint32_t)count == size)
+                return -1;
+            bits -= 8;
+            out[count++] = (uint8_t)(value >> bits);
+        }
+    }
+
+    // Only padding may follow the encoded data.
+    while(c == '=')
+        c = *in++;
+
+    return c == '\0' ? count : -1;
+}
+
 void dummy_handler (void)
 {
     // NOOP
@@ -163,6 +163,15 @@ float limit_value_by_axis_maximum(float *max_value, float *unit_vec);
 // calculate checksum byte for EEPROM data
 uint8_t calc_checksum (uint8_t *data, uint32_t size);
 
+// calculate CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF)
+uint16_t calc_crc16 (const uint8_t *data, uint32_t size);
+
+// continue CRC-16/CCITT-FALSE calculation with more data, crc is the value returned for the previous data
+uint16_t calc_crc16_update (uint16_t crc, const uint8_t *data, uint32_t size);
+
+// Decode base64 encoded string to at most size bytes, returns number of bytes decoded or -1 on invalid input or overflow
+int32_t decode_base64 (uint8_t *out, const char *in, uint32_t size);
+
 void dummy_handler (void);
 
 #endif
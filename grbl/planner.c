@@ -24,22 +24,34 @@
 #include "grbl.h"
 
 static plan_block_t block_buffer[BLOCK_BUFFER_SIZE];    // A ring buffer for motion instructions
-static uint_fast8_t block_buffer_tail;                  // Index of the block to process now
-static uint_fast8_t block_buffer_head;                  // Index of the next block to be pushed
-static uint_fast8_t next_buffer_head;                   // Index of the next buffer head
-static uint_fast8_t block_buffer_planned;               // Index of the optimally planned block
+static plan_profile_t block_profile[BLOCK_BUFFER_SIZE]; // Velocity profiles of the blocks in block_buffer, same index
+#ifdef ENABLE_NATIVE_ARCS
+static plan_arc_t block_arc[BLOCK_BUFFER_SIZE];         // Arc geometry of the blocks in block_buffer, same index
+#endif
+#ifdef ENABLE_LASER_RASTER
+static plan_raster_t block_raster[BLOCK_BUFFER_SIZE];   // Raster scanlines of the blocks in block_buffer, same index
+#endif
+static uint_fast16_t block_buffer_tail;                 // Index of the block to process now
+static uint_fast16_t block_buffer_head;                 // Index of the next block to be pushed
+static uint_fast16_t next_buffer_head;                  // Index of the next buffer head
+static uint_fast16_t block_buffer_planned;              // Index of the optimally planned block
+static uint_fast16_t block_buffer_resume;               // Index of the block to resume an interrupted reverse pass from
+static uint_fast16_t block_buffer_replan;               // Index of the first block not yet replanned after a plan reinitialization
+static bool replan_pending;                             // Set while blocks are left to replan
+static bool resume_unsettled;                           // Set when the resumed reverse pass is not to end early
+static plan_stats_t stats;                              // Recalculation statistics, survives planner reset
 
 static planner_t pl;
 
 // Returns the index of the next block in the ring buffer. Also called by stepper segment buffer.
-inline static uint_fast8_t plan_next_block_index (uint_fast8_t block_index)
+inline static uint_fast16_t plan_next_block_index (uint_fast16_t block_index)
 {
     return block_index == (BLOCK_BUFFER_SIZE - 1) ? 0 : block_index + 1;
 }
 
 
 // Returns the index of the previous block in the ring buffer
-inline static uint_fast8_t plan_prev_block_index (uint_fast8_t block_index)
+inline static uint_fast16_t plan_prev_block_index (uint_fast16_t block_index)
 {
     return block_index == 0 ? (BLOCK_BUFFER_SIZE - 1) : block_index - 1;
 }
@@ -109,92 +121,243 @@ inline static uint_fast8_t plan_prev_block_index (uint_fast8_t block_index)
   to compute an optimal plan, so select carefully. ARM versions should have enough memory and speed for
   look-ahead blocks numbering up to a hundred or more.
 
+  NOTE: The velocity profile data accessed here is kept in block_profile[], separate from the remaining
+  block data in block_buffer[]. This keeps the data walked on each recalculation compact and contiguous.
+
 */
-static void planner_recalculate ()
+// Reverse pass, computes the maximum entry speeds from which the end of the plan can be reached by decelerating,
+// from block_index (the block to start at) back to the planned pointer. Processes at most limit blocks if limit
+// is non zero. These speeds can only increase when a block is added, the pass ends early at the first block with
+// an unchanged speed after the first unsettled blocks since the speeds below it are then not affected.
+// A pending pass is continued when the block it is to be resumed from is reached. If a pass is stopped early above
+// it the resumed pass cannot end early since the blocks between are yet to be processed by the pending pass.
+// Returns the index of the block the pass ended at, block_buffer_resume is updated accordingly.
+static uint_fast16_t planner_reverse_pass (uint_fast16_t block_index, uint_fast16_t limit, uint_fast16_t unsettled)
 {
-    // Initialize block index to the last block in the planner buffer.
-    uint_fast8_t block_index = plan_prev_block_index(block_buffer_head);
+    float decel_speed_sqr;
+    plan_profile_t *current, *next = &block_profile[plan_next_block_index(block_index)];
 
-    // Bail. Can't do anything with one only one plan-able block.
-    if (block_index == block_buffer_planned)
-        return;
+    bool bounded = limit != 0, pending = block_buffer_resume != block_buffer_planned;
 
-    // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
-    // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
-    // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
-    float entry_speed_sqr;
-    plan_block_t *next;
-    plan_block_t *current = &block_buffer[block_index];
+    while (block_index != block_buffer_planned) {
 
-    // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
-    current->entry_speed_sqr = min(current->max_entry_speed_sqr, 2.0f * current->acceleration * current->millimeters);
+        if (pending && block_index == block_buffer_resume) {
+            pending = false; // Pending pass is continued by this one.
+            if (resume_unsettled)
+                unsettled = BLOCK_BUFFER_SIZE;
+        }
 
-    block_index = plan_prev_block_index(block_index);
-    if (block_index == block_buffer_planned) { // Only two plannable blocks in buffer. Reverse pass complete.
-        // Check if the first block is the tail. If so, notify stepper to update its current parameters.
-        if (block_index == block_buffer_tail)
-            st_update_plan_block_parameters();
-    } else while (block_index != block_buffer_planned) { // Three or more plan-able blocks
+        if (bounded && !limit--) {
+            // Remaining blocks, including those of a pending pass, are processed later.
+            block_buffer_resume = block_index;
+            resume_unsettled = pending || unsettled;
+            return block_index;
+        }
 
-        next = current;
-        current = &block_buffer[block_index];
-        block_index = plan_prev_block_index(block_index);
+        current = &block_profile[block_index];
 
-        // Check if next block is the tail block(=planned block). If so, update current stepper parameters.
-        if (block_index == block_buffer_tail)
+        // Check if current block is the one following the executing block. If so, update current stepper parameters.
+        if (plan_prev_block_index(block_index) == block_buffer_tail)
             st_update_plan_block_parameters();
 
+        stats.last_blocks++;
+
         // Compute maximum entry speed decelerating over the current block from its exit speed.
-        if (current->entry_speed_sqr != current->max_entry_speed_sqr) {
-            entry_speed_sqr = next->entry_speed_sqr + 2.0f * current->acceleration * current->millimeters;
-            current->entry_speed_sqr = entry_speed_sqr < current->max_entry_speed_sqr ? entry_speed_sqr : current->max_entry_speed_sqr;
-        }
+        decel_speed_sqr = next->decel_speed_sqr + 2.0f * current->acceleration * current->millimeters;
+        if (decel_speed_sqr > current->max_entry_speed_sqr)
+            decel_speed_sqr = current->max_entry_speed_sqr;
+
+        if (decel_speed_sqr != current->decel_speed_sqr)
+            current->decel_speed_sqr = decel_speed_sqr;
+        else if (!unsettled)
+            break;
+
+        if (unsettled)
+            unsettled--;
+
+        next = current;
+        block_index = plan_prev_block_index(block_index);
     }
 
-    // Forward Pass: Forward plan the acceleration curve from the planned pointer onward.
-    // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
-    next = &block_buffer[block_buffer_planned]; // Begin at buffer planned pointer
-    block_index = plan_next_block_index(block_buffer_planned);
+    // Pass is complete unless stopped early above the block a pending pass is to be resumed from.
+    if (!pending) {
+        block_buffer_resume = block_buffer_planned;
+        resume_unsettled = false;
+    }
+
+    return block_index;
+}
+
+// Forward pass, sets entry speeds to the maximum entry speeds of the reverse pass limited by what can be reached
+// by accelerating from the previous block, from block_index up to (but not including) block end and onwards
+// until an entry speed is unchanged. Entry speeds above a pass stopped early are then raised when it is resumed.
+// The planned pointer is only moved forward if no reverse pass is pending.
+static void planner_forward_pass (uint_fast16_t block_index, uint_fast16_t end)
+{
+    float entry_speed_sqr;
+    bool complete = block_buffer_resume == block_buffer_planned, beyond_end = false;
+    plan_profile_t *current, *next = &block_profile[block_index];
+
+    block_index = plan_next_block_index(block_index);
 
     while (block_index != block_buffer_head) {
 
+        if (block_index == end)
+            beyond_end = true;
+
         current = next;
-        next = &block_buffer[block_index];
+        next = &block_profile[block_index];
 
         // Any acceleration detected in the forward pass automatically moves the optimal planned
         // pointer forward, since everything before this is all optimal. In other words, nothing
         // can improve the plan from the buffer tail to the planned pointer by logic.
-        if (current->entry_speed_sqr < next->entry_speed_sqr) {
-            entry_speed_sqr = current->entry_speed_sqr + 2.0f * current->acceleration * current->millimeters;
+        entry_speed_sqr = current->entry_speed_sqr + 2.0f * current->acceleration * current->millimeters;
         // If true, current block is full-acceleration and we can move the planned pointer forward.
-            if (entry_speed_sqr < next->entry_speed_sqr) {
-                next->entry_speed_sqr = entry_speed_sqr; // Always <= max_entry_speed_sqr. Backward pass sets this.
+        if (entry_speed_sqr < next->decel_speed_sqr) {
+            if (complete)
                 block_buffer_planned = block_index; // Set optimal plan pointer.
-            }
-        }
+        } else
+            entry_speed_sqr = next->decel_speed_sqr; // Always <= max_entry_speed_sqr. Backward pass sets this.
+
+        if (beyond_end && entry_speed_sqr == next->entry_speed_sqr)
+            break;
+
+        next->entry_speed_sqr = entry_speed_sqr;
 
         // Any block set at its maximum entry speed also creates an optimal plan up to this
         // point in the buffer. When the plan is bracketed by either the beginning of the
         // buffer and a maximum entry speed or two maximum entry speeds, every block in between
         // cannot logically be further improved. Hence, we don't have to recompute them anymore.
-        if (next->entry_speed_sqr == next->max_entry_speed_sqr)
+        if (complete && entry_speed_sqr == next->max_entry_speed_sqr)
             block_buffer_planned = block_index;
 
         block_index = plan_next_block_index(block_index);
+        stats.last_blocks++;
     }
+
+    if (complete)
+        block_buffer_resume = block_buffer_planned;
+}
+
+static inline void planner_update_stats (void)
+{
+    stats.recalculations++;
+    stats.blocks += stats.last_blocks;
+    if (stats.last_blocks > stats.max_blocks)
+        stats.max_blocks = stats.last_blocks;
+    if (block_buffer_resume != block_buffer_planned || replan_pending)
+        stats.deferred++;
+}
+
+// Recalculates the plan up to the last block in the buffer, which ends at a complete stop. Called when a block
+// has been added to the buffer and from scratch, with unsettled set to the number of blocks to process
+// regardless, on replan. Entry speeds can only increase when a new block is added, the existing plan remains
+// valid when the reverse pass is stopped early. The remaining blocks are then processed by plan_resume_recalculation().
+static void planner_recalculate (uint_fast16_t limit, uint_fast16_t unsettled)
+{
+    // Initialize block index to the last block in the planner buffer.
+    uint_fast16_t block_index = plan_prev_block_index(block_buffer_head);
+
+    stats.last_blocks = 0;
+
+    // Bail. Can't do anything with one only one plan-able block.
+    if (block_index == block_buffer_planned) {
+        block_buffer_resume = block_buffer_planned;
+        resume_unsettled = false;
+        return;
+    }
+
+    // Reverse Pass: Coarsely maximize all possible deceleration curves back-planning from the last
+    // block in buffer. Cease planning when the last optimal planned or tail pointer is reached.
+    // NOTE: Forward pass will later refine and correct the reverse pass to create an optimal plan.
+    plan_profile_t *current = &block_profile[block_index];
+
+    // Calculate maximum entry speed for last block in buffer, where the exit speed is always zero.
+    current->entry_speed_sqr = current->decel_speed_sqr = min(current->max_entry_speed_sqr, 2.0f * current->acceleration * current->millimeters);
+
+    // Check if the last block follows the executing block. If so, notify stepper to update its current parameters.
+    if (plan_prev_block_index(block_index) == block_buffer_tail)
+        st_update_plan_block_parameters();
+
+    block_index = planner_reverse_pass(plan_prev_block_index(block_index), limit, unsettled);
+
+    // Forward Pass: Forward plan the acceleration curve from the block where the reverse pass stopped onward.
+    // Also scans for optimal plan breakpoints and appropriately updates the planned pointer.
+    planner_forward_pass(block_index, block_buffer_head);
+
+    planner_update_stats();
+}
+
+#if PLANNER_RECALC_LIMIT
+
+// Replans the next PLANNER_RECALC_LIMIT blocks after a plan reinitialization. Entry speeds of blocks from
+// block_buffer_replan on are stale, the replanned blocks below end at a complete stop at the first of them.
+// Blocks added meanwhile are left to this, the replan is complete when block_buffer_replan reaches the buffer head.
+static void planner_replan (void)
+{
+    uint_fast16_t block_index = block_buffer_replan, count = 0;
+
+    // Clear stale entry speeds, the reverse pass then computes them from scratch.
+    do {
+        block_profile[block_index].entry_speed_sqr = block_profile[block_index].decel_speed_sqr = 0.0f;
+        block_index = plan_next_block_index(block_index);
+    } while (++count < PLANNER_RECALC_LIMIT && block_index != block_buffer_head);
+
+    if ((block_buffer_replan = block_index) == block_buffer_head) {
+        replan_pending = false;
+        planner_recalculate(count + PLANNER_RECALC_LIMIT, count - 1);
+    } else {
+        stats.last_blocks = 0;
+        // First block not replanned, enforce a stop.
+        block_profile[block_index].entry_speed_sqr = block_profile[block_index].decel_speed_sqr = 0.0f;
+        planner_forward_pass(planner_reverse_pass(plan_prev_block_index(block_index), count + PLANNER_RECALC_LIMIT, count), block_index);
+        planner_update_stats();
+    }
+}
+
+#endif
+
+// Continues a reverse pass stopped early by planner_recalculate(), or a replan, called from the main loop.
+// Processes at most PLANNER_RECALC_LIMIT blocks per call, twice that for a replan.
+void plan_resume_recalculation (void)
+{
+    if (block_buffer_resume != block_buffer_planned) {
+
+        uint_fast16_t end = plan_next_block_index(block_buffer_resume);
+
+        stats.last_blocks = 0;
+
+        planner_forward_pass(planner_reverse_pass(block_buffer_resume, PLANNER_RECALC_LIMIT, 0), end);
+
+        planner_update_stats();
+    }
+#if PLANNER_RECALC_LIMIT
+    else if (replan_pending)
+        planner_replan();
+#endif
+}
+
+// Returns planner recalculation statistics.
+plan_stats_t *plan_get_stats (void)
+{
+    return &stats;
+}
+
+int32_t *plan_get_position (void)
+{
+    return pl.position;
 }
 
 inline static void plan_cleanup (plan_block_t *block)
 {
     if(block->message) {
-        free(block->message);
+        message_release(block->message);
         block->message = NULL;
     }
 
-    while(block->output_commands) {
-        output_command_t *next = block->output_commands->next;
-        free(block->output_commands);
-        block->output_commands = next;
+    if(block->output_commands) {
+        output_commands_release(block->output_commands);
+        block->output_commands = NULL;
     }
 }
 
@@ -209,6 +372,8 @@ inline static void plan_reset_buffer (bool soft_reset)
     block_buffer_head = 0;      // Empty = tail
     next_buffer_head = 1;       // plan_next_block_index(block_buffer_head)
     block_buffer_planned = 0;   // = block_buffer_tail;
+    block_buffer_resume = 0;    // = block_buffer_planned, no reverse pass pending
+    replan_pending = resume_unsettled = false;
 }
 
 
@@ -224,12 +389,21 @@ void plan_reset ()
 void plan_discard_current_block ()
 {
     if (block_buffer_head != block_buffer_tail) { // Discard non-empty buffer.
-        uint_fast8_t block_index = plan_next_block_index(block_buffer_tail);
+        uint_fast16_t block_index = plan_next_block_index(block_buffer_tail);
         plan_cleanup(&block_buffer[block_buffer_tail]);
         // Push block_buffer_planned pointer, if encountered.
         if (block_buffer_tail == block_buffer_planned)
             block_buffer_planned = block_index;
+        if (block_buffer_tail == block_buffer_resume)
+            block_buffer_resume = block_index;
         block_buffer_tail = block_index;
+        // If the first block not yet replanned is to be executed next, enforce a stop at the end of it.
+        if (replan_pending && block_buffer_tail == block_buffer_replan) {
+            if ((block_buffer_replan = plan_next_block_index(block_index)) == block_buffer_head)
+                replan_pending = false;
+            else
+                block_profile[block_buffer_replan].entry_speed_sqr = block_profile[block_buffer_replan].decel_speed_sqr = 0.0f;
+        }
     }
 }
 
@@ -250,8 +424,8 @@ plan_block_t *plan_get_current_block ()
 
 inline float plan_get_exec_block_exit_speed_sqr ()
 {
-    uint_fast8_t block_index = plan_next_block_index(block_buffer_tail);
-    return block_index == block_buffer_head ? 0.0f : block_buffer[block_index].entry_speed_sqr;
+    uint_fast16_t block_index = plan_next_block_index(block_buffer_tail);
+    return block_index == block_buffer_head ? 0.0f : block_profile[block_index].entry_speed_sqr;
 }
 
 
@@ -287,16 +461,16 @@ float plan_compute_profile_nominal_speed (plan_block_t *block)
 inline static float plan_compute_profile_parameters (plan_block_t *block, float nominal_speed, float prev_nominal_speed)
 {
   // Compute the junction maximum entry based on the minimum of the junction speed and neighboring nominal speeds.
-    block->max_entry_speed_sqr = nominal_speed > prev_nominal_speed ? (prev_nominal_speed * prev_nominal_speed) : (nominal_speed * nominal_speed);
-    if (block->max_entry_speed_sqr > block->max_junction_speed_sqr)
-        block->max_entry_speed_sqr = block->max_junction_speed_sqr;
+    block->profile->max_entry_speed_sqr = nominal_speed > prev_nominal_speed ? (prev_nominal_speed * prev_nominal_speed) : (nominal_speed * nominal_speed);
+    if (block->profile->max_entry_speed_sqr > block->max_junction_speed_sqr)
+        block->profile->max_entry_speed_sqr = block->max_junction_speed_sqr;
     return nominal_speed;
 }
 
 // Re-calculates buffered motions profile parameters upon a motion-based override change.
 void plan_update_velocity_profile_parameters ()
 {
-    uint_fast8_t block_index = block_buffer_tail;
+    uint_fast16_t block_index = block_buffer_tail;
     plan_block_t *block;
     float prev_nominal_speed = SOME_LARGE_VALUE; // Set high for first block nominal speed calculation.
 
@@ -309,6 +483,81 @@ void plan_update_velocity_profile_parameters ()
 }
 
 
+#ifdef ENABLE_NATIVE_ARCS
+
+// Initializes the step data of an arc block. Axis step counts are upper bounds of the axis travels, the
+// step segment generator computes the actual steps of each segment from the segment end point on the arc.
+static void plan_arc_init (plan_block_t *block, int32_t *position_steps, int32_t *target_steps)
+{
+    uint_fast8_t idx = N_AXIS;
+    plan_arc_t *arc = block->arc;
+    float plane_mm = fabsf(arc->angular_travel) * hypotf(arc->r0[0], arc->r0[1]);
+
+    memcpy(arc->start_steps, position_steps, sizeof(arc->start_steps));
+    memcpy(arc->target_steps, target_steps, sizeof(arc->target_steps));
+
+    block->direction_bits.mask = 0; // Set per segment.
+    block->step_event_count = 0;
+
+    do {
+        idx--;
+        if(idx == arc->plane.axis_0 || idx == arc->plane.axis_1)
+            block->steps[idx] = (uint32_t)ceilf(plane_mm * settings.steps_per_mm[idx]);
+        block->step_event_count = max(block->step_event_count, block->steps[idx]);
+    } while(idx);
+}
+
+// Computes the arc block length, acceleration and rate limits, and the start and end tangent unit vectors
+// used for junction speed computations. On entry unit_vec holds the axis travels from start to target.
+// Acceleration and rate are limited for the worst case direction along the arc, the rate is further
+// limited by the centripetal acceleration at the arc radius.
+static void plan_arc_profile (plan_block_t *block, float *unit_vec, float *exit_vec)
+{
+    uint_fast8_t idx = N_AXIS;
+    plan_arc_t *arc = block->arc;
+    float radius = hypotf(arc->r0[0], arc->r0[1]), plane_mm = fabsf(arc->angular_travel) * radius;
+    float limit_vec[N_AXIS], linear_sqr = 0.0f, inv_mm, plane_scale, centripetal_rate;
+    float cos_a = cosf(arc->angular_travel), sin_a = sinf(arc->angular_travel);
+
+    do {
+        idx--;
+        if(!(idx == arc->plane.axis_0 || idx == arc->plane.axis_1))
+            linear_sqr += unit_vec[idx] * unit_vec[idx];
+    } while(idx);
+
+    block->profile->millimeters = arc->millimeters = sqrtf(plane_mm * plane_mm + linear_sqr);
+
+    inv_mm = 1.0f / arc->millimeters;
+    plane_scale = radius > 0.0f ? (arc->angular_travel < 0.0f ? -inv_mm : inv_mm) * plane_mm / radius : 0.0f;
+
+    idx = N_AXIS;
+    do {
+        idx--;
+        if(idx == arc->plane.axis_0) {
+            limit_vec[idx] = plane_mm * inv_mm;
+            unit_vec[idx] = -arc->r0[1] * plane_scale;
+            exit_vec[idx] = -(arc->r0[0] * sin_a + arc->r0[1] * cos_a) * plane_scale;
+        } else if(idx == arc->plane.axis_1) {
+            limit_vec[idx] = plane_mm * inv_mm;
+            unit_vec[idx] = arc->r0[0] * plane_scale;
+            exit_vec[idx] = (arc->r0[0] * cos_a - arc->r0[1] * sin_a) * plane_scale;
+        } else
+            limit_vec[idx] = unit_vec[idx] = exit_vec[idx] = unit_vec[idx] * inv_mm;
+    } while(idx);
+
+    block->profile->acceleration = limit_value_by_axis_maximum(settings.acceleration, limit_vec);
+    block->rapid_rate = limit_value_by_axis_maximum(settings.max_rate, limit_vec);
+
+    // Limit speed in the arc plane so that the centripetal acceleration does not exceed the plane axes acceleration.
+    if(plane_mm > 0.0f) {
+        centripetal_rate = sqrtf(min(settings.acceleration[arc->plane.axis_0], settings.acceleration[arc->plane.axis_1]) * radius) * arc->millimeters / plane_mm;
+        if(centripetal_rate < block->rapid_rate)
+            block->rapid_rate = centripetal_rate;
+    }
+}
+
+#endif
+
 /* Add a new linear movement to the buffer. target[N_AXIS] is the signed, absolute target position
    in millimeters. Feed rate specifies the speed of the motion. If feed rate is inverted, the feed
    rate is taken to mean "frequency" and would complete the operation in 1/feed_rate minutes.
@@ -327,12 +576,15 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 {
     // Prepare and initialize new block. Copy relevant pl_data for block execution.
     plan_block_t *block = &block_buffer[block_buffer_head];
+    plan_profile_t *profile = &block_profile[block_buffer_head];
     int32_t target_steps[N_AXIS], position_steps[N_AXIS], delta_steps;
     uint_fast8_t idx;
     float unit_vec[N_AXIS];
 
     memset(block, 0, sizeof(plan_block_t));                         // Zero all block values.
-    memcpy(&block->spindle, &pl_data->spindle, sizeof(spindle_t));  // Copy spindle data (RPM etc)
+    memset(profile, 0, sizeof(plan_profile_t));
+    block->profile = profile;
+    block->spindle.rpm = pl_data->spindle.rpm;                      // Copy spindle data (RPM etc)
     block->condition = pl_data->condition;
     block->overrides = pl_data->overrides;
     block->line_number = pl_data->line_number;
@@ -369,21 +621,38 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 
     } while(idx);
 
+#ifdef ENABLE_NATIVE_ARCS
+    float exit_vec[N_AXIS]; // Unit vector at end of arc
+
+    if((block->arc = pl_data->arc ? &block_arc[block_buffer_head] : NULL)) {
+        memcpy(block->arc, pl_data->arc, sizeof(plan_arc_t));
+        plan_arc_init(block, position_steps, target_steps);
+    }
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+    if((block->raster = pl_data->raster && pl_data->raster->pixels ? &block_raster[block_buffer_head] : NULL)) {
+        block->raster->pixels = pl_data->raster->pixels;
+        memcpy(block->raster->power, pl_data->raster->power, pl_data->raster->pixels);
+    }
+#endif
+
     // Calculate RPMs to be used for Constant Surface Speed calculations
     if(block->condition.is_rpm_pos_adjusted) {
         float pos;
-        if((pos = (float)position_steps[block->spindle.css.axis] / settings.steps_per_mm[block->spindle.css.axis] - block->spindle.css.tool_offset) > 0.0f) {
-            block->spindle.rpm = block->spindle.css.surface_speed / (pos * (float)(2.0f * M_PI));
-            if(block->spindle.rpm > block->spindle.css.max_rpm)
-                block->spindle.rpm = block->spindle.css.max_rpm;
+        css_data_t *css = &pl_data->spindle.css;
+        if((pos = (float)position_steps[css->axis] / settings.steps_per_mm[css->axis] - css->tool_offset) > 0.0f) {
+            block->spindle.rpm = css->surface_speed / (pos * (float)(2.0f * M_PI));
+            if(block->spindle.rpm > css->max_rpm)
+                block->spindle.rpm = css->max_rpm;
         } else
-            block->spindle.rpm = block->spindle.css.max_rpm;
-        if((pos = target[block->spindle.css.axis] - block->spindle.css.tool_offset) > 0.0f) {
-            block->spindle.css.target_rpm = block->spindle.css.surface_speed / (pos * (float)(2.0f * M_PI));
-            if(block->spindle.css.target_rpm > block->spindle.css.max_rpm)
-                block->spindle.css.target_rpm = block->spindle.css.max_rpm;
+            block->spindle.rpm = css->max_rpm;
+        if((pos = target[css->axis] - css->tool_offset) > 0.0f) {
+            block->spindle.target_rpm = css->surface_speed / (pos * (float)(2.0f * M_PI));
+            if(block->spindle.target_rpm > css->max_rpm)
+                block->spindle.target_rpm = css->max_rpm;
         } else
-            block->spindle.css.target_rpm = block->spindle.css.max_rpm;
+            block->spindle.target_rpm = css->max_rpm;
     }
 
     // Bail if this is a zero-length block. Highly unlikely to occur.
@@ -397,9 +666,17 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
     // down such that no individual axes maximum values are exceeded with respect to the line direction.
     // NOTE: This calculation assumes all axes are orthogonal (Cartesian) and works with ABC-axes,
     // if they are also orthogonal/independent. Operates on the absolute value of the unit vector.
-    block->millimeters = convert_delta_vector_to_unit_vector(unit_vec);
-    block->acceleration = limit_value_by_axis_maximum(settings.acceleration, unit_vec);
+#ifdef ENABLE_NATIVE_ARCS
+    if(block->arc)
+        plan_arc_profile(block, unit_vec, exit_vec);
+    else {
+#endif
+    profile->millimeters = convert_delta_vector_to_unit_vector(unit_vec);
+    profile->acceleration = limit_value_by_axis_maximum(settings.acceleration, unit_vec);
     block->rapid_rate = limit_value_by_axis_maximum(settings.max_rate, unit_vec);
+#ifdef ENABLE_NATIVE_ARCS
+    }
+#endif
 
     // Store programmed rate.
     if (block->condition.rapid_motion)
@@ -407,7 +684,20 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
     else {
         block->programmed_rate = pl_data->feed_rate;
         if (block->condition.inverse_time)
-            block->programmed_rate *= block->millimeters;
+            block->programmed_rate *= profile->millimeters;
+    }
+
+    // Jerk limited ramps take longer than constant acceleration ones, plan with the average acceleration
+    // of a jerk limited ramp from rest to half the programmed rate. The segment generator executes ramps
+    // at the peak acceleration when the planned profile leaves room for it.
+    // NOTE: Spindle synchronized motion is always executed with constant acceleration.
+    block->max_acceleration = profile->acceleration;
+    if ((block->jerk = block->condition.spindle.synchronized ? 0.0f : settings.jerk) > 0.0f) {
+        float delta_speed = 0.5f * min(block->programmed_rate, block->rapid_rate);
+        if (delta_speed > block->max_acceleration * block->max_acceleration / block->jerk)
+            profile->acceleration = delta_speed / (delta_speed / block->max_acceleration + block->max_acceleration / block->jerk);
+        else
+            profile->acceleration = 0.5f * sqrtf(block->jerk * delta_speed);
     }
 
     // TODO: Need to check this method handling zero junction speeds when starting from rest.
@@ -415,7 +705,7 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 
         // Initialize block entry speed as zero. Assume it will be starting from rest. Planner will correct this later.
         // If system motion, the system motion block always is assumed to start from rest and end at a complete stop.
-        block->entry_speed_sqr = 0.0f;
+        profile->entry_speed_sqr = 0.0f;
         block->max_junction_speed_sqr = 0.0f; // Starting from rest. Enforce start from zero velocity.
 
     } else {
@@ -432,10 +722,10 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
         //
         // NOTE: If the junction deviation value is finite, Grbl executes the motions in an exact path
         // mode (G61). If the junction deviation value is zero, Grbl will execute the motion in an exact
-        // stop mode (G61.1) manner. In the future, if continuous mode (G64) is desired, the math here
-        // is exactly the same. Instead of motioning all the way to junction point, the machine will
-        // just follow the arc circle defined here. The Arduino doesn't have the CPU cycles to perform
-        // a continuous mode path, but ARM-based microcontrollers most certainly do.
+        // stop mode (G61.1) manner. In exact stop mode (G61.1) motion always comes to a stop at the junction.
+        //
+        // In path blending mode (G64) with a path tolerance the corners are rounded by mc_blend_line() before
+        // the lines reach the planner, the junctions between the lines and the blend are then near straight.
         //
         // NOTE: The max junction speed is a fixed value, since machine acceleration limits cannot be
         // changed dynamically during operation nor can the line move geometry. This must be kept in
@@ -453,7 +743,9 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
         } while(idx);
 
         // NOTE: Computed without any expensive trig, sin() or acos(), by trig half angle identity of cos(theta).
-        if (junction_cos_theta > 0.999999f)
+        if (block->condition.exact_stop)
+            block->max_junction_speed_sqr = 0.0f;
+        else if (junction_cos_theta > 0.999999f)
             //  For a 0 degree acute junction, just set minimum junction speed.
             block->max_junction_speed_sqr = MINIMUM_JUNCTION_SPEED * MINIMUM_JUNCTION_SPEED;
         else if (junction_cos_theta < -0.999999f) {
@@ -475,15 +767,20 @@ bool plan_buffer_line (float *target, plan_line_data_t *pl_data)
 
         if(!block->condition.backlash_motion) {
             // Update previous path unit_vector and planner position.
+#ifdef ENABLE_NATIVE_ARCS
+            memcpy(pl.previous_unit_vec, block->arc ? exit_vec : unit_vec, sizeof(unit_vec)); // Arcs exit along the end tangent
+#else
             memcpy(pl.previous_unit_vec, unit_vec, sizeof(unit_vec)); // pl.previous_unit_vec[] = unit_vec[]
+#endif
             memcpy(pl.position, target_steps, sizeof(target_steps)); // pl.position[] = target_steps[]
         }
         // New block is all set. Update buffer head and next buffer head indices.
         block_buffer_head = next_buffer_head;
         next_buffer_head = plan_next_block_index(block_buffer_head);
 
-        // Finish up by recalculating the plan with the new block.
-        planner_recalculate();
+        // Finish up by recalculating the plan with the new block, left to the replan if one is pending.
+        if (!replan_pending)
+            planner_recalculate(PLANNER_RECALC_LIMIT, 0);
     }
 
     return true;
@@ -498,9 +795,9 @@ void plan_sync_position ()
 
 
 // Returns the number of available blocks are in the planner buffer.
-uint8_t plan_get_block_buffer_available ()
+uint_fast16_t plan_get_block_buffer_available ()
 {
-    return (uint8_t)(block_buffer_head >= block_buffer_tail ? ((BLOCK_BUFFER_SIZE - 1) - (block_buffer_head - block_buffer_tail)) : (block_buffer_tail - block_buffer_head - 1));
+    return (uint_fast16_t)(block_buffer_head >= block_buffer_tail ? ((BLOCK_BUFFER_SIZE - 1) - (block_buffer_head - block_buffer_tail)) : (block_buffer_tail - block_buffer_head - 1));
 }
 
 
@@ -510,8 +807,17 @@ void plan_cycle_reinitialize ()
 {
     // Re-plan from a complete stop. Reset planner entry speeds and buffer planned pointer.
     st_update_plan_block_parameters();
-    block_buffer_planned = block_buffer_tail;
-    planner_recalculate();
+    block_buffer_planned = block_buffer_resume = block_buffer_tail;
+    resume_unsettled = false;
+#if PLANNER_RECALC_LIMIT
+    // Entry speeds are stale, replan a bounded number of blocks at a time starting from the executing block.
+    // Remaining blocks are replanned by plan_resume_recalculation().
+    block_buffer_replan = plan_next_block_index(block_buffer_tail);
+    if ((replan_pending = block_buffer_tail != block_buffer_head && block_buffer_replan != block_buffer_head))
+        planner_replan();
+#else
+    planner_recalculate(0, BLOCK_BUFFER_SIZE);
+#endif
 }
 
 // Set feed overrides
@@ -28,6 +28,13 @@
   #define BLOCK_BUFFER_SIZE 36
 #endif
 
+// The maximum number of blocks processed by a reverse pass of the planner when a new block is added, and the
+// number of blocks replanned at a time after a plan reinitialization. Remaining blocks are processed on
+// subsequent calls, 0 to always recalculate the complete plan.
+#ifndef PLANNER_RECALC_LIMIT
+  #define PLANNER_RECALC_LIMIT 32
+#endif
+
 typedef union {
     uint32_t value;
     struct {
@@ -40,12 +47,62 @@ typedef union {
                  is_rpm_rate_adjusted :1,
                  is_rpm_pos_adjusted  :1,
                  is_laser_ppi_mode    :1,
-                 unassigned           :7;
+                 exact_stop           :1,
+                 unassigned           :6;
         spindle_state_t spindle;
         coolant_state_t coolant;
     };
 } planner_cond_t;
 
+// Velocity profile data of a planner block, the only data accessed by the look-ahead planner when a new block
+// is added. Kept in a separate compact array so that large look-ahead windows are cheap to recalculate.
+typedef struct {
+    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
+    float decel_speed_sqr;      // Maximum entry speed from which the end of the plan can be reached, computed by the reverse pass
+    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
+                                // neighboring nominal speeds with overrides in (mm/min)^2
+    float acceleration;         // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
+                                // NOTE: Average acceleration of a jerk limited ramp if jerk is set.
+    float millimeters;          // The remaining distance for this block to be executed in (mm).
+                                // NOTE: This value may be altered by stepper algorithm during execution.
+} plan_profile_t;
+
+// Spindle speed data used by spindle overrides and resuming methods.
+typedef struct {
+    float rpm;          // Block spindle speed in RPM.
+    float target_rpm;   // Spindle speed at end of block in RPM, for Constant Surface Speed mode.
+} plan_spindle_t;
+
+#ifdef ENABLE_NATIVE_ARCS
+
+// Circular or helical motion geometry. The plane axes trace the circle, remaining axes move linearly.
+// The planner fills in the step positions and length, the step segment generator traces the arc.
+typedef struct {
+    plane_t plane;
+    float center[2];                // Circle center in plane axes coordinates (mm)
+    float r0[2];                    // Radius vector from center to start position (mm)
+    float angular_travel;           // Angle to travel (rad), positive for counter clockwise motion
+    float millimeters;              // Total path length (mm)
+    int32_t start_steps[N_AXIS];    // Start position in absolute steps
+    int32_t target_steps[N_AXIS];   // Target position in absolute steps
+} plan_arc_t;
+
+#endif
+
+#ifdef ENABLE_LASER_RASTER
+
+#ifndef LASER_RASTER_MAX_PIXELS
+  #define LASER_RASTER_MAX_PIXELS 192
+#endif
+
+// Laser raster scanline, pixel power values spread evenly along a linear motion.
+typedef struct {
+    uint_fast16_t pixels;                   // Number of pixels, 0 if no scanline is loaded
+    uint8_t power[LASER_RASTER_MAX_PIXELS]; // Pixel power in 1/255 of the programmed spindle speed
+} plan_raster_t;
+
+#endif
+
 // This struct stores a linear movement of a g-code block motion with its critical "nominal" values
 // are as specified in the source g-code.
 typedef struct {
@@ -62,23 +119,25 @@ typedef struct {
 
     // Fields used by the motion planner to manage acceleration. Some of these values may be updated
     // by the stepper module during execution of special motion cases for replanning purposes.
-    float entry_speed_sqr;      // The current planned entry speed at block junction in (mm/min)^2
-    float max_entry_speed_sqr;  // Maximum allowable entry speed based on the minimum of junction limit and
-                                // neighboring nominal speeds with overrides in (mm/min)^2
-    float acceleration;         // Axis-limit adjusted line acceleration in (mm/min^2). Does not change.
-    float millimeters;          // The remaining distance for this block to be executed in (mm).
-                                // NOTE: This value may be altered by stepper algorithm during execution.
+    plan_profile_t *profile;    // Velocity profile data, see above.
+    float max_acceleration;     // Axis-limit adjusted peak acceleration of jerk limited ramps in (mm/min^2).
+    float jerk;                 // Jerk limit in (mm/min^3), 0 for trapezoidal ramps.
 
     // Stored rate limiting data used by planner when changes occur.
     float max_junction_speed_sqr; // Junction entry speed limit based on direction vectors in (mm/min)^2
     float rapid_rate;             // Axis-limit adjusted maximum rate for this block direction in (mm/min)
     float programmed_rate;        // Programmed rate of this block (mm/min).
 
-    // Stored spindle speed data used by spindle overrides and resuming methods.
-    spindle_t spindle;    // Block spindle speed. Copied from pl_line_data.
+    plan_spindle_t spindle;       // Block spindle speed. Copied from pl_line_data.
 
     char *message;                // Message to be displayed when block is executed.
     output_command_t *output_commands;
+#ifdef ENABLE_NATIVE_ARCS
+    plan_arc_t *arc;              // Arc geometry, NULL for linear motion.
+#endif
+#ifdef ENABLE_LASER_RASTER
+    plan_raster_t *raster;        // Laser raster scanline, NULL if none.
+#endif
 } plan_block_t;
 
 
@@ -89,9 +148,16 @@ typedef struct {
     planner_cond_t condition;       // Bitfield variable to indicate planner conditions. See defines above.
     gc_override_flags_t overrides;  // Block bitfield variable for overrides
     int32_t line_number;            // Desired line number to report when executing.
+    float path_tolerance;           // Maximum deviation from programmed path for mc_blend_line() (G64 P), 0 for none.
 //    void *parameters;               // TODO: pointer to extra parameters, for canned cycles and threading?
     char *message;                  // Message to be displayed when block is executed.
     output_command_t *output_commands;
+#ifdef ENABLE_NATIVE_ARCS
+    plan_arc_t *arc;                // Arc geometry for circular or helical motion, NULL for linear motion.
+#endif
+#ifdef ENABLE_LASER_RASTER
+    plan_raster_t *raster;          // Laser raster scanline for linear motion, NULL if none.
+#endif
 } plan_line_data_t;
 
 
@@ -104,6 +170,15 @@ typedef struct {
   float previous_nominal_speed;     // Nominal speed of previous path line segment
 } planner_t;
 
+// Planner recalculation statistics
+typedef struct {
+    uint32_t recalculations;    // Number of recalculations, including resumed ones
+    uint32_t blocks;            // Total number of blocks processed by recalculations
+    uint32_t deferred;          // Number of recalculations that left blocks to be processed later
+    uint32_t max_blocks;        // Largest number of blocks processed by a single recalculation
+    uint32_t last_blocks;       // Number of blocks processed by the last recalculation
+} plan_stats_t;
+
 // Initialize and reset the motion plan subsystem
 void plan_reset(); // Reset all
 //void plan_reset_buffer(); // Reset buffer only.
@@ -138,8 +213,17 @@ void plan_sync_position();
 // Reinitialize plan with a partially completed block
 void plan_cycle_reinitialize();
 
+// Continue a recalculation or replan that was stopped early because of PLANNER_RECALC_LIMIT, called from the main loop.
+void plan_resume_recalculation (void);
+
+// Returns planner recalculation statistics.
+plan_stats_t *plan_get_stats (void);
+
+// Returns the planner position, the end of the last queued motion in absolute steps.
+int32_t *plan_get_position (void);
+
 // Returns the number of available blocks in the planner buffer.
-uint8_t plan_get_block_buffer_available();
+uint_fast16_t plan_get_block_buffer_available();
 
 // Returns the status of the block ring buffer. True, if buffer is full.
 bool plan_check_full_buffer();
@@ -0,0 +1,249 @@
+/*
+  pool.c - fixed size pools for block messages and synchronized output commands
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//
+// Entries are allocated by the foreground process (g-code parser) and released when the block they are
+// attached to is executed, possibly from the stepper interrupt handler. An entry is owned by the
+// allocating context until released by clearing its in use flag, so no locking is needed.
+// Entries are normally released in allocation order, allocation starts searching after the last entry
+// allocated and will find a free entry immediately. When the pool is exhausted allocation waits for
+// queued blocks to be executed, as done when the planner buffer is full.
+//
+// Usage counters are kept as separate allocated and released counts, each updated from a single context.
+//
+
+#include "grbl.h"
+
+typedef struct {
+    output_command_t command;   // NOTE: must be first
+    volatile bool used;
+} command_entry_t;
+
+typedef struct {
+    char text[MESSAGE_LENGTH_MAX + 1];  // NOTE: must be first
+    volatile bool used;
+} message_entry_t;
+
+typedef struct {
+    uint_fast16_t next;                 // Entry to start searching from on next allocation
+    uint32_t allocated;                 // Allocation count, foreground process
+    uint32_t released;                  // Release count, foreground process
+    volatile uint32_t released_isr;     // Release count, stepper interrupt handler
+    pool_stats_t stats;
+} pool_t;
+
+static command_entry_t commands[OUTPUT_COMMAND_POOL_SIZE];
+static message_entry_t messages[MESSAGE_POOL_SIZE];
+static pool_t command_pool = { .stats.size = OUTPUT_COMMAND_POOL_SIZE };
+static pool_t message_pool = { .stats.size = MESSAGE_POOL_SIZE };
+
+void pool_reset (void)
+{
+    uint_fast16_t idx;
+
+    for(idx = 0; idx < OUTPUT_COMMAND_POOL_SIZE; idx++)
+        commands[idx].used = false;
+
+    for(idx = 0; idx < MESSAGE_POOL_SIZE; idx++)
+        messages[idx].used = false;
+
+    command_pool.next = command_pool.allocated = command_pool.released = command_pool.released_isr = 0;
+    message_pool.next = message_pool.allocated = message_pool.released = message_pool.released_isr = 0;
+}
+
+// Executes realtime commands while waiting for entries to be released by execution of queued blocks.
+// Returns false on abort or if there is no motion queued that may release entries.
+static bool await_release (void)
+{
+    bool motion = plan_get_current_block() != NULL || (sys.state & (STATE_CYCLE|STATE_HOLD));
+
+    if(motion)
+        protocol_auto_cycle_start();
+
+    return protocol_execute_realtime() && motion;
+}
+
+static void update_stats (pool_t *pool)
+{
+    pool->allocated++;
+    pool->stats.used = (uint16_t)(pool->allocated - pool->released - pool->released_isr);
+    if(pool->stats.used > pool->stats.high_water)
+        pool->stats.high_water = pool->stats.used;
+}
+
+// Output commands
+
+static command_entry_t *find_command (void)
+{
+    uint_fast16_t idx = command_pool.next, n = OUTPUT_COMMAND_POOL_SIZE;
+
+    do {
+        if(!commands[idx].used) {
+            command_pool.next = idx == OUTPUT_COMMAND_POOL_SIZE - 1 ? 0 : idx + 1;
+            return &commands[idx];
+        }
+        idx = idx == OUTPUT_COMMAND_POOL_SIZE - 1 ? 0 : idx + 1;
+    } while(--n);
+
+    return NULL;
+}
+
+output_command_t *output_command_alloc (output_command_t *command)
+{
+    command_entry_t *entry;
+
+    if((entry = find_command()) == NULL) {
+
+        bool wait;
+
+        command_pool.stats.waits++;
+
+        do {
+            wait = await_release();
+        } while((entry = find_command()) == NULL && wait);
+
+        if(entry == NULL) {
+            command_pool.stats.failed++;
+            return NULL;
+        }
+    }
+
+    memcpy(&entry->command, command, sizeof(output_command_t));
+    entry->command.next = NULL;
+    entry->used = true;
+
+    update_stats(&command_pool);
+
+    return &entry->command;
+}
+
+static inline bool is_command (output_command_t *command)
+{
+    return (command_entry_t *)command >= commands && (command_entry_t *)command < &commands[OUTPUT_COMMAND_POOL_SIZE];
+}
+
+void output_commands_release (output_command_t *command)
+{
+    output_command_t *next;
+
+    while(command) {
+        next = command->next;
+        if(is_command(command) && ((command_entry_t *)command)->used) {
+            ((command_entry_t *)command)->used = false;
+            command_pool.released++;
+        }
+        command = next;
+    }
+}
+
+ISR_CODE void output_commands_release_isr (output_command_t *command)
+{
+    output_command_t *next;
+
+    while(command) {
+        next = command->next;
+        if(is_command(command) && ((command_entry_t *)command)->used) {
+            ((command_entry_t *)command)->used = false;
+            command_pool.released_isr++;
+        }
+        command = next;
+    }
+}
+
+pool_stats_t *pool_get_output_command_stats (void)
+{
+    command_pool.stats.used = (uint16_t)(command_pool.allocated - command_pool.released - command_pool.released_isr);
+
+    return &command_pool.stats;
+}
+
+// Messages
+
+static message_entry_t *find_message (void)
+{
+    uint_fast16_t idx = message_pool.next, n = MESSAGE_POOL_SIZE;
+
+    do {
+        if(!messages[idx].used) {
+            message_pool.next = idx == MESSAGE_POOL_SIZE - 1 ? 0 : idx + 1;
+            return &messages[idx];
+        }
+        idx = idx == MESSAGE_POOL_SIZE - 1 ? 0 : idx + 1;
+    } while(--n);
+
+    return NULL;
+}
+
+char *message_alloc (const char *message)
+{
+    message_entry_t *entry;
+
+    if((entry = find_message()) == NULL) {
+
+        bool wait;
+
+        message_pool.stats.waits++;
+
+        do {
+            wait = await_release();
+        } while((entry = find_message()) == NULL && wait);
+
+        if(entry == NULL) {
+            message_pool.stats.failed++;
+            return NULL;
+        }
+    }
+
+    strncpy(entry->text, message, MESSAGE_LENGTH_MAX);
+    entry->text[MESSAGE_LENGTH_MAX] = '\0';
+    entry->used = true;
+
+    update_stats(&message_pool);
+
+    return entry->text;
+}
+
+void message_release (char *message)
+{
+    message_entry_t *entry = (message_entry_t *)message;
+
+    if(entry >= messages && entry < &messages[MESSAGE_POOL_SIZE] && entry->used) {
+        entry->used = false;
+        message_pool.released++;
+    }
+}
+
+ISR_CODE void message_release_isr (char *message)
+{
+    message_entry_t *entry = (message_entry_t *)message;
+
+    if(entry >= messages && entry < &messages[MESSAGE_POOL_SIZE] && entry->used) {
+        entry->used = false;
+        message_pool.released_isr++;
+    }
+}
+
+pool_stats_t *pool_get_message_stats (void)
+{
+    message_pool.stats.used = (uint16_t)(message_pool.allocated - message_pool.released - message_pool.released_isr);
+
+    return &message_pool.stats;
+}
@@ -0,0 +1,68 @@
+/*
+  pool.h - fixed size pools for block messages and synchronized output commands
+
+  Part of GrblHAL
+
+  Copyright (c) 2020 Terje Io
+
+  Grbl is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  Grbl is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with Grbl.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+// Number of output commands (M62, M63 and M67) that can be queued for execution synchronized with motion.
+#ifndef OUTPUT_COMMAND_POOL_SIZE
+  #define OUTPUT_COMMAND_POOL_SIZE BLOCK_BUFFER_SIZE
+#endif
+
+// Number of messages from (MSG,...) comments that can be queued for display when the block is executed.
+#ifndef MESSAGE_POOL_SIZE
+  #define MESSAGE_POOL_SIZE (BLOCK_BUFFER_SIZE / 4)
+#endif
+
+// Max length of messages, longer messages are truncated.
+#ifndef MESSAGE_LENGTH_MAX
+  #define MESSAGE_LENGTH_MAX 80
+#endif
+
+typedef struct {
+    uint16_t size;          // Number of entries in pool
+    uint16_t used;          // Number of entries currently allocated
+    uint16_t high_water;    // Max number of entries allocated at the same time
+    uint32_t waits;         // Number of allocations that had to wait for an entry to be released
+    uint32_t failed;        // Number of failed allocations
+} pool_stats_t;
+
+// Releases all entries, called on soft reset when motion is stopped.
+void pool_reset (void);
+
+// Allocates an output command and copies the command into it. Returns NULL if the pool is exhausted.
+output_command_t *output_command_alloc (output_command_t *command);
+// Releases a list of output commands.
+void output_commands_release (output_command_t *command);
+// Releases a list of output commands, for use by the stepper interrupt handler.
+void output_commands_release_isr (output_command_t *command);
+
+// Allocates a message and copies the text into it. Returns NULL if the pool is exhausted.
+char *message_alloc (const char *message);
+// Releases a message.
+void message_release (char *message);
+// Releases a message, for use by the stepper interrupt handler.
+void message_release_isr (char *message);
+
+pool_stats_t *pool_get_output_command_stats (void);
+pool_stats_t *pool_get_message_stats (void);
+
+#endif
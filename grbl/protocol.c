@@ -49,6 +49,47 @@ static user_message_t user_message = {NULL, 0, 0, false};
 static const char *msg = "(MSG,";
 static void protocol_exec_rt_suspend();
 
+// Queue of block messages to be displayed, added to by the stepper interrupt handler when a block is executed
+// and displayed by the foreground process. Single producer/single consumer, no locking needed.
+// NOTE: queued messages are pool entries, the queue has room for all of them.
+#define MESSAGE_QUEUE_SIZE (MESSAGE_POOL_SIZE + 1)
+
+static struct {
+    volatile uint_fast16_t head;
+    volatile uint_fast16_t tail;
+    volatile uint32_t dropped;
+    char *message[MESSAGE_QUEUE_SIZE];
+} messages = {0};
+
+static char span[STREAM_SPAN_SIZE]; // Input fetched from the stream, processed by the main loop.
+
+// Set by the realtime command handler when the stream input buffer is flushed, the main loop then discards
+// input fetched but not yet processed.
+static volatile bool span_discard = false;
+
+// Fetches input up to and including the next end of line character, or STREAM_SPAN_SIZE characters, into the
+// span buffer. Uses the read_span() handler when provided by the stream. Returns number of characters fetched.
+// NOTE: spans end at an end of line character so no input is left over when a line is executed and input
+//       is redirected, e.g. by a tool change.
+static uint_fast16_t stream_read_span (void)
+{
+    int16_t c;
+    uint_fast16_t len = 0;
+
+    span_discard = false;
+
+    if(hal.stream.read_span)
+        return hal.stream.read_span(span, STREAM_SPAN_SIZE);
+
+    while(len < STREAM_SPAN_SIZE && (c = hal.stream.read()) != SERIAL_NO_DATA) {
+        span[len++] = (char)c;
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    return len;
+}
+
 // add gcode to execute not originating from normal input stream
 bool protocol_enqueue_gcode (char *gcode)
 {
@@ -116,154 +157,168 @@ bool protocol_main_loop(bool cold_start)
     // ---------------------------------------------------------------------------------
 
     int16_t c;
+    uint_fast16_t span_idx, span_len;
     char eol = '\0';
     line_flags_t line_flags = {0};
     bool nocaps = false, gcode_error = false;
 
     xcommand[0] = '\0';
     user_message.show = keep_rt_commands = false;
+    messages.tail = messages.head; // Discard any messages pending from before a soft reset, entries are already released.
 
     while(true) {
 
         // Process one line of incoming stream data, as the data becomes available. Performs an
         // initial filtering by removing spaces and comments and capitalizing all letters.
-        while((c = hal.stream.read()) != SERIAL_NO_DATA) {
-
-            if(c == ASCII_CAN) {
-
-                eol = xcommand[0] = '\0';
-                keep_rt_commands = nocaps = gcode_error = user_message.show = false;
-                char_counter = line_flags.value = 0;
-                gc_state.last_error = Status_OK;
-
-                if (sys.state == STATE_JOG) // Block all other states from invoking motion cancel.
-                    system_set_exec_state_flag(EXEC_MOTION_CANCEL);
-
-            } else if ((c == '\n') || (c == '\r')) { // End of line reached
-
-                // Check for possible secondary end of line character, do not process as empty line
-                // if part of crlf (or lfcr pair) as this produces a possibly unwanted double response
-                if(char_counter == 0 && eol && eol != c) {
-                    eol = '\0';
-                    continue;
-                } else
-                    eol = (char)c;
+        // Input is fetched a span at a time, the span is scanned until processed or discarded by a stop or cancel.
+        while((span_len = stream_read_span())) {
 
-                if(!protocol_execute_realtime()) // Runtime command check point.
-                    return !sys.flags.exit;      // Bail to calling function upon system abort
+            for(span_idx = 0; span_idx < span_len && !span_discard; span_idx++) {
 
-                line[char_counter] = '\0'; // Set string termination character.
+                c = (uint8_t)span[span_idx];
 
-              #ifdef REPORT_ECHO_LINE_RECEIVED
-                report_echo_line_received(line);
-              #endif
+                if(c == ASCII_CAN) {
 
-                // Direct and execute one line of formatted input, and report status of execution.
-                if (line_flags.overflow) // Report line overflow error.
-                    gc_state.last_error = Status_Overflow;
-                else if ((line[0] == '\0' || char_counter == 0) && !user_message.show) // Empty or comment line. For syncing purposes.
+                    eol = xcommand[0] = '\0';
+                    keep_rt_commands = nocaps = gcode_error = user_message.show = false;
+                    char_counter = line_flags.value = 0;
                     gc_state.last_error = Status_OK;
-                else if (line[0] == '$') {// Grbl '$' system command
-                    gcode_error = false;
-                    if((gc_state.last_error = system_execute_line(line)) == Status_LimitsEngaged) {
-                        set_state(STATE_ALARM); // Ensure alarm state is active.
-                        report_alarm_message(Alarm_LimitsEngaged);
-                        hal.report.feedback_message(Message_CheckLimits);
-                    }
-                } else if (line[0] == '[' && hal.user_command_execute) {
-                    gcode_error = false;
-                    gc_state.last_error = hal.user_command_execute(line);
-                } else if (sys.state & (STATE_ALARM|STATE_ESTOP|STATE_JOG)) // Everything else is gcode. Block if in alarm, eStop or jog mode.
-                    gc_state.last_error = Status_SystemGClock;
-                else if(!gcode_error) { // Parse and execute g-code block.
-                    gc_state.last_error = gc_execute_block(line, user_message.show ? user_message.message : NULL);
+
+                    if (sys.state == STATE_JOG) // Block all other states from invoking motion cancel.
+                        system_set_exec_state_flag(EXEC_MOTION_CANCEL);
+
+                } else if ((c == '\n') || (c == '\r')) { // End of line reached
+
+                    // Check for possible secondary end of line character, do not process as empty line
+                    // if part of crlf (or lfcr pair) as this produces a possibly unwanted double response
+                    if(char_counter == 0 && eol && eol != c) {
+                        eol = '\0';
+                        continue;
+                    } else
+                        eol = (char)c;
+
+                    mc_arc_resume(true); // Queue remaining segments of any pending arc before executing the line.
+
+                    if(!protocol_execute_realtime()) // Runtime command check point.
+                        return !sys.flags.exit;      // Bail to calling function upon system abort
+
+                    line[char_counter] = '\0'; // Set string termination character.
+
+                  #ifdef REPORT_ECHO_LINE_RECEIVED
+                    report_echo_line_received(line);
+                  #endif
+
+                    // Direct and execute one line of formatted input, and report status of execution.
+                    if (line_flags.overflow) // Report line overflow error.
+                        gc_state.last_error = Status_Overflow;
+                    else if ((line[0] == '\0' || char_counter == 0) && !user_message.show) // Empty or comment line. For syncing purposes.
+                        gc_state.last_error = Status_OK;
+                    else if (line[0] == '$') {// Grbl '$' system command
+                        gcode_error = false;
+                        mc_blend_resume(true); // Queue any held back blended line before executing the command.
+                        if((gc_state.last_error = system_execute_line(line)) == Status_LimitsEngaged) {
+                            set_state(STATE_ALARM); // Ensure alarm state is active.
+                            report_alarm_message(Alarm_LimitsEngaged);
+                            hal.report.feedback_message(Message_CheckLimits);
+                        }
+                    } else if (line[0] == '[' && hal.user_command_execute) {
+                        gcode_error = false;
+                        gc_state.last_error = hal.user_command_execute(line);
+                    } else if (sys.state & (STATE_ALARM|STATE_ESTOP|STATE_JOG)) // Everything else is gcode. Block if in alarm, eStop or jog mode.
+                        gc_state.last_error = Status_SystemGClock;
+                    else if(!gcode_error) { // Parse and execute g-code block.
+                        gc_state.last_error = gc_execute_block(line, user_message.show ? user_message.message : NULL);
 #if COMPATIBILITY_LEVEL == 0
-                    gcode_error = gc_state.last_error != Status_OK;
+                        gcode_error = gc_state.last_error != Status_OK;
 #endif
-                }
+                    }
 
-                // Add a short delay for each block processed in Check Mode to
-                // avoid overwhelming the sender with fast reply messages.
-                // This is likely to happen when streaming is done via a protocol where
-                // the speed is not limited to 115200 baud. An example is native USB streaming.
+                    // Add a short delay for each block processed in Check Mode to
+                    // avoid overwhelming the sender with fast reply messages.
+                    // This is likely to happen when streaming is done via a protocol where
+                    // the speed is not limited to 115200 baud. An example is native USB streaming.
 #if CHECK_MODE_DELAY
-                if(sys.state == STATE_CHECK_MODE)
-                    hal.delay_ms(CHECK_MODE_DELAY, NULL);
+                    if(sys.state == STATE_CHECK_MODE)
+                        hal.delay_ms(CHECK_MODE_DELAY, NULL);
 #endif
 
-                hal.report.status_message(gc_state.last_error);
-
-                // Reset tracking data for next line.
-                keep_rt_commands = nocaps = user_message.show = false;
-                char_counter = line_flags.value = 0;
-
-            } else if (c <= (nocaps ? ' ' - 1 : ' ') || line_flags.value) {
-                // Throw away all whitepace, control characters, comment characters and overflow characters.
-                if(c >= ' ' && line_flags.comment_parentheses) {
-                    if(user_message.tracker == 5)
-                        user_message.message[user_message.idx++] = c == ')' ? '\0' : c;
-                    else if(user_message.tracker > 0 && CAPS(c) == msg[user_message.tracker])
-                        user_message.tracker++;
-                    else
-                        user_message.tracker = 0;
-                    if (c == ')') {
-                        // End of '()' comment. Resume line.
-                        line_flags.comment_parentheses = Off;
-                        keep_rt_commands = false;
-                        user_message.show = user_message.show || user_message.tracker == 5;
+                    hal.report.status_message(gc_state.last_error);
+
+                    // Reset tracking data for next line.
+                    keep_rt_commands = nocaps = user_message.show = false;
+                    char_counter = line_flags.value = 0;
+
+                } else if (c <= (nocaps ? ' ' - 1 : ' ') || line_flags.value) {
+                    // Throw away all whitepace, control characters, comment characters and overflow characters.
+                    if(c >= ' ' && line_flags.comment_parentheses) {
+                        if(user_message.tracker == 5)
+                            user_message.message[user_message.idx++] = c == ')' ? '\0' : c;
+                        else if(user_message.tracker > 0 && CAPS(c) == msg[user_message.tracker])
+                            user_message.tracker++;
+                        else
+                            user_message.tracker = 0;
+                        if (c == ')') {
+                            // End of '()' comment. Resume line.
+                            line_flags.comment_parentheses = Off;
+                            keep_rt_commands = false;
+                            user_message.show = user_message.show || user_message.tracker == 5;
+                        }
                     }
-                }
-            } else {
-                switch(c) {
-
-                    case '/':
-                        if(char_counter == 0)
-                            line_flags.block_delete = sys.flags.block_delete_enabled;
-                        break;
-
-                    case '$':
-                    case '[':
-                        // Do not uppercase system or user commands - will destroy passwords etc...
-                        if(char_counter == 0)
-                            nocaps = keep_rt_commands = true;
-                        break;
-
-                    case '(':
-                        if(!keep_rt_commands) {
-                            // Enable comments flag and ignore all characters until ')' or EOL unless it is a message.
-                            // NOTE: This doesn't follow the NIST definition exactly, but is good enough for now.
-                            // In the future, we could simply remove the items within the comments, but retain the
-                            // comment control characters, so that the g-code parser can error-check it.
-                            if((line_flags.comment_parentheses = !line_flags.comment_semicolon)) {
-                                if(hal.show_message) {
-                                    if(user_message.message == NULL)
-                                        user_message.message = malloc(LINE_BUFFER_SIZE);
-                                    if(user_message.message) {
-                                        user_message.idx = 0;
-                                        user_message.tracker = 1;
+                } else {
+                    switch(c) {
+
+                        case '/':
+                            if(char_counter == 0)
+                                line_flags.block_delete = sys.flags.block_delete_enabled;
+                            break;
+
+                        case '$':
+                        case '[':
+                            // Do not uppercase system or user commands - will destroy passwords etc...
+                            if(char_counter == 0)
+                                nocaps = keep_rt_commands = true;
+                            break;
+
+                        case '(':
+                            if(!keep_rt_commands) {
+                                // Enable comments flag and ignore all characters until ')' or EOL unless it is a message.
+                                // NOTE: This doesn't follow the NIST definition exactly, but is good enough for now.
+                                // In the future, we could simply remove the items within the comments, but retain the
+                                // comment control characters, so that the g-code parser can error-check it.
+                                if((line_flags.comment_parentheses = !line_flags.comment_semicolon)) {
+                                    if(hal.show_message) {
+                                        if(user_message.message == NULL)
+                                            user_message.message = malloc(LINE_BUFFER_SIZE);
+                                        if(user_message.message) {
+                                            user_message.idx = 0;
+                                            user_message.tracker = 1;
+                                        }
                                     }
+                                    keep_rt_commands = true;
                                 }
-                                keep_rt_commands = true;
                             }
-                        }
-                        break;
+                            break;
 
-                    case ';':
-                        // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
-                        if(!keep_rt_commands) {
-                            if((line_flags.comment_semicolon = !line_flags.comment_parentheses))
-                                keep_rt_commands = true;
-                        }
-                        break;
+                        case ';':
+                            // NOTE: ';' comment to EOL is a LinuxCNC definition. Not NIST.
+                            if(!keep_rt_commands) {
+                                if((line_flags.comment_semicolon = !line_flags.comment_parentheses))
+                                    keep_rt_commands = true;
+                            }
+                            break;
+                    }
+                    if (line_flags.value == 0 && !(line_flags.overflow = char_counter >= (LINE_BUFFER_SIZE - 1)))
+                        line[char_counter++] = nocaps ? c : CAPS(c);
                 }
-                if (line_flags.value == 0 && !(line_flags.overflow = char_counter >= (LINE_BUFFER_SIZE - 1)))
-                    line[char_counter++] = nocaps ? c : CAPS(c);
             }
         }
 
         // Handle extra command (internal stream)
         if(xcommand[0] != '\0') {
 
+            mc_arc_resume(true);
+            mc_blend_resume(true);
+
             if (xcommand[0] == '$') // Grbl '$' system command
                 system_execute_line(xcommand);
             else if (sys.state & (STATE_ALARM|STATE_ESTOP|STATE_JOG)) // Everything else is gcode. Block if in alarm, eStop or jog state.
@@ -282,6 +337,12 @@ bool protocol_main_loop(bool cold_start)
         if(!protocol_execute_realtime() && sys.abort) // Runtime command check point.
             return !sys.flags.exit;                   // Bail to main() program loop to reset system.
 
+        // Queue more segments of any pending arc as planner space frees up, discards the arc on cancel.
+        mc_arc_resume(false);
+
+        // Queue any held back blended line when the planner has run empty, discards the line on cancel.
+        mc_blend_resume(false);
+
         sys.cancel = false;
 
         // Check for sleep conditions and execute auto-park, if timeout duration elapses.
@@ -296,6 +357,10 @@ bool protocol_main_loop(bool cold_start)
 bool protocol_buffer_synchronize ()
 {
     bool ok = true;
+
+    mc_arc_resume(true); // Queue remaining segments of any pending arc.
+    mc_blend_resume(true); // Queue any held back blended line.
+
     // If system is queued, ensure cycle resumes if the auto start flag is present.
     protocol_auto_cycle_start();
     while ((ok = protocol_execute_realtime()) && (plan_get_current_block() || sys.state == STATE_CYCLE));
@@ -345,27 +410,45 @@ bool protocol_execute_realtime ()
     return !ABORTED;
 }
 
-// Dangerous? This fn may be called from stepper ISR and will block (possibly forever?) if a previous message is beeing displayed...
-// Use a real queue or "double buffering" instead of spin lock?
-void protocol_message (char *message)
+// Queues a message for display by the foreground process, called from the stepper ISR when a block is executed.
+// Returns false if the message was dropped because the queue is full.
+ISR_CODE bool protocol_enqueue_message (char *message)
 {
-    static volatile bool spin_lock = false;
+    uint_fast16_t bptr = messages.head == MESSAGE_QUEUE_SIZE - 1 ? 0 : messages.head + 1;
+
+    if(bptr == messages.tail) {
+        messages.dropped++;
+        message_release_isr(message);
+        return false;
+    }
+
+    messages.message[messages.head] = message;
+    messages.head = bptr;
+
+    return true;
+}
 
-    while(spin_lock);
+// Displays queued messages in order, then message if provided. Called from the foreground process only.
+void protocol_message (char *message)
+{
+    uint_fast16_t tail;
 
-    spin_lock = true;
+    while((tail = messages.tail) != messages.head) {
+        hal.show_message(messages.message[tail]);
+        message_release(messages.message[tail]);
+        messages.tail = tail == MESSAGE_QUEUE_SIZE - 1 ? 0 : tail + 1;
+    }
 
     if(message) {
-        if(sys.message)
-            free(sys.message);
-        sys.message = message;
-    } else if(sys.message) {
-        hal.show_message(sys.message);
-        free(sys.message);
-        sys.message = NULL;
+        hal.show_message(message);
+        message_release(message);
     }
+}
 
-    spin_lock = false;
+// Returns number of messages dropped because the message queue was full.
+uint32_t protocol_get_messages_dropped (void)
+{
+    return messages.dropped;
 }
 
 // Executes run-time commands, when required. This function primarily operates as Grbl's state
@@ -375,8 +458,8 @@ bool protocol_exec_rt_system ()
 {
     uint_fast16_t rt_exec;
 
-    // Display message if provided
-    if(sys.message)
+    // Display queued messages
+    if(messages.tail != messages.head)
         protocol_message(NULL);
 
     if (sys_rt_exec_alarm && (rt_exec = system_clear_exec_alarm())) { // Enter only if any bit flag is true
@@ -603,6 +686,9 @@ bool protocol_exec_rt_system ()
         }
     } // End execute overrides.
 
+    // Continue planner recalculation, if stopped early.
+    plan_resume_recalculation();
+
     // Reload step segment buffer
     if (sys.state & (STATE_CYCLE | STATE_HOLD | STATE_SAFETY_DOOR | STATE_HOMING | STATE_SLEEP| STATE_JOG))
         st_prep_buffer();
@@ -640,6 +726,57 @@ static void protocol_exec_rt_suspend ()
     }
 }
 
+// Characters that may be picked off by protocol_enqueue_realtime_command(), one bit per character code.
+// Control characters except end of line, the legacy realtime commands and top bit set characters.
+static const uint32_t rt_candidates[8] = {
+    0xFFFFDBFF, 0x80000002, 0x00000000, 0xC0000000,
+    0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF
+};
+
+// Adds a block of received data to a stream input buffer with realtime commands picked off, the result is the same
+// as calling hal.stream.enqueue_realtime_command() for each character. Runs of characters that cannot be realtime
+// commands are block copied to the buffer. Returns the number of characters consumed, less than length if the buffer is full.
+// Called from input stream interrupt handler or polling task.
+ISR_CODE uint_fast16_t protocol_enqueue_input (stream_rx_buffer_t *rxbuf, const char *data, uint_fast16_t length)
+{
+    const uint8_t *s = (const uint8_t *)data;
+    bool scan = hal.stream.enqueue_realtime_command == protocol_enqueue_realtime_command;
+    uint_fast16_t consumed = 0, run, free, chunk, head;
+
+    while(consumed < length) {
+
+        head = rxbuf->head;
+        if((free = (RX_BUFFER_SIZE - 1) - BUFCOUNT(head, rxbuf->tail, RX_BUFFER_SIZE)) == 0)
+            break; // Buffer full, leave remaining data with the caller
+
+        run = 0;
+        if(scan) while(consumed + run < length && !(rt_candidates[s[consumed + run] >> 5] & (1UL << (s[consumed + run] & 0x1F))))
+            run++;
+
+        if(run) {
+            if(run > free)
+                run = free;
+            if((chunk = RX_BUFFER_SIZE - head) > run)
+                chunk = run;
+            memcpy(&rxbuf->data[head], &s[consumed], chunk);
+            if(run > chunk)
+                memcpy(rxbuf->data, &s[consumed + chunk], run - chunk);
+            rxbuf->head = (head + run) & (RX_BUFFER_SIZE - 1);
+            consumed += run;
+        } else {
+            // NOTE: the handler may flush the buffer, head is reloaded.
+            if(!hal.stream.enqueue_realtime_command((char)s[consumed])) {
+                head = rxbuf->head;
+                rxbuf->data[head] = (char)s[consumed];
+                rxbuf->head = (head + 1) & (RX_BUFFER_SIZE - 1);
+            }
+            consumed++;
+        }
+    }
+
+    return consumed;
+}
+
 // Pick off (drop) real-time command characters from input stream.
 // These characters are not passed into the main buffer,
 // but rather sets system state flag bits for later execution by protocol_exec_rt_system().
@@ -662,6 +799,7 @@ ISR_CODE bool protocol_enqueue_realtime_command (char c)
             system_set_exec_state_flag(EXEC_STOP);
             char_counter = 0;
             hal.stream.cancel_read_buffer();
+            span_discard = true;
             drop = true;
             break;
 
@@ -710,6 +848,7 @@ ISR_CODE bool protocol_enqueue_realtime_command (char c)
             char_counter = 0;
             drop = true;
             hal.stream.cancel_read_buffer();
+            span_discard = true;
 #ifdef KINEMATICS_API // needed when kinematics algorithm segments long jog distances (as it blocks reading from input stream)
             if (sys.state & STATE_JOG) // Block all other states from invoking motion cancel.
                 system_set_exec_state_flag(EXEC_MOTION_CANCEL);
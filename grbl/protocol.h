@@ -32,6 +32,16 @@
   #define LINE_BUFFER_SIZE 257 // 256 characters plus terminator
 #endif
 
+// Size of the buffer input is fetched into by the main loop. Input is fetched up to and including the next
+// end of line character so a complete line typically is fetched with a single call to the optional read_span()
+// handler of the stream, set to 1 to process input character by character.
+#ifndef STREAM_SPAN_SIZE
+  #define STREAM_SPAN_SIZE 64
+#endif
+#if STREAM_SPAN_SIZE < 1
+  #error "STREAM_SPAN_SIZE must be at least 1"
+#endif
+
 // Starts Grbl main loop. It handles all incoming characters from the input stream and executes
 // them as they complete. It is also responsible for finishing the initialization procedures.
 bool protocol_main_loop(bool cold_start);
@@ -47,8 +57,11 @@ void protocol_auto_cycle_start();
 bool protocol_buffer_synchronize();
 
 bool protocol_enqueue_realtime_command (char c);
+uint_fast16_t protocol_enqueue_input (stream_rx_buffer_t *rxbuf, const char *data, uint_fast16_t length);
 bool protocol_enqueue_gcode (char *data);
 void protocol_message (char *message);
+bool protocol_enqueue_message (char *message);
+uint32_t protocol_get_messages_dropped (void);
 
 // work in progress...
 //void set_state (uint_fast16_t state);
@@ -36,10 +36,13 @@
 #endif
 
 static char buf[(STRLEN_COORDVALUE + 1) * N_AXIS];
+static char rt_buf[REPORT_RT_BUFFER_SIZE], *rt_append; // Realtime report is composed here before output
 static char *(*get_axis_values)(float *axis_values);
 static char *(*get_rate_value)(float value);
 static uint8_t override_counter = 0; // Tracks when to add override data to status reports.
 static uint8_t wco_counter = 0;      // Tracks when to add work coordinate offset data to status reports.
+static uint8_t binary_status_seq = 0; // Binary status frame sequence number.
+static stream_write_ptr binary_status_write = NULL; // Output of the stream that enabled binary status frames.
 alarm_code_t current_alarm = Alarm_None;
 
 // Append a number of strings to the static buffer
@@ -64,6 +67,15 @@ static char *appendbuf (int argc, ...)
     return buf;
 }
 
+// Copy string, returns pointer to null terminator of the copy.
+inline static char *strappend (char *dst, const char *src)
+{
+    while((*dst = *src++))
+        dst++;
+
+    return dst;
+}
+
 static char *map_coord_system (uint8_t idx)
 {
     uint8_t g5x = idx + 54;
@@ -81,18 +93,19 @@ static char *map_coord_system (uint8_t idx)
 static char *get_axis_values_mm (float *axis_values)
 {
     uint_fast32_t idx;
-
-    buf[0] = '\0';
+    char *s = buf;
 
     for (idx = 0; idx < N_AXIS; idx++) {
         if(idx == X_AXIS && gc_state.modal.diameter_mode)
-            strcat(buf, ftoa(axis_values[idx] * 2.0f, N_DECIMAL_COORDVALUE_MM));
+            s = strappend(s, ftoa(axis_values[idx] * 2.0f, N_DECIMAL_COORDVALUE_MM));
         else
-            strcat(buf, ftoa(axis_values[idx], N_DECIMAL_COORDVALUE_MM));
+            s = strappend(s, ftoa(axis_values[idx], N_DECIMAL_COORDVALUE_MM));
         if (idx < (N_AXIS - 1))
-            strcat(buf, ",");
+            *s++ = ',';
     }
 
+    *s = '\0';
+
     return buf;
 }
 
@@ -100,18 +113,19 @@ static char *get_axis_values_mm (float *axis_values)
 static char *get_axis_values_inches (float *axis_values)
 {
     uint_fast32_t idx;
-
-    buf[0] = '\0';
+    char *s = buf;
 
     for (idx = 0; idx < N_AXIS; idx++) {
         if(idx == X_AXIS && gc_state.modal.diameter_mode)
-            strcat(buf, ftoa(axis_values[idx] * INCH_PER_MM * 2.0f, N_DECIMAL_COORDVALUE_INCH));
+            s = strappend(s, ftoa(axis_values[idx] * INCH_PER_MM * 2.0f, N_DECIMAL_COORDVALUE_INCH));
         else
-            strcat(buf, ftoa(axis_values[idx] * INCH_PER_MM, N_DECIMAL_COORDVALUE_INCH));
+            s = strappend(s, ftoa(axis_values[idx] * INCH_PER_MM, N_DECIMAL_COORDVALUE_INCH));
         if (idx < (N_AXIS - 1))
-            strcat(buf, ",");
+            *s++ = ',';
     }
 
+    *s = '\0';
+
     return buf;
 }
 
@@ -331,6 +345,9 @@ void report_grbl_settings (void)
     report_uint_setting(Setting_LimitPinsInvertMask, settings.limits.invert.mask);
     if(hal.probe_configure_invert_mask)
         report_uint_setting(Setting_InvertProbePin, settings.flags.invert_probe_pin);
+#if COMPATIBILITY_LEVEL <= 1
+    report_float_setting(Setting_Jerk, settings.jerk / (60.0f * 60.0f * 60.0f), N_DECIMAL_SETTINGVALUE);
+#endif
     report_uint_setting(Setting_StatusReportMask, settings.status_report.mask |
                                                    (settings.flags.force_buffer_sync_on_wco_change ? bit(8) : 0) |
                                                     (settings.flags.report_alarm_substate ? bit(9) : 0));
@@ -612,6 +629,17 @@ void report_gcode_modes (void)
         hal.stream.write(buf);
     }
 
+    if(gc_state.modal.control != ControlMode_ExactPath) {
+        hal.stream.write(gc_state.modal.control == ControlMode_ExactStop ? " G61.1" : " G64");
+        if(gc_state.modal.control == ControlMode_PathBlending && gc_state.path_tolerance > 0.0f) {
+            hal.stream.write(" P");
+            if(settings.flags.report_inches)
+                hal.stream.write(ftoa(gc_state.path_tolerance * INCH_PER_MM, N_DECIMAL_COORDVALUE_INCH));
+            else
+                hal.stream.write(ftoa(gc_state.path_tolerance, N_DECIMAL_COORDVALUE_MM));
+        }
+    }
+
 #endif
 
     if (gc_state.modal.program_flow) {
@@ -868,6 +896,149 @@ void report_echo_line_received (char *line)
 }
 
 
+// Appends string to the realtime report buffer, outputs the buffer contents first if full.
+// Also passed to the driver for adding its data to the report.
+static void rt_write (const char *s)
+{
+    while(*s) {
+        if(rt_append == &rt_buf[REPORT_RT_BUFFER_SIZE - 1]) {
+            *rt_append = '\0';
+            hal.stream.write_all(rt_buf);
+            rt_append = rt_buf;
+        }
+        *rt_append++ = *s++;
+    }
+}
+
+// Little endian serialization helpers for the binary status frame, return pointer to next byte.
+inline static uint8_t *put_u16 (uint8_t *p, uint16_t value)
+{
+    *p++ = (uint8_t)value;
+    *p++ = (uint8_t)(value >> 8);
+
+    return p;
+}
+
+inline static uint8_t *put_u32 (uint8_t *p, uint32_t value)
+{
+    return put_u16(put_u16(p, (uint16_t)value), (uint16_t)(value >> 16));
+}
+
+inline static uint8_t *put_float (uint8_t *p, float value)
+{
+    union {
+        float f;
+        uint32_t u;
+    } bits = { .f = value };
+
+    return put_u32(p, bits.u);
+}
+
+// Outputs the realtime status as a binary frame, see report.h for layout.
+static void report_realtime_status_binary (void)
+{
+    uint_fast8_t idx, code_idx;
+    uint8_t payload[BINARY_STATUS_PAYLOAD_SIZE + 2], *p = payload, flags = 0;
+    plan_block_t *cur_block = plan_get_current_block();
+    spindle_state_t sp_state = hal.spindle_get_state();
+    coolant_state_t cl_state = hal.coolant_get_state();
+    control_signals_t ctrl_pin_state = hal.system_control_get_state();
+
+    *p++ = BINARY_STATUS_VERSION;
+    *p++ = binary_status_seq++;
+    p = put_u16(p, (uint16_t)sys.state);
+
+    switch(sys.state) {
+
+        case STATE_HOLD:
+            *p++ = (uint8_t)sys.holding_state;
+            break;
+
+        case STATE_SAFETY_DOOR:
+            *p++ = (uint8_t)sys.parking_state;
+            break;
+
+        case STATE_ESTOP:
+        case STATE_ALARM:
+            *p++ = (uint8_t)current_alarm;
+            break;
+
+        default:
+            *p++ = 0;
+            break;
+    }
+
+    *p++ = N_AXIS;
+
+    for(idx = 0; idx < N_AXIS; idx++)
+        p = put_u32(p, (uint32_t)sys_position[idx]);
+
+    p = put_float(p, st_get_realtime_rate());
+    p = put_float(p, sys.spindle_rpm);
+    if(hal.spindle_get_data) {
+        p = put_float(p, hal.spindle_get_data(SpindleData_RPM).rpm);
+        flags |= bit(7);
+    } else
+        p = put_float(p, 0.0f);
+
+    p = put_u16(p, (uint16_t)plan_get_block_buffer_available());
+    p = put_u16(p, hal.stream.get_rx_buffer_available());
+    p = put_u32(p, cur_block ? (uint32_t)cur_block->line_number : 0);
+
+    *p++ = sys.override.feed_rate;
+    *p++ = sys.override.rapid_rate;
+    *p++ = sys.override.spindle_rpm;
+
+    ctrl_pin_state.deasserted = Off;
+    *p++ = ((axes_signals_t)hal.limits_get_state()).value;
+    *p++ = ctrl_pin_state.value;
+
+    if(hal.probe_get_state && hal.probe_get_state())
+        flags |= bit(0);
+    if(sp_state.on)
+        flags |= sp_state.ccw ? (bit(1)|bit(2)) : bit(1);
+    if(cl_state.flood)
+        flags |= bit(3);
+    if(cl_state.mist)
+        flags |= bit(4);
+    if(sys.flags.feed_hold_pending)
+        flags |= bit(5);
+    if(sys.flags.block_delete_enabled)
+        flags |= bit(6);
+    *p++ = flags;
+
+    put_u16(p, calc_crc16(payload, BINARY_STATUS_PAYLOAD_SIZE));
+
+    // COBS encode payload and CRC to the report buffer, each code byte holds the offset to the next zero.
+
+    rt_append = rt_buf;
+    *rt_append++ = BINARY_STATUS_SYNC;
+    code_idx = 1;
+    rt_append++;
+
+    for(idx = 0; idx < sizeof(payload); idx++) {
+        if(payload[idx] == 0) {
+            rt_buf[code_idx] = (char)(rt_append - &rt_buf[code_idx]);
+            code_idx = rt_append++ - rt_buf;
+        } else
+            *rt_append++ = (char)payload[idx];
+    }
+    rt_buf[code_idx] = (char)(rt_append - &rt_buf[code_idx]);
+    *rt_append = '\0';
+
+    binary_status_write(rt_buf); // Only to the stream that enabled frames, write_all may fan out to other senders.
+}
+
+void report_set_binary_status (bool on)
+{
+    if((sys.binary_status = on)) {
+        binary_status_seq = 0;
+        binary_status_write = hal.stream.write;
+        hal.stream.write(appendbuf(3, "[RB:", uitoa(BINARY_STATUS_VERSION), ","));
+        hal.stream.write(appendbuf(2, uitoa(BINARY_STATUS_FRAME_SIZE), "]\r\n"));
+    }
+}
+
  // Prints real-time data. This function grabs a real-time snapshot of the stepper subprogram
  // and the actual location of the CNC machine. Users may change the following function to their
  // specific needs, but the desired real-time data report must be as short as possible. This is
@@ -878,58 +1049,71 @@ void report_realtime_status (void)
     int32_t current_position[N_AXIS]; // Copy current state of the system position variable
     float print_position[N_AXIS];
 
+    if(sys.binary_status) {
+        if(hal.stream.write == binary_status_write) {
+            report_realtime_status_binary();
+            return;
+        }
+        sys.binary_status = false; // Output stream changed, other senders expect text reports.
+    }
+
     memcpy(current_position, sys_position, sizeof(sys_position));
     system_convert_array_steps_to_mpos(print_position, current_position);
 
+    rt_append = rt_buf;
+
     // Report current machine state and sub-states
-    hal.stream.write_all("<");
+    rt_write("<");
 
     switch (sys.state) {
 
         case STATE_IDLE:
-            hal.stream.write_all("Idle");
+            rt_write("Idle");
             break;
 
         case STATE_CYCLE:
-            hal.stream.write_all("Run");
+            rt_write("Run");
             if(sys.flags.feed_hold_pending)
-                hal.stream.write_all(":1");
+                rt_write(":1");
             break;
 
         case STATE_HOLD:
-            hal.stream.write_all(appendbuf(2, "Hold:", uitoa((uint32_t)(sys.holding_state - 1))));
+            rt_write("Hold:");
+            rt_write(uitoa((uint32_t)(sys.holding_state - 1)));
             break;
 
         case STATE_JOG:
-            hal.stream.write_all("Jog");
+            rt_write("Jog");
             break;
 
         case STATE_HOMING:
-            hal.stream.write_all("Home");
+            rt_write("Home");
             break;
 
         case STATE_ESTOP:
         case STATE_ALARM:
-            if(settings.flags.report_alarm_substate)
-                hal.stream.write_all(appendbuf(2, "Alarm:", uitoa((uint32_t)current_alarm)));
-            else
-                hal.stream.write_all("Alarm");
+            if(settings.flags.report_alarm_substate) {
+                rt_write("Alarm:");
+                rt_write(uitoa((uint32_t)current_alarm));
+            } else
+                rt_write("Alarm");
             break;
 
         case STATE_CHECK_MODE:
-            hal.stream.write_all("Check");
+            rt_write("Check");
             break;
 
         case STATE_SAFETY_DOOR:
-            hal.stream.write_all(appendbuf(2, "Door:", uitoa((uint32_t)sys.parking_state)));
+            rt_write("Door:");
+            rt_write(uitoa((uint32_t)sys.parking_state));
             break;
 
         case STATE_SLEEP:
-            hal.stream.write_all("Sleep");
+            rt_write("Sleep");
             break;
 
         case STATE_TOOL_CHANGE:
-            hal.stream.write_all("Tool");
+            rt_write("Tool");
             break;
     }
 
@@ -945,34 +1129,42 @@ void report_realtime_status (void)
     }
 
     // Report position
-    hal.stream.write_all(settings.status_report.machine_position ? "|MPos:" : "|WPos:");
-    hal.stream.write_all(get_axis_values(print_position));
+    rt_write(settings.status_report.machine_position ? "|MPos:" : "|WPos:");
+    rt_write(get_axis_values(print_position));
 
     // Returns planner and output stream buffer states.
 
     if (settings.status_report.buffer_state) {
-        hal.stream.write_all("|Bf:");
-        hal.stream.write_all(uitoa((uint32_t)plan_get_block_buffer_available()));
-        hal.stream.write_all(",");
-        hal.stream.write_all(uitoa(hal.stream.get_rx_buffer_available()));
+        rt_write("|Bf:");
+        rt_write(uitoa((uint32_t)plan_get_block_buffer_available()));
+        rt_write(",");
+        rt_write(uitoa(hal.stream.get_rx_buffer_available()));
     }
 
     if(settings.status_report.line_numbers) {
         // Report current line number
         plan_block_t *cur_block = plan_get_current_block();
-        if (cur_block != NULL && cur_block->line_number > 0)
-            hal.stream.write_all(appendbuf(2, "|Ln:", uitoa((uint32_t)cur_block->line_number)));
+        if (cur_block != NULL && cur_block->line_number > 0) {
+            rt_write("|Ln:");
+            rt_write(uitoa((uint32_t)cur_block->line_number));
+        }
     }
 
     // Report realtime feed speed
     if(settings.status_report.feed_speed) {
         if(hal.driver_cap.variable_spindle) {
-            hal.stream.write_all(appendbuf(2, "|FS:", get_rate_value(st_get_realtime_rate())));
-            hal.stream.write_all(appendbuf(2, ",", uitoa((uint32_t)sys.spindle_rpm)));
-            if(hal.spindle_get_data /* && sys.mpg_mode */)
-                hal.stream.write_all(appendbuf(2, ",", uitoa((uint32_t)hal.spindle_get_data(SpindleData_RPM).rpm)));
-        } else
-            hal.stream.write_all(appendbuf(2, "|F:", get_rate_value(st_get_realtime_rate())));
+            rt_write("|FS:");
+            rt_write(get_rate_value(st_get_realtime_rate()));
+            rt_write(",");
+            rt_write(uitoa((uint32_t)sys.spindle_rpm));
+            if(hal.spindle_get_data /* && sys.mpg_mode */) {
+                rt_write(",");
+                rt_write(uitoa((uint32_t)hal.spindle_get_data(SpindleData_RPM).rpm));
+            }
+        } else {
+            rt_write("|F:");
+            rt_write(get_rate_value(st_get_realtime_rate()));
+        }
     }
 
     if(settings.status_report.pin_state) {
@@ -1010,7 +1202,7 @@ void report_realtime_status (void)
                     *append++ = 'T';
             }
             *append = '\0';
-            hal.stream.write_all(buf);
+            rt_write(buf);
         }
     }
 
@@ -1043,19 +1235,22 @@ void report_realtime_status (void)
     if(sys.report.value || gc_state.tool_change) {
 
         if(sys.report.wco) {
-            hal.stream.write_all("|WCO:");
-            hal.stream.write_all(get_axis_values(wco));
+            rt_write("|WCO:");
+            rt_write(get_axis_values(wco));
         }
 
         if(sys.report.gwco) {
-            hal.stream.write_all("|WCS:G");
-            hal.stream.write_all(map_coord_system(gc_state.modal.coord_system.idx));
+            rt_write("|WCS:G");
+            rt_write(map_coord_system(gc_state.modal.coord_system.idx));
         }
 
         if(sys.report.overrides) {
-            hal.stream.write_all(appendbuf(2, "|Ov:", uitoa((uint32_t)sys.override.feed_rate)));
-            hal.stream.write_all(appendbuf(2, ",", uitoa((uint32_t)sys.override.rapid_rate)));
-            hal.stream.write_all(appendbuf(2, ",", uitoa((uint32_t)sys.override.spindle_rpm)));
+            rt_write("|Ov:");
+            rt_write(uitoa((uint32_t)sys.override.feed_rate));
+            rt_write(",");
+            rt_write(uitoa((uint32_t)sys.override.rapid_rate));
+            rt_write(",");
+            rt_write(uitoa((uint32_t)sys.override.spindle_rpm));
         }
 
         if(sys.report.spindle || sys.report.coolant || sys.report.tool || gc_state.tool_change) {
@@ -1080,35 +1275,41 @@ void report_realtime_status (void)
                 *append++ = 'T';
 
             *append = '\0';
-            hal.stream.write_all(buf);
+            rt_write(buf);
         }
 
         if(sys.report.scaling) {
             axis_signals_tostring(buf, gc_get_g51_state());
-            hal.stream.write_all("|Sc:");
-            hal.stream.write_all(buf);
+            rt_write("|Sc:");
+            rt_write(buf);
         }
 
         if(sys.report.mpg_mode && hal.driver_cap.mpg_mode)
-            hal.stream.write_all(sys.mpg_mode ? "|MPG:1" : "|MPG:0");
+            rt_write(sys.mpg_mode ? "|MPG:1" : "|MPG:0");
 
         if(sys.report.homed && sys.homing.mask)
-            hal.stream.write_all(sys.homing.mask == sys.homed.mask ? "|H:1" : "|H:0");
+            rt_write(sys.homing.mask == sys.homed.mask ? "|H:1" : "|H:0");
 
         if(sys.report.xmode && settings.flags.lathe_mode)
-            hal.stream.write_all(gc_state.modal.diameter_mode ? "|D:1" : "|D:0");
+            rt_write(gc_state.modal.diameter_mode ? "|D:1" : "|D:0");
 
-        if(sys.report.tool)
-            hal.stream.write_all(appendbuf(2, "|T:", uitoa((uint32_t)gc_state.tool->tool)));
+        if(sys.report.tool) {
+            rt_write("|T:");
+            rt_write(uitoa((uint32_t)gc_state.tool->tool));
+        }
     }
 
     if(hal.driver_rt_report)
-        hal.driver_rt_report(hal.stream.write_all, sys.report);
+        hal.driver_rt_report(rt_write, sys.report);
 
     sys.report.value = 0;
     sys.report.wco = settings.status_report.work_coord_offset && wco_counter == 0; // Set to report on next request
 
-    hal.stream.write_all(">\r\n");
+    rt_write(">\r\n");
+
+    // Output the report with a single write
+    *rt_append = '\0';
+    hal.stream.write_all(rt_buf);
 }
 
 
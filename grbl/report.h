@@ -24,6 +24,39 @@
 
 #include "system.h"
 
+#ifndef REPORT_RT_BUFFER_SIZE
+#define REPORT_RT_BUFFER_SIZE (2 * (STRLEN_COORDVALUE + 1) * N_AXIS + 160)
+#endif
+
+// Binary realtime status report, enabled by $RB=1 and disabled by $RB=0 or a reset. Frames are only output to
+// the stream that enabled them, the report reverts to text when the active output stream is switched.
+// A frame is a sync byte followed by the COBS encoded payload and CRC, COBS encoding removes all zero bytes
+// so that the frame can be output by the string based stream write functions. Frame size is fixed for a build
+// and reported on enable. Payload layout, multibyte values are little endian:
+//   0 uint8_t  version, BINARY_STATUS_VERSION
+//   1 uint8_t  sequence number, incremented for each frame
+//   2 uint16_t state, STATE_* bitmap
+//   4 uint8_t  substate, hold state when holding, parking state when door is open, alarm code in alarm state
+//   5 uint8_t  number of axes, N_AXIS
+//   6 int32_t  machine position in steps, one per axis
+// then
+//  +0 float    realtime feed rate, mm/min
+//  +4 float    programmed spindle speed, RPM
+//  +8 float    actual spindle speed, RPM, valid if flag bit 7 is set
+// +12 uint16_t planner blocks available
+// +14 uint16_t input stream buffer bytes available
+// +16 uint32_t line number of executing block, 0 if none
+// +20 uint8_t  feed, rapid and spindle override, percent
+// +23 uint8_t  limit pins, bit 0 is X axis
+// +24 uint8_t  control pins, control_signals_t bitmap
+// +25 uint8_t  flags, bit 0: probe triggered, 1: spindle on, 2: spindle CCW, 3: flood, 4: mist,
+//                         5: feed hold pending, 6: block delete enabled, 7: actual spindle speed valid
+// followed by uint16_t CRC-16/CCITT-FALSE of the payload.
+#define BINARY_STATUS_SYNC 0x81
+#define BINARY_STATUS_VERSION 1
+#define BINARY_STATUS_PAYLOAD_SIZE (32 + 4 * N_AXIS)
+#define BINARY_STATUS_FRAME_SIZE (BINARY_STATUS_PAYLOAD_SIZE + 4) // Sync byte, COBS overhead byte and CRC added
+
 // Initialize reporting subsystem
 void report_init (void);
 
@@ -54,6 +87,9 @@ void report_echo_line_received (char *line);
 // Prints realtime status report.
 void report_realtime_status (void);
 
+// Selects binary or text realtime status report format.
+void report_set_binary_status (bool on);
+
 // Prints recorded probe position.
 void report_probe_parameters (void);
 
@@ -41,6 +41,7 @@ const settings_t defaults = {
     .version = SETTINGS_VERSION,
 
     .junction_deviation = DEFAULT_JUNCTION_DEVIATION,
+    .jerk = DEFAULT_JERK,
     .arc_tolerance = DEFAULT_ARC_TOLERANCE,
     .g73_retract = DEFAULT_G73_RETRACT,
 
@@ -276,13 +277,6 @@ bool settings_read_tool_data (uint8_t tool, tool_data_t *tool_data)
 #endif
 }
 
-// Read Grbl global settings from persistent storage.
-bool read_global_settings ()
-{
-    // Check version-byte of eeprom
-    return hal.eeprom.type != EEPROM_None && SETTINGS_VERSION == hal.eeprom.get_byte(0) && hal.eeprom.memcpy_from_with_checksum((uint8_t *)&settings, EEPROM_ADDR_GLOBAL, sizeof(settings_t));
-}
-
 // Write Grbl global settings and version number to persistent storage
 void write_global_settings ()
 {
@@ -292,6 +286,30 @@ void write_global_settings ()
     }
 }
 
+// Read Grbl global settings from persistent storage.
+bool read_global_settings ()
+{
+    bool ok = false;
+
+    // Check version-byte of eeprom
+    if(hal.eeprom.type != EEPROM_None) switch(hal.eeprom.get_byte(0)) {
+
+        case SETTINGS_VERSION:
+            ok = hal.eeprom.memcpy_from_with_checksum((uint8_t *)&settings, EEPROM_ADDR_GLOBAL, sizeof(settings_t));
+            break;
+
+        case 15: // Version 15 is version 16 without the jerk setting at the end, migrate.
+            if((ok = hal.eeprom.memcpy_from_with_checksum((uint8_t *)&settings, EEPROM_ADDR_GLOBAL, offsetof(settings_t, jerk)))) {
+                settings.version = SETTINGS_VERSION;
+                settings.jerk = DEFAULT_JERK;
+                write_global_settings();
+            }
+            break;
+    }
+
+    return ok;
+}
+
 
 // Restore Grbl global settings to defaults and write to persistent storage
 void settings_restore (settings_restore_t restore) {
@@ -623,6 +641,10 @@ status_code_t settings_store_global_setting (setting_type_t setting, char *svalu
                 settings.g73_retract = value;
                 break;
 
+            case Setting_Jerk:
+                settings.jerk = value * 60.0f * 60.0f * 60.0f; // Convert to mm/min^3 for grbl internal use.
+                break;
+
             case Setting_PWMFreq:
                 settings.spindle.pwm_freq = value;
                 break;
@@ -28,7 +28,7 @@
 
 // Version of the persistent storage data. Will be used to migrate existing data from older versions of Grbl
 // when firmware is upgraded. Always stored in byte 0 of eeprom
-#define SETTINGS_VERSION 15  // NOTE: Check settings_reset() when moving to next version.
+#define SETTINGS_VERSION 16  // NOTE: Check read_global_settings() when moving to next version.
 
 // Define persistent storage memory address location values for Grbl settings and parameters
 // NOTE: 1KB persistent storage is the minimum required. The upper half is reserved for parameters and
@@ -89,6 +89,9 @@ typedef enum {
     Setting_InvertStepperEnable = 4,
     Setting_LimitPinsInvertMask = 5,
     Setting_InvertProbePin = 6,
+#if COMPATIBILITY_LEVEL <= 1
+    Setting_Jerk = 8,
+#endif
     Setting_StatusReportMask = 10,
     Setting_JunctionDeviation = 11,
     Setting_ArcTolerance = 12,
@@ -430,6 +433,8 @@ typedef struct {
     limit_settings_t limits;
     parking_settings_t parking;
     position_pid_t position;    // Used for synchronized motion
+    float jerk;                 // Jerk limit in mm/min^3, 0 for trapezoidal velocity profiles. Added in version 16,
+                                // must stay last so that version 15 settings can be migrated.
 } settings_t;
 
 // Setting structs that may be used by drivers
@@ -144,6 +144,36 @@ static inline uint_fast16_t invert_pwm (spindle_pwm_t *pwm_data, uint_fast16_t p
     return pwm_data->invert_pwm ? pwm_data->period - pwm_value - 1 : pwm_value;
 }
 
+// Spindle RPM to PWM conversion for RPM values above the minimum RPM.
+static uint_fast16_t rpm_to_pwm (spindle_pwm_t *pwm_data, float rpm, bool pid_limit)
+{
+    uint_fast16_t pwm_value;
+
+  #ifdef ENABLE_SPINDLE_LINEARIZATION
+    // Compute intermediate PWM value with linear spindle speed model via piecewise linear fit model.
+    uint_fast8_t idx = pwm_data->n_pieces;
+
+    if(idx) {
+        do {
+            idx--;
+            if(idx == 0 || rpm > pwm_data->piece[idx].rpm) {
+                pwm_value = floorf(pwm_data->piece[idx].start * rpm - pwm_data->piece[idx].end);
+                break;
+            }
+        } while(idx);
+    } else
+  #endif
+    // Compute intermediate PWM value with linear spindle speed model.
+    pwm_value = (uint_fast16_t)floorf((rpm - settings.spindle.rpm_min) * pwm_data->pwm_gradient) + pwm_data->min_value;
+
+    if(pwm_value >= (pid_limit ? pwm_data->period : pwm_data->max_value))
+        pwm_value = pid_limit ? pwm_data->period - 1 : pwm_data->max_value;
+    else if(pwm_value < pwm_data->min_value)
+        pwm_value = pwm_data->min_value;
+
+    return invert_pwm(pwm_data, pwm_value);
+}
+
 // Precompute PWM values for faster conversion.
 // Returns false if no PWM range possible, driver should revert to simple on/off spindle control if so.
 bool spindle_precompute_pwm_values (spindle_pwm_t *pwm_data, uint32_t clock_hz)
@@ -171,6 +201,21 @@ bool spindle_precompute_pwm_values (spindle_pwm_t *pwm_data, uint32_t clock_hz)
     }
 #endif
 
+#ifdef SPINDLE_PWM_TABLE_SIZE
+    pwm_data->table_scale = 0.0f;
+
+    if(settings.spindle.rpm_max > settings.spindle.rpm_min) {
+
+        uint_fast16_t idx;
+        float rpm_range = settings.spindle.rpm_max - settings.spindle.rpm_min;
+
+        for(idx = 0; idx <= SPINDLE_PWM_TABLE_SIZE; idx++)
+            pwm_data->table[idx] = rpm_to_pwm(pwm_data, settings.spindle.rpm_min + rpm_range * (float)idx / (float)SPINDLE_PWM_TABLE_SIZE, false);
+
+        pwm_data->table_scale = (float)(SPINDLE_PWM_TABLE_SIZE << SPINDLE_PWM_TABLE_FRAC_BITS) / rpm_range;
+    }
+#endif
+
     return settings.spindle.rpm_max > settings.spindle.rpm_min;
 }
 
@@ -180,29 +225,22 @@ uint_fast16_t spindle_compute_pwm_value (spindle_pwm_t *pwm_data, float rpm, boo
     uint_fast16_t pwm_value;
 
     if(rpm > settings.spindle.rpm_min) {
-      #ifdef ENABLE_SPINDLE_LINEARIZATION
-        // Compute intermediate PWM value with linear spindle speed model via piecewise linear fit model.
-        uint_fast8_t idx = pwm_data->n_pieces;
-
-        if(idx) {
-            do {
-                idx--;
-                if(idx == 0 || rpm > pwm_data->piece[idx].rpm) {
-                    pwm_value = floorf(pwm_data->piece[idx].start * rpm - pwm_data->piece[idx].end);
-                    break;
-                }
-            } while(idx);
+      #ifdef SPINDLE_PWM_TABLE_SIZE
+        // Look up PWM value and interpolate between table entries, PID adjusted RPM is computed as it may exceed max RPM.
+        if(!pid_limit && pwm_data->table_scale > 0.0f) {
+            if(rpm >= settings.spindle.rpm_max)
+                pwm_value = pwm_data->table[SPINDLE_PWM_TABLE_SIZE];
+            else {
+                uint32_t x = (uint32_t)((rpm - settings.spindle.rpm_min) * pwm_data->table_scale), idx = x >> SPINDLE_PWM_TABLE_FRAC_BITS;
+                if(idx >= SPINDLE_PWM_TABLE_SIZE)
+                    pwm_value = pwm_data->table[SPINDLE_PWM_TABLE_SIZE];
+                else
+                    pwm_value = pwm_data->table[idx] + (((int32_t)pwm_data->table[idx + 1] - (int32_t)pwm_data->table[idx]) *
+                                 (int32_t)(x & ((1UL << SPINDLE_PWM_TABLE_FRAC_BITS) - 1)) >> SPINDLE_PWM_TABLE_FRAC_BITS);
+            }
         } else
       #endif
-        // Compute intermediate PWM value with linear spindle speed model.
-        pwm_value = (uint_fast16_t)floorf((rpm - settings.spindle.rpm_min) * pwm_data->pwm_gradient) + pwm_data->min_value;
-
-        if(pwm_value >= (pid_limit ? pwm_data->period : pwm_data->max_value))
-            pwm_value = pid_limit ? pwm_data->period - 1 : pwm_data->max_value;
-        else if(pwm_value < pwm_data->min_value)
-            pwm_value = pwm_data->min_value;
-
-        pwm_value = invert_pwm(pwm_data, pwm_value);
+        pwm_value = rpm_to_pwm(pwm_data, rpm, pid_limit);
     } else
         pwm_value = rpm == 0.0f ? pwm_data->off_value : invert_pwm(pwm_data, pwm_data->min_value);
 
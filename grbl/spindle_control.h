@@ -23,6 +23,13 @@
 #ifndef spindle_control_h
 #define spindle_control_h
 
+#ifdef SPINDLE_PWM_TABLE_SIZE
+  #if SPINDLE_PWM_TABLE_SIZE < 2 || SPINDLE_PWM_TABLE_SIZE > 1024
+    #error "SPINDLE_PWM_TABLE_SIZE must be in the range 2 to 1024"
+  #endif
+  #define SPINDLE_PWM_TABLE_FRAC_BITS 12 // Fraction bits of the table index, for interpolation between entries
+#endif
+
 typedef union {
     uint8_t value;
     uint8_t mask;
@@ -55,6 +62,10 @@ typedef struct {
     bool always_on;
     uint_fast16_t n_pieces;
     pwm_piece_t piece[SPINDLE_NPWM_PIECES];
+#ifdef SPINDLE_PWM_TABLE_SIZE
+    float table_scale; // RPM to fixed point table index scaling, 0 if no table available
+    uint_fast16_t table[SPINDLE_PWM_TABLE_SIZE + 1]; // PWM values from min to max RPM, inverted if software PWM inversion is enabled
+#endif
 } spindle_pwm_t;
 
 // Used when HAL driver supports spindle synchronization
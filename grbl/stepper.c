@@ -27,6 +27,10 @@
 // Some useful constants.
 #define DT_SEGMENT (1.0f/(ACCELERATION_TICKS_PER_SECOND*60.0f)) // min/segment
 #define REQ_MM_INCREMENT_SCALAR 1.25f
+#ifdef ADAPTIVE_STEP_SEGMENTS
+#define DT_SEGMENT_RAMP (DT_SEGMENT * 0.5f) // min/segment, in ramps and spindle synchronized motions
+#define SEGMENT_DEPTH_DECAY 1000 // Number of segments prepared without low water before the queue limit is decreased
+#endif
 
 typedef enum {
     Ramp_Accel,
@@ -80,11 +84,35 @@ static float cycles_per_min;
 static volatile uint_fast8_t segment_buffer_tail;
 static uint_fast8_t segment_buffer_head, segment_next_head;
 
+// Set by st_prep_buffer() when a planner block is being prepped or the planner has blocks queued, read by the
+// stepper ISR since the planner is not to be accessed from interrupt context.
+static volatile bool motion_pending;
+
+#ifdef STEP_SEGMENT_STATISTICS
+static st_stats_t stats; // Step segment buffer statistics, survives stepper reset
+#endif
+#ifdef ADAPTIVE_STEP_SEGMENTS
+static uint_fast8_t segment_depth;      // Current limit of queued segments
+static volatile bool segment_low_water; // Set by the stepper ISR when it takes the last queued segment while motion is pending
+static uint32_t segments_since_low_water;
+#endif
+
 // Pointers for the step segment being prepped from the planner buffer. Accessed only by the
 // main program. Pointers may be planning segments or planner blocks ahead of what being executed.
 static plan_block_t *pl_block;     // Pointer to the planner block being prepped
 static st_block_t *st_prep_block;  // Pointer to the stepper block data being prepped
 
+// Jerk limited (S-curve) speed ramp. Acceleration ramps linearly up to its peak value, is held and
+// then ramps linearly down to zero, the increasing and decreasing phases are of the same duration.
+typedef struct {
+    float v0;       // Start speed (mm/min)
+    float v1;       // End speed (mm/min)
+    float time;     // Ramp duration (min)
+    float t_jerk;   // Duration of each of the variable acceleration phases (min)
+    float jerk;     // Signed jerk, negative for deceleration (mm/min^3)
+    float distance; // Ramp length (mm)
+} scurve_t;
+
 // Segment preparation data struct. Contains all the necessary information to compute new segments
 // based on the current executing planner block.
 typedef struct {
@@ -98,6 +126,7 @@ typedef struct {
     st_block_t *last_st_block;
     uint32_t last_steps_remaining;
     float last_steps_per_mm;
+    float last_req_mm_increment;
     float last_dt_remainder;
 
     ramp_type_t ramp_type;  // Current segment ramp state
@@ -112,6 +141,16 @@ typedef struct {
     float target_feed;      //
     float inv_feedrate;     // Used by PWM laser mode to speed up segment calculations.
     float current_spindle_rpm;
+    bool jerk_limited;      // Acceleration and deceleration ramps of current profile are jerk limited
+    float accel_start;      // Acceleration ramp start measured from end of block (mm)
+    float ramp_time;        // Time elapsed in current jerk limited ramp (min)
+    scurve_t accel_ramp;
+    scurve_t decel_ramp;
+#ifdef ENABLE_NATIVE_ARCS
+    st_block_t arc_block;           // Stepper block data of the arc, template for the stepper blocks of its segments
+    bool arc_first_segment;         // Next arc segment is the first, it executes message and output commands
+    int32_t arc_position[N_AXIS];   // End point of the last arc segment in absolute steps
+#endif
 } st_prep_t;
 
 static st_prep_t prep;
@@ -196,6 +235,16 @@ ISR_CODE void st_go_idle ()
 }
 
 
+// Bresenham line tracer step for a single axis, without branches. Sets the axis bit in the step
+// mask when the axis counter overflows and adds the position change per step, -1, 0 or 1, to the
+// machine position. Unrolled for each axis by the stepper ISR.
+#define STEP_AXIS(idx) { \
+    uint32_t step = (st.counter[idx] += st.steps[idx]) > st.step_event_count; \
+    st.counter[idx] -= st.step_event_count & -step; \
+    step_outbits.mask |= (uint8_t)(step << idx); \
+    sys_position[idx] += st.position_delta[idx] & -(int32_t)step; \
+}
+
 /* "The Stepper Driver Interrupt" - This timer interrupt is the workhorse of Grbl. Grbl employs
    the venerable Bresenham line algorithm to manage and exactly synchronize multi-axis moves.
    Unlike the popular DDA algorithm, the Bresenham algorithm is not susceptible to numerical
@@ -243,10 +292,6 @@ ISR_CODE void st_go_idle ()
 */
 ISR_CODE void stepper_driver_interrupt_handler (void)
 {
-#ifdef ENABLE_BACKLASH_COMPENSATION
-    static bool backlash_motion;
-#endif
-
     // Start a step pulse when there is a block to execute.
     if(st.exec_block)
         hal.stepper_pulse_start(&st);
@@ -259,9 +304,26 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
             // Initialize new step segment and load number of steps to execute
             st.exec_segment = &segment_buffer[segment_buffer_tail];
 
+          #if defined(ADAPTIVE_STEP_SEGMENTS) || defined(STEP_SEGMENT_STATISTICS)
+            // Last queued segment taken, the foreground is about to fall behind if motion is pending.
+            if(segment_buffer_head == (segment_buffer_tail == (SEGMENT_BUFFER_SIZE - 1) ? 0 : segment_buffer_tail + 1) &&
+                motion_pending && !sys.step_control.end_motion) {
+              #ifdef STEP_SEGMENT_STATISTICS
+                stats.low_water++;
+              #endif
+              #ifdef ADAPTIVE_STEP_SEGMENTS
+                segment_low_water = true;
+              #endif
+            }
+          #endif
+
             // Initialize step segment timing per step and load number of steps to execute.
             hal.stepper_cycles_per_tick(st.exec_segment->cycles_per_tick);
             st.step_count = st.exec_segment->n_step; // NOTE: Can sometimes be zero when moving slow.
+#ifdef STEP_RATE_INTERPOLATION
+            // Interpolated interval is advanced before it is used, start one step early.
+            st.cycles_per_tick = (st.exec_segment->cycles_per_tick << STEP_RATE_FRAC_BITS) - (uint32_t)st.exec_segment->cycles_delta;
+#endif
 
             // If the new segment starts a new planner block, initialize stepper variables and counters.
             if (st.exec_block != st.exec_segment->exec_block) {
@@ -270,66 +332,75 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
                 st.step_event_count = st.exec_block->step_event_count;
                 st.dir_outbits = st.exec_block->direction_bits;
                 st.new_block = true;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-                backlash_motion = st.exec_block->backlash_motion;
-#endif
 
                 if(st.exec_block->overrides.sync)
                     sys.override.control = st.exec_block->overrides;
 
                 // Execute output commands to be syncronized with motion
-                while(st.exec_block->output_commands) {
+                if(st.exec_block->output_commands) {
                     output_command_t *cmd = st.exec_block->output_commands;
-                    if(cmd->is_digital)
-                        hal.port.digital_out(cmd->port, cmd->value != 0.0f);
-                    else
-                        hal.port.analog_out(cmd->port, cmd->value);
-                    cmd = cmd->next;
-                    free(st.exec_block->output_commands);
-                    st.exec_block->output_commands = cmd;
+                    do {
+                        if(cmd->is_digital)
+                            hal.port.digital_out(cmd->port, cmd->value != 0.0f);
+                        else
+                            hal.port.analog_out(cmd->port, cmd->value);
+                    } while((cmd = cmd->next));
+                    output_commands_release_isr(st.exec_block->output_commands);
+                    st.exec_block->output_commands = NULL;
                 }
 
-                // "Enqueue" any message to be displayed (by foreground process)
+                // Enqueue any message to be displayed (by foreground process)
                 if(st.exec_block->message) {
-                    protocol_message(st.exec_block->message);
+                    protocol_enqueue_message(st.exec_block->message);
                     st.exec_block->message = NULL;
                 }
 
-                // Initialize Bresenham line and distance counters
-                st.counter_x = st.counter_y = st.counter_z
-                #ifdef A_AXIS
-                  = st.counter_a
-                #endif
-                #ifdef B_AXIS
-                  = st.counter_b
-                #endif
-                #ifdef C_AXIS
-                  = st.counter_c
-                #endif
-                  = st.step_event_count >> 1;
+                // Initialize Bresenham line and distance counters and the position change per step.
+                // NOTE: Backlash compensation motions do not change the machine position.
+                uint_fast8_t idx = N_AXIS;
+                do {
+                    idx--;
+                    st.counter[idx] = st.step_event_count >> 1;
+#ifdef ENABLE_BACKLASH_COMPENSATION
+                    st.position_delta[idx] = st.exec_block->backlash_motion ? 0 : (st.dir_outbits.mask & bit(idx) ? -1 : 1);
+#else
+                    st.position_delta[idx] = st.dir_outbits.mask & bit(idx) ? -1 : 1;
+#endif
+                } while(idx);
 
               #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
                 memcpy(st.steps, st.exec_block->steps, sizeof(st.steps));
               #endif
+
+              #ifdef ENABLE_LASER_RASTER
+                // The pixel counter starts from zero so that pixel boundaries are at multiples of the pixel pitch.
+                st.raster_counter = 0;
+                st.raster_pixel = 0;
+               #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+                st.raster_steps = st.exec_block->raster_steps;
+               #endif
+              #endif
             }
 
           #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
             // With AMASS enabled, adjust Bresenham axis increment counters according to AMASS level.
             st.amass_level = st.exec_segment->amass_level;
-            st.steps[X_AXIS] = st.exec_block->steps[X_AXIS] >> st.amass_level;
-            st.steps[Y_AXIS] = st.exec_block->steps[Y_AXIS] >> st.amass_level;
-            st.steps[Z_AXIS] = st.exec_block->steps[Z_AXIS] >> st.amass_level;
-           #ifdef A_AXIS
-            st.steps[A_AXIS] = st.exec_block->steps[A_AXIS] >> st.amass_level;
-           #endif
-           #ifdef B_AXIS
-            st.steps[B_AXIS] = st.exec_block->steps[B_AXIS] >> st.amass_level;
-           #endif
-           #ifdef C_AXIS
-            st.steps[C_AXIS] = st.exec_block->steps[C_AXIS] >> st.amass_level;
-           #endif
+            uint_fast8_t idx = N_AXIS;
+            do {
+                idx--;
+                st.steps[idx] = st.exec_block->steps[idx] >> st.amass_level;
+            } while(idx);
+          #ifdef ENABLE_LASER_RASTER
+            st.raster_steps = st.exec_block->raster_steps >> st.amass_level;
+          #endif
          #endif
 
+          #ifdef ENABLE_LASER_RASTER
+            // Set the current pixel power at segment start, also restores it on resume from a feed hold.
+            if(st.raster_steps)
+                hal.spindle_update_pwm(st.exec_block->raster_pwm[st.raster_pixel]);
+          #endif
+
             if(st.exec_segment->update_rpm) {
               #ifdef SPINDLE_PWM_DIRECT
                 hal.spindle_update_pwm(st.exec_segment->spindle_pwm);
@@ -339,6 +410,10 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
             }
         } else {
             // Segment buffer empty. Shutdown.
+          #ifdef STEP_SEGMENT_STATISTICS
+            if(motion_pending && !sys.step_control.end_motion)
+                stats.underruns++;
+          #endif
             st_go_idle();
             // Ensure pwm is set properly upon completion of rate-controlled motion.
             if (st.exec_block->dynamic_rpm && settings.flags.laser_mode)
@@ -363,78 +438,54 @@ ISR_CODE void stepper_driver_interrupt_handler (void)
 
     // Execute step displacement profile by Bresenham line algorithm
 
-    st.counter_x += st.steps[X_AXIS];
-    if (st.counter_x > st.step_event_count) {
-        step_outbits.x = On;
-        st.counter_x -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
+    STEP_AXIS(X_AXIS);
+    STEP_AXIS(Y_AXIS);
+    STEP_AXIS(Z_AXIS);
+#if N_AXIS > 3
+    STEP_AXIS(3);
 #endif
-            sys_position[X_AXIS] = sys_position[X_AXIS] + (st.dir_outbits.x ? -1 : 1);
-    }
-
-    st.counter_y += st.steps[Y_AXIS];
-    if (st.counter_y > st.step_event_count) {
-        step_outbits.y = On;
-        st.counter_y -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
+#if N_AXIS > 4
+    STEP_AXIS(4);
 #endif
-            sys_position[Y_AXIS] = sys_position[Y_AXIS] + (st.dir_outbits.y ? -1 : 1);
-    }
-
-    st.counter_z += st.steps[Z_AXIS];
-    if (st.counter_z > st.step_event_count) {
-        step_outbits.z = On;
-        st.counter_z -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
-#endif
-            sys_position[Z_AXIS] = sys_position[Z_AXIS] + (st.dir_outbits.z ? -1 : 1);
-    }
-
-  #ifdef A_AXIS
-      st.counter_a += st.steps[A_AXIS];
-      if (st.counter_a > st.step_event_count) {
-          step_outbits.a = On;
-          st.counter_a -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
+#if N_AXIS > 5
+    STEP_AXIS(5);
 #endif
-              sys_position[A_AXIS] = sys_position[A_AXIS] + (st.dir_outbits.a ? -1 : 1);
-      }
-  #endif
-
-  #ifdef B_AXIS
-      st.counter_b += st.steps[B_AXIS];
-      if (st.counter_b > st.step_event_count) {
-          step_outbits.b = On;
-          st.counter_b -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
+#if N_AXIS > 6
+    STEP_AXIS(6);
 #endif
-              sys_position[B_AXIS] = sys_position[B_AXIS] + (st.dir_outbits.b ? -1 : 1);
-      }
-  #endif
-
-  #ifdef C_AXIS
-      st.counter_c += st.steps[C_AXIS];
-      if (st.counter_c > st.step_event_count) {
-          step_outbits.c = On;
-          st.counter_c -= st.step_event_count;
-#ifdef ENABLE_BACKLASH_COMPENSATION
-        if(!backlash_motion)
+#if N_AXIS > 7
+    STEP_AXIS(7);
 #endif
-              sys_position[C_AXIS] = sys_position[C_AXIS] + (st.dir_outbits.c ? -1 : 1);
-      }
-  #endif
 
     st.step_outbits.value = step_outbits.value;
 
+#ifdef ENABLE_LASER_RASTER
+    // Advance to the next raster pixel at pixel boundaries, tracked as an axis with one step per pixel.
+    // NOTE: The counter starts at zero, the last boundary is thus not crossed before the end of the block.
+    if(st.raster_steps && (st.raster_counter += st.raster_steps) > st.step_event_count) {
+        st.raster_counter -= st.step_event_count;
+        hal.spindle_update_pwm(st.exec_block->raster_pwm[++st.raster_pixel]);
+    }
+#endif
+
     // During a homing cycle, lock out and prevent desired axes from moving.
     if (sys.state == STATE_HOMING)
         st.step_outbits.value &= sys.homing_axis_lock.mask;
 
+#ifdef STEP_RATE_INTERPOLATION
+    // Set the step interval to the next interpolated value when in a ramp.
+    if(st.exec_segment->cycles_delta) {
+        st.cycles_per_tick += (uint32_t)st.exec_segment->cycles_delta;
+        hal.stepper_cycles_per_tick(st.cycles_per_tick >> STEP_RATE_FRAC_BITS);
+    }
+#endif
+
+#ifdef LASER_POWER_INTERPOLATION
+    // Set the laser power for the step rate of the next tick when in a ramp of a rate adjusted laser motion.
+    if(st.exec_segment->pwm_gain)
+        hal.spindle_update_pwm((uint_fast16_t)(st.exec_segment->pwm_base + st.exec_segment->pwm_gain / (int32_t)(st.cycles_per_tick >> STEP_RATE_FRAC_BITS)));
+#endif
+
     if (st.step_count == 0 || --st.step_count == 0) {
         // Segment is complete. Discard current segment and advance segment indexing.
         st.exec_segment = NULL;
@@ -473,6 +524,23 @@ void st_reset ()
     segment_buffer_tail = segment_buffer_head = 0; // empty = tail
     segment_next_head = 1;
 
+    motion_pending = false;
+
+#ifdef ADAPTIVE_STEP_SEGMENTS
+    segment_depth = ADAPTIVE_SEGMENT_MIN_DEPTH;
+    segment_low_water = false;
+    segments_since_low_water = 0;
+#endif
+#ifdef STEP_SEGMENT_STATISTICS
+  #ifdef ADAPTIVE_STEP_SEGMENTS
+    stats.depth = segment_depth;
+  #else
+    stats.depth = SEGMENT_BUFFER_SIZE - 1;
+  #endif
+    if(stats.depth > stats.max_depth)
+        stats.max_depth = stats.depth;
+#endif
+
 #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
     // TODO: move to driver?
     // AMASS_LEVEL0: Normal operation. No AMASS. No upper cutoff frequency. Starts at LEVEL1 cutoff frequency.
@@ -497,7 +565,7 @@ void st_update_plan_block_parameters ()
 {
     if (pl_block != NULL) { // Ignore if at start of a new block.
         prep.recalculate.velocity_profile = On;
-        pl_block->entry_speed_sqr = prep.current_speed * prep.current_speed; // Update entry speed.
+        pl_block->profile->entry_speed_sqr = prep.current_speed * prep.current_speed; // Update entry speed.
         pl_block = NULL; // Flag st_prep_segment() to load and check active velocity profile.
     }
 }
@@ -511,6 +579,7 @@ void st_parking_setup_buffer()
         prep.last_steps_remaining = prep.steps_remaining;
         prep.last_dt_remainder = prep.dt_remainder;
         prep.last_steps_per_mm = prep.steps_per_mm;
+        prep.last_req_mm_increment = prep.req_mm_increment;
     }
     // Set flags to execute a parking motion
     prep.recalculate.parking = On;
@@ -530,13 +599,307 @@ void st_parking_restore_buffer()
         prep.steps_per_mm = prep.last_steps_per_mm;
         prep.recalculate.flags = 0;
         prep.recalculate.hold_partial_block = prep.recalculate.velocity_profile = On;
-        prep.req_mm_increment = REQ_MM_INCREMENT_SCALAR / prep.steps_per_mm; // Recompute this value.
+        prep.req_mm_increment = prep.last_req_mm_increment; // Not recomputed, it is increased for arc blocks.
     } else
         prep.recalculate.flags = 0;
 
     pl_block = NULL; // Set to reload next block.
 }
 
+// Returns the duration of the shortest jerk limited ramp for the given speed change.
+static float scurve_min_time (float delta_speed, float acceleration, float jerk)
+{
+    return delta_speed > acceleration * acceleration / jerk
+            ? delta_speed / acceleration + acceleration / jerk  // Peak acceleration is reached
+            : 2.0f * sqrtf(delta_speed / jerk);                 // Acceleration ramps up and down only
+}
+
+// Returns the length of the shortest jerk limited ramp between two speeds.
+static float scurve_distance (float v0, float v1, float acceleration, float jerk)
+{
+    return 0.5f * (v0 + v1) * scurve_min_time(fabsf(v1 - v0), acceleration, jerk);
+}
+
+static void scurve_init (scurve_t *ramp, float v0, float v1, float acceleration, float jerk)
+{
+    float delta_speed = fabsf(v1 - v0);
+
+    ramp->v0 = v0;
+    ramp->v1 = v1;
+    ramp->jerk = v1 < v0 ? -jerk : jerk;
+    ramp->time = scurve_min_time(delta_speed, acceleration, jerk);
+    ramp->t_jerk = delta_speed > acceleration * acceleration / jerk ? acceleration / jerk : 0.5f * ramp->time;
+    ramp->distance = 0.5f * (v0 + v1) * ramp->time;
+}
+
+// Returns distance travelled from the start of the ramp at the given time and sets the speed at that time.
+static float scurve_position (scurve_t *ramp, float time, float *speed)
+{
+    float t;
+
+    if (time < ramp->t_jerk) { // Increasing acceleration phase
+        *speed = ramp->v0 + 0.5f * ramp->jerk * time * time;
+        return time * (ramp->v0 + ramp->jerk * time * time / 6.0f);
+    }
+
+    if (time > ramp->time - ramp->t_jerk) { // Decreasing acceleration phase, computed backwards from end of ramp
+        t = ramp->time - time;
+        *speed = ramp->v1 - 0.5f * ramp->jerk * t * t;
+        return ramp->distance - t * (ramp->v1 - ramp->jerk * t * t / 6.0f);
+    }
+
+    // Constant acceleration phase
+    float speed_jerk = ramp->v0 + 0.5f * ramp->jerk * ramp->t_jerk * ramp->t_jerk, acceleration = ramp->jerk * ramp->t_jerk;
+
+    t = time - ramp->t_jerk;
+    *speed = speed_jerk + acceleration * t;
+
+    return ramp->t_jerk * (ramp->v0 + ramp->jerk * ramp->t_jerk * ramp->t_jerk / 6.0f) + t * (speed_jerk + 0.5f * acceleration * t);
+}
+
+// Computes a jerk limited velocity profile for the remainder of the prepped planner block.
+// Returns false if the block is too short for a jerk limited ramp between the entry and exit speeds,
+// the planned constant acceleration profile has to be used then.
+static bool scurve_profile (float entry_speed, float nominal_speed, bool keep_accel_ramp)
+{
+    float acceleration = pl_block->max_acceleration, jerk = pl_block->jerk, max_speed;
+
+    if (keep_accel_ramp) {
+        // Replanned while accelerating, keep the ramp in progress to avoid a step change in acceleration.
+        max_speed = prep.accel_ramp.v1;
+        prep.accelerate_until = prep.accel_start - prep.accel_ramp.distance;
+        if (max_speed > nominal_speed || prep.accelerate_until < scurve_distance(max_speed, prep.exit_speed, acceleration, jerk))
+            return false;
+    } else {
+
+        float low = max(entry_speed, prep.exit_speed);
+
+        if (low > nominal_speed || scurve_distance(entry_speed, prep.exit_speed, acceleration, jerk) > pl_block->profile->millimeters)
+            return false;
+
+        // Find the highest speed that can be reached within the block, bisection is used since the
+        // ramp length is a piecewise function of the speed change.
+        if (scurve_distance(entry_speed, nominal_speed, acceleration, jerk) + scurve_distance(nominal_speed, prep.exit_speed, acceleration, jerk) <= pl_block->profile->millimeters)
+            max_speed = nominal_speed;
+        else {
+            uint_fast8_t idx = 12;
+            float high = nominal_speed;
+            do {
+                max_speed = 0.5f * (low + high);
+                if (scurve_distance(entry_speed, max_speed, acceleration, jerk) + scurve_distance(max_speed, prep.exit_speed, acceleration, jerk) > pl_block->profile->millimeters)
+                    high = max_speed;
+                else
+                    low = max_speed;
+            } while(--idx);
+            max_speed = low;
+        }
+
+        scurve_init(&prep.accel_ramp, entry_speed, max_speed, acceleration, jerk);
+        prep.accel_start = pl_block->profile->millimeters;
+        prep.accelerate_until = pl_block->profile->millimeters - prep.accel_ramp.distance;
+        prep.ramp_time = 0.0f;
+        prep.ramp_type = prep.accel_ramp.time > 0.0f ? Ramp_Accel : Ramp_Cruise;
+    }
+
+    scurve_init(&prep.decel_ramp, max_speed, prep.exit_speed, acceleration, jerk);
+    prep.maximum_speed = max_speed;
+    prep.decelerate_after = prep.decel_ramp.distance;
+    if (prep.accelerate_until < prep.decelerate_after) // Round-off
+        prep.accelerate_until = prep.decelerate_after;
+    if (prep.ramp_type == Ramp_Cruise && prep.accelerate_until == prep.decelerate_after)
+        prep.ramp_type = Ramp_Decel;
+
+    return true;
+}
+
+#ifdef ENABLE_NATIVE_ARCS
+
+// Computes the point on the arc at mm_remaining from its end in absolute steps.
+static void st_arc_position (plan_arc_t *arc, float mm_remaining, int32_t *position)
+{
+    if(mm_remaining <= 0.0f)
+        memcpy(position, arc->target_steps, sizeof(arc->target_steps));
+    else {
+        uint_fast8_t idx = N_AXIS;
+        float fraction = 1.0f - mm_remaining / arc->millimeters;
+        float angle = arc->angular_travel * fraction, cos_a = cosf(angle), sin_a = sinf(angle);
+
+        do {
+            idx--;
+            if(idx == arc->plane.axis_0)
+                position[idx] = lroundf((arc->center[0] + arc->r0[0] * cos_a - arc->r0[1] * sin_a) * settings.steps_per_mm[idx]);
+            else if(idx == arc->plane.axis_1)
+                position[idx] = lroundf((arc->center[1] + arc->r0[0] * sin_a + arc->r0[1] * cos_a) * settings.steps_per_mm[idx]);
+            else
+                position[idx] = arc->start_steps[idx] + lroundf((float)(arc->target_steps[idx] - arc->start_steps[idx]) * fraction);
+        } while(idx);
+    }
+}
+
+// Prepares the Bresenham data of an arc segment, executed as a chord from the end point of the previous
+// segment to the point on the arc at mm_remaining. The data is prepared in the next stepper block, which
+// is not committed until the segment is. Returns the number of steps of the segment.
+static uint_fast16_t st_arc_chord (float mm_remaining)
+{
+    uint_fast8_t idx = N_AXIS;
+    int32_t position[N_AXIS], delta_steps;
+    st_block_t *chord = st_prep_block->next;
+
+    st_arc_position(pl_block->arc, mm_remaining, position);
+
+    chord->step_event_count = 0;
+    chord->direction_bits.mask = 0;
+
+    do {
+        idx--;
+        delta_steps = position[idx] - prep.arc_position[idx];
+        chord->steps[idx] = labs(delta_steps);
+        chord->step_event_count = max(chord->step_event_count, chord->steps[idx]);
+        if(delta_steps < 0)
+            chord->direction_bits.mask |= bit(idx);
+    } while(idx);
+
+    return (uint_fast16_t)chord->step_event_count;
+}
+
+// Commits the stepper block prepared by st_arc_chord() for the segment and updates the arc position.
+// NOTE: Stepper blocks of segments in the segment buffer are not overwritten since each segment uses at
+//       most one stepper block and the arc stepper block is not in the ring buffer.
+static void st_arc_commit (segment_t *prep_segment)
+{
+    uint_fast8_t idx = N_AXIS;
+    st_block_t *chord = st_prep_block->next;
+
+    do {
+        idx--;
+        prep.arc_position[idx] += chord->direction_bits.mask & bit(idx) ? -(int32_t)chord->steps[idx] : (int32_t)chord->steps[idx];
+      #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+        chord->steps[idx] <<= 1;
+      #else
+        chord->steps[idx] <<= MAX_AMASS_LEVEL;
+      #endif
+    } while(idx);
+
+  #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+    chord->step_event_count <<= 1;
+  #else
+    chord->step_event_count <<= MAX_AMASS_LEVEL;
+  #endif
+
+    // Copy remaining data from the previous stepper block of the arc.
+    chord->overrides = st_prep_block->overrides;
+    chord->steps_per_mm = st_prep_block->steps_per_mm;
+    chord->millimeters = st_prep_block->millimeters;
+    chord->programmed_rate = st_prep_block->programmed_rate;
+    chord->dynamic_rpm = st_prep_block->dynamic_rpm;
+    chord->backlash_motion = st_prep_block->backlash_motion;
+  #ifdef ENABLE_LASER_RASTER
+    chord->raster_pixels = 0;
+    chord->raster_steps = 0;
+  #endif
+
+    if(prep.arc_first_segment) {
+        // Pass message and output commands on from the arc stepper block.
+        prep.arc_first_segment = false;
+        chord->message = st_prep_block->message;
+        chord->output_commands = st_prep_block->output_commands;
+        st_prep_block->message = NULL;
+        st_prep_block->output_commands = NULL;
+    } else {
+        chord->message = NULL;
+        chord->output_commands = NULL;
+    }
+
+    st_prep_block = prep_segment->exec_block = chord;
+}
+
+#endif
+
+#ifdef STEP_RATE_INTERPOLATION
+
+// Sets up linear interpolation of the step interval over the ticks of a segment. The first and last
+// intervals are in the ratio of the end and start speeds of the segment, limited to 3:1, and are
+// centered on the average interval so that the segment execution time is kept.
+static void st_rate_ramp (segment_t *segment, uint32_t cycles, float speed_start)
+{
+    segment->cycles_delta = 0;
+
+    if(segment->n_step < 2 || segment->spindle_sync || cycles >= (1UL << (31 - STEP_RATE_FRAC_BITS)) / 3 ||
+        speed_start == prep.current_speed)
+        return;
+
+    float ramp = (prep.current_speed - speed_start) / (prep.current_speed + speed_start);
+
+    if(ramp > 0.5f)
+        ramp = 0.5f;
+    else if(ramp < -0.5f)
+        ramp = -0.5f;
+
+    segment->cycles_delta = (int32_t)lroundf(-2.0f * ramp * (float)(cycles << STEP_RATE_FRAC_BITS) / (float)(segment->n_step - 1));
+    segment->cycles_per_tick = (uint32_t)lroundf((float)cycles - (float)segment->cycles_delta * (float)(segment->n_step - 1) * (0.5f / (float)(1UL << STEP_RATE_FRAC_BITS)));
+}
+
+#endif
+
+#ifdef LASER_POWER_INTERPOLATION
+
+// Sets up rate adjusted laser power for the ticks of a segment with an interpolated step interval. Power is
+// fitted as pwm_base + pwm_gain / interval through the power for the step rates of the first and the last
+// tick, exact for a PWM output proportional to RPM. rpm is the power for the average step rate of the
+// segment, 0 if the segment power is not rate adjusted.
+static void st_power_ramp (segment_t *segment, uint32_t cycles, float rpm)
+{
+    segment->pwm_gain = 0;
+
+    if(segment->cycles_delta == 0 || rpm <= 0.0f)
+        return;
+
+    float first = (float)segment->cycles_per_tick;
+    float last = first + (float)segment->cycles_delta * (float)(segment->n_step - 1) * (1.0f / (float)(1UL << STEP_RATE_FRAC_BITS));
+    float pwm_first = (float)hal.spindle_get_pwm(spindle_set_rpm(rpm * (float)cycles / first, sys.override.spindle_rpm));
+    float pwm_last = (float)hal.spindle_get_pwm(spindle_set_rpm(rpm * (float)cycles / last, sys.override.spindle_rpm));
+    float gain = (pwm_first - pwm_last) * first * last / (last - first);
+
+    if(fabsf(gain) < (float)INT32_MAX) {
+        segment->pwm_gain = (int32_t)lroundf(gain);
+        segment->pwm_base = (int32_t)lroundf(pwm_first - gain / first);
+        segment->spindle_pwm = (uint_fast16_t)pwm_first;
+        segment->update_rpm = true;
+        prep.current_spindle_rpm = -1.0f; // Power at the end of the ramp differs from the segment power, force update of the next segment.
+    }
+}
+
+#endif
+
+#ifdef ADAPTIVE_STEP_SEGMENTS
+
+// Returns the number of segments queued for the stepper ISR, including the one being executed.
+static inline uint_fast8_t segments_queued (void)
+{
+    uint_fast8_t tail = segment_buffer_tail;
+
+    return BUFCOUNT(segment_buffer_head, tail, SEGMENT_BUFFER_SIZE);
+}
+
+// Returns the execution time for a new segment, see ADAPTIVE_STEP_SEGMENTS in config.h.
+static float segment_time (void)
+{
+    if(prep.ramp_type != Ramp_Cruise || pl_block->condition.spindle.synchronized || pl_block->condition.is_rpm_pos_adjusted)
+        return DT_SEGMENT_RAMP;
+
+  #ifdef ENABLE_NATIVE_ARCS
+    if(pl_block->arc)
+        return DT_SEGMENT;
+  #endif
+
+    // Cruise step rate (steps/s) of the axis with the most steps.
+    uint_fast16_t n_segments = (uint_fast16_t)(prep.maximum_speed * prep.steps_per_mm * (1.0f / (60.0f * ADAPTIVE_SEGMENT_STEP_RATE)));
+
+    return DT_SEGMENT * (float)(n_segments < 1 ? 1 : (n_segments > ADAPTIVE_SEGMENT_CRUISE_MAX ? ADAPTIVE_SEGMENT_CRUISE_MAX : n_segments));
+}
+
+#endif
+
 /* Prepares step segment buffer. Continuously called from main program.
 
    The segment buffer is an intermediary buffer interface between the execution of steps
@@ -556,20 +919,43 @@ void st_prep_buffer()
     if (sys.step_control.end_motion)
         return;
 
+#ifdef ADAPTIVE_STEP_SEGMENTS
+    // Queue more segments when the foreground has been too busy to keep up, fewer when it keeps up.
+    if(segment_low_water) {
+        segment_low_water = false;
+        segments_since_low_water = 0;
+        if(segment_depth < SEGMENT_BUFFER_SIZE - 1)
+            segment_depth++;
+    } else if(segments_since_low_water >= SEGMENT_DEPTH_DECAY) {
+        segments_since_low_water = 0;
+        if(segment_depth > ADAPTIVE_SEGMENT_MIN_DEPTH)
+            segment_depth--;
+    }
+  #ifdef STEP_SEGMENT_STATISTICS
+    if((stats.depth = segment_depth) > stats.max_depth)
+        stats.max_depth = stats.depth;
+  #endif
+
+    while (segment_buffer_tail != segment_next_head && segments_queued() < segment_depth) { // Check if we need to fill the buffer.
+#else
     while (segment_buffer_tail != segment_next_head) { // Check if we need to fill the buffer.
+#endif
 
         // Determine if we need to load a new planner block or if the block needs to be recomputed.
         if (pl_block == NULL) {
 
+            bool keep_accel_ramp = false;
+
             // Query planner for a queued block
 
             pl_block = sys.step_control.execute_sys_motion ? plan_get_system_motion_block() : plan_get_current_block();
 
-            if (pl_block == NULL)
+            if (!(motion_pending = pl_block != NULL))
                 return; // No planner blocks. Exit.
 
             // Check if we need to only recompute the velocity profile or load a new block.
             if (prep.recalculate.velocity_profile) {
+                keep_accel_ramp = prep.jerk_limited && prep.ramp_type == Ramp_Accel;
                 if(settings.parking.flags.enabled) {
                     if (prep.recalculate.parking)
                         prep.recalculate.velocity_profile = Off;
@@ -583,6 +969,14 @@ void st_prep_buffer()
                 // when the segment buffer completes the planner block, it may be discarded when the
                 // segment buffer finishes the prepped block, but the stepper ISR is still executing it.
 
+              #ifdef ENABLE_NATIVE_ARCS
+                // The stepper block of an arc is not executed, it is kept out of the ring buffer and used
+                // as a template for the stepper blocks of the segments.
+                if(pl_block->arc) {
+                    prep.arc_block.next = st_prep_block->next;
+                    st_prep_block = &prep.arc_block;
+                } else
+              #endif
                 st_prep_block = st_prep_block->next;
 
                 uint_fast8_t idx = N_AXIS;
@@ -605,10 +999,12 @@ void st_prep_buffer()
 
                 st_prep_block->direction_bits = pl_block->direction_bits;
                 st_prep_block->programmed_rate = pl_block->programmed_rate;
-                st_prep_block->millimeters = pl_block->millimeters;
-                st_prep_block->steps_per_mm = (float)pl_block->step_event_count / pl_block->millimeters;
+                st_prep_block->millimeters = pl_block->profile->millimeters;
+                st_prep_block->steps_per_mm = (float)pl_block->step_event_count / pl_block->profile->millimeters;
                 st_prep_block->message = pl_block->message;
                 st_prep_block->output_commands = pl_block->output_commands;
+                pl_block->message = NULL;           // Ownership is passed to the stepper block,
+                pl_block->output_commands = NULL;   // released when the block is executed
                 st_prep_block->overrides = pl_block->overrides;
                 st_prep_block->backlash_motion = pl_block->condition.backlash_motion;
 
@@ -621,10 +1017,10 @@ void st_prep_buffer()
                 if (sys.step_control.execute_hold || prep.recalculate.decel_override) {
                     // New block loaded mid-hold. Override planner block entry speed to enforce deceleration.
                     prep.current_speed = prep.exit_speed;
-                    pl_block->entry_speed_sqr = prep.exit_speed * prep.exit_speed;
+                    pl_block->profile->entry_speed_sqr = prep.exit_speed * prep.exit_speed;
                     prep.recalculate.decel_override = Off;
                 } else
-                    prep.current_speed = sqrtf(pl_block->entry_speed_sqr);
+                    prep.current_speed = sqrtf(pl_block->profile->entry_speed_sqr);
 
                 // Setup laser mode variables. RPM rate adjusted motions will always complete a motion with the
                 // spindle off.
@@ -633,6 +1029,45 @@ void st_prep_buffer()
                     prep.inv_feedrate = pl_block->condition.is_laser_ppi_mode ? 1.0f : 1.0f / pl_block->programmed_rate;
                 else
                     st_prep_block->dynamic_rpm = pl_block->condition.is_rpm_pos_adjusted;
+
+              #ifdef ENABLE_LASER_RASTER
+                // Raster scanline power is set per pixel by the stepper ISR from precomputed PWM values,
+                // segments do not update it. Spindle override changes apply from the next block.
+                if((st_prep_block->raster_pixels = pl_block->raster ? pl_block->raster->pixels : 0)) {
+                    float rpm = pl_block->condition.spindle.on ? spindle_set_rpm(pl_block->spindle.rpm, sys.override.spindle_rpm) / 255.0f : 0.0f;
+                    uint_fast16_t pixel = st_prep_block->raster_pixels;
+                    do {
+                        pixel--;
+                        st_prep_block->raster_pwm[pixel] = hal.spindle_get_pwm(rpm * (float)pl_block->raster->power[pixel]);
+                    } while(pixel);
+                  #ifndef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+                    st_prep_block->raster_steps = st_prep_block->raster_pixels << 1;
+                  #else
+                    st_prep_block->raster_steps = st_prep_block->raster_pixels << MAX_AMASS_LEVEL;
+                  #endif
+                    st_prep_block->dynamic_rpm = On;        // Laser off at end of motion,
+                    prep.current_spindle_rpm = -1.0f;       // and power set by the first segment of the next block.
+                } else
+                    st_prep_block->raster_steps = 0;
+              #endif
+
+              #ifdef ENABLE_NATIVE_ARCS
+                if(pl_block->arc) {
+                    // Arc segments are executed as chords, each with its own stepper block. Segment length is
+                    // increased so that at least one step is executed by a segment on an axis with the lowest
+                    // resolution, for any chord direction.
+                    float steps_per_mm = SOME_LARGE_VALUE;
+                    idx = N_AXIS;
+                    do {
+                        idx--;
+                        if(pl_block->steps[idx])
+                            steps_per_mm = min(steps_per_mm, settings.steps_per_mm[idx]);
+                    } while(idx);
+                    prep.req_mm_increment = 2.0f * REQ_MM_INCREMENT_SCALAR / steps_per_mm;
+                    prep.arc_first_segment = true;
+                    memcpy(prep.arc_position, pl_block->arc->start_steps, sizeof(prep.arc_position));
+                }
+              #endif
             }
 
             /* ---------------------------------------------------------------------------------
@@ -642,17 +1077,18 @@ void st_prep_buffer()
              hold, override the planner velocities and decelerate to the target exit speed.
             */
             prep.mm_complete = 0.0f; // Default velocity profile complete at 0.0mm from end of block.
-            float inv_2_accel = 0.5f / pl_block->acceleration;
+            prep.jerk_limited = false;
+            float inv_2_accel = 0.5f / pl_block->profile->acceleration;
 
             if (sys.step_control.execute_hold) { // [Forced Deceleration to Zero Velocity]
                 // Compute velocity profile parameters for a feed hold in-progress. This profile overrides
                 // the planner block profile, enforcing a deceleration to zero speed.
                 prep.ramp_type = Ramp_Decel;
                 // Compute decelerate distance relative to end of block.
-                float decel_dist = pl_block->millimeters - inv_2_accel * pl_block->entry_speed_sqr;
+                float decel_dist = pl_block->profile->millimeters - inv_2_accel * pl_block->profile->entry_speed_sqr;
                 if (decel_dist < 0.0f) {
                     // Deceleration through entire planner block. End of feed hold is not in this block.
-                    prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2.0f * pl_block->acceleration * pl_block->millimeters);
+                    prep.exit_speed = sqrtf(pl_block->profile->entry_speed_sqr - 2.0f * pl_block->profile->acceleration * pl_block->profile->millimeters);
                 } else {
                     prep.mm_complete = decel_dist; // End of feed hold.
                     prep.exit_speed = 0.0f;
@@ -660,7 +1096,7 @@ void st_prep_buffer()
             } else { // [Normal Operation]
                 // Compute or recompute velocity profile parameters of the prepped planner block.
                 prep.ramp_type = Ramp_Accel; // Initialize as acceleration ramp.
-                prep.accelerate_until = pl_block->millimeters;
+                prep.accelerate_until = pl_block->profile->millimeters;
 
                 float exit_speed_sqr;
                 if (sys.step_control.execute_sys_motion)
@@ -672,21 +1108,24 @@ void st_prep_buffer()
 
                 float nominal_speed = plan_compute_profile_nominal_speed(pl_block);
                 float nominal_speed_sqr = nominal_speed * nominal_speed;
-                float intersect_distance = 0.5f * (pl_block->millimeters + inv_2_accel * (pl_block->entry_speed_sqr - exit_speed_sqr));
+                float intersect_distance = 0.5f * (pl_block->profile->millimeters + inv_2_accel * (pl_block->profile->entry_speed_sqr - exit_speed_sqr));
 
                 prep.target_feed = nominal_speed;
 
-                if (pl_block->entry_speed_sqr > nominal_speed_sqr) { // Only occurs during override reductions.
+                if (pl_block->jerk > 0.0f && pl_block->profile->entry_speed_sqr <= nominal_speed_sqr &&
+                     scurve_profile(sqrtf(pl_block->profile->entry_speed_sqr), nominal_speed, keep_accel_ramp))
+                    prep.jerk_limited = On; // Jerk limited profile, ramps are executed at the peak acceleration.
+                else if (pl_block->profile->entry_speed_sqr > nominal_speed_sqr) { // Only occurs during override reductions.
 
-                    prep.accelerate_until = pl_block->millimeters - inv_2_accel * (pl_block->entry_speed_sqr - nominal_speed_sqr);
+                    prep.accelerate_until = pl_block->profile->millimeters - inv_2_accel * (pl_block->profile->entry_speed_sqr - nominal_speed_sqr);
 
                     if (prep.accelerate_until <= 0.0f) { // Deceleration-only.
                         prep.ramp_type = Ramp_Decel;
-                        // prep.decelerate_after = pl_block->millimeters;
+                        // prep.decelerate_after = pl_block->profile->millimeters;
                         // prep.maximum_speed = prep.current_speed;
 
                         // Compute override block exit speed since it doesn't match the planner exit speed.
-                        prep.exit_speed = sqrtf(pl_block->entry_speed_sqr - 2.0f * pl_block->acceleration * pl_block->millimeters);
+                        prep.exit_speed = sqrtf(pl_block->profile->entry_speed_sqr - 2.0f * pl_block->profile->acceleration * pl_block->profile->millimeters);
                         prep.recalculate.decel_override = On; // Flag to load next block as deceleration override.
 
                         // TODO: Determine correct handling of parameters in deceleration-only.
@@ -700,25 +1139,25 @@ void st_prep_buffer()
                         prep.ramp_type = Ramp_DecelOverride;
                     }
                 } else if (intersect_distance > 0.0f) {
-                    if (intersect_distance < pl_block->millimeters) { // Either trapezoid or triangle types
+                    if (intersect_distance < pl_block->profile->millimeters) { // Either trapezoid or triangle types
                         // NOTE: For acceleration-cruise and cruise-only types, following calculation will be 0.0.
                         prep.decelerate_after = inv_2_accel * (nominal_speed_sqr - exit_speed_sqr);
                         if (prep.decelerate_after < intersect_distance) { // Trapezoid type
                             prep.maximum_speed = nominal_speed;
-                            if (pl_block->entry_speed_sqr == nominal_speed_sqr) {
+                            if (pl_block->profile->entry_speed_sqr == nominal_speed_sqr) {
                                 // Cruise-deceleration or cruise-only type.
                                 prep.ramp_type = Ramp_Cruise;
                             } else {
                                 // Full-trapezoid or acceleration-cruise types
-                                prep.accelerate_until -= inv_2_accel * (nominal_speed_sqr - pl_block->entry_speed_sqr);
+                                prep.accelerate_until -= inv_2_accel * (nominal_speed_sqr - pl_block->profile->entry_speed_sqr);
                             }
                         } else { // Triangle type
                             prep.accelerate_until = prep.decelerate_after = intersect_distance;
-                            prep.maximum_speed = sqrtf(2.0f * pl_block->acceleration * intersect_distance + exit_speed_sqr);
+                            prep.maximum_speed = sqrtf(2.0f * pl_block->profile->acceleration * intersect_distance + exit_speed_sqr);
                         }
                     } else { // Deceleration-only type
                         prep.ramp_type = Ramp_Decel;
-                        // prep.decelerate_after = pl_block->millimeters;
+                        // prep.decelerate_after = pl_block->profile->millimeters;
                         // prep.maximum_speed = prep.current_speed;
                     }
                 } else { // Acceleration-only type
@@ -753,12 +1192,22 @@ void st_prep_buffer()
           the end of planner block (typical) or mid-block at the end of a forced deceleration,
           such as from a feed hold.
         */
+#ifdef ADAPTIVE_STEP_SEGMENTS
+        float dt_max = segment_time(); // Maximum segment time
+#else
         float dt_max = DT_SEGMENT; // Maximum segment time
+#endif
         float dt = 0.0f; // Initialize segment time
         float time_var = dt_max; // Time worker variable
         float mm_var; // mm - Distance worker variable
         float speed_var; // Speed worker variable
-        float mm_remaining = pl_block->millimeters; // New segment distance from end of block.
+        float mm_remaining = pl_block->profile->millimeters; // New segment distance from end of block.
+#ifdef STEP_RATE_INTERPOLATION
+        float speed_start = prep.current_speed; // Speed at the start of the segment (mm/min).
+#endif
+#ifdef LASER_POWER_INTERPOLATION
+        float laser_rpm = 0.0f; // Rate adjusted laser power for the average speed of the segment, before override and limits.
+#endif
         float minimum_mm = mm_remaining - prep.req_mm_increment; // Guarantee at least one step.
 
         if (minimum_mm < 0.0f)
@@ -769,11 +1218,11 @@ void st_prep_buffer()
             switch (prep.ramp_type) {
 
                 case Ramp_DecelOverride:
-                    speed_var = pl_block->acceleration * time_var;
+                    speed_var = pl_block->profile->acceleration * time_var;
                     if ((prep.current_speed - prep.maximum_speed) <= speed_var) {
                         // Cruise or cruise-deceleration types only for deceleration override.
                         mm_remaining = prep.accelerate_until;
-                        time_var = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
+                        time_var = 2.0f * (pl_block->profile->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         prep.ramp_type = Ramp_Cruise;
                         prep.current_speed = prep.maximum_speed;
                     } else {// Mid-deceleration override ramp.
@@ -783,13 +1232,26 @@ void st_prep_buffer()
                     break;
 
                 case Ramp_Accel:
+                    if (prep.jerk_limited) {
+                        if ((prep.ramp_time += time_var) < prep.accel_ramp.time) {
+                            mm_remaining = prep.accel_start - scurve_position(&prep.accel_ramp, prep.ramp_time, &prep.current_speed);
+                            break;
+                        }
+                        // End of acceleration ramp.
+                        time_var -= prep.ramp_time - prep.accel_ramp.time;
+                        prep.ramp_time = 0.0f;
+                        mm_remaining = prep.accelerate_until;
+                        prep.ramp_type = mm_remaining == prep.decelerate_after ? Ramp_Decel : Ramp_Cruise;
+                        prep.current_speed = prep.maximum_speed;
+                        break;
+                    }
                     // NOTE: Acceleration ramp only computes during first do-while loop.
-                    speed_var = pl_block->acceleration * time_var;
+                    speed_var = pl_block->profile->acceleration * time_var;
                     mm_remaining -= time_var * (prep.current_speed + 0.5f * speed_var);
                     if (mm_remaining < prep.accelerate_until) { // End of acceleration ramp.
                         // Acceleration-cruise, acceleration-deceleration ramp junction, or end of block.
                         mm_remaining = prep.accelerate_until; // NOTE: 0.0 at EOB
-                        time_var = 2.0f * (pl_block->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
+                        time_var = 2.0f * (pl_block->profile->millimeters - mm_remaining) / (prep.current_speed + prep.maximum_speed);
                         prep.ramp_type = mm_remaining == prep.decelerate_after ? Ramp_Decel : Ramp_Cruise;
                         prep.current_speed = prep.maximum_speed;
                     } else // Acceleration only.
@@ -811,8 +1273,19 @@ void st_prep_buffer()
                     break;
 
                 default: // case Ramp_Decel:
+                    if (prep.jerk_limited) {
+                        if ((prep.ramp_time += time_var) < prep.decel_ramp.time) {
+                            mm_remaining = prep.decelerate_after - scurve_position(&prep.decel_ramp, prep.ramp_time, &prep.current_speed);
+                            break;
+                        }
+                        // End of block.
+                        time_var -= prep.ramp_time - prep.decel_ramp.time;
+                        mm_remaining = prep.mm_complete;
+                        prep.current_speed = prep.exit_speed;
+                        break;
+                    }
                     // NOTE: mm_var used as a misc worker variable to prevent errors when near zero speed.
-                    speed_var = pl_block->acceleration * time_var; // Used as delta speed (mm/min)
+                    speed_var = pl_block->profile->acceleration * time_var; // Used as delta speed (mm/min)
                     if (prep.current_speed > speed_var) { // Check if at or below zero speed.
                         // Compute distance from end of segment to end of block.
                         mm_var = mm_remaining - time_var * (prep.current_speed - 0.5f * speed_var); // (mm)
@@ -830,6 +1303,12 @@ void st_prep_buffer()
 
             dt += time_var; // Add computed ramp time to total segment time.
 
+#ifdef ADAPTIVE_STEP_SEGMENTS
+            // Do not extend a lengthened cruise segment into a ramp.
+            if (dt_max > DT_SEGMENT_RAMP && prep.ramp_type != Ramp_Cruise)
+                dt_max = max(dt, DT_SEGMENT_RAMP);
+#endif
+
             if (dt < dt_max)
                 time_var = dt_max - dt;// **Incomplete** At ramp junction.
             else {
@@ -848,19 +1327,36 @@ void st_prep_buffer()
            Compute spindle spindle speed for step segment
         */
 
+#ifdef ENABLE_LASER_RASTER
+        if (!st_prep_block->raster_pixels && (sys.step_control.update_spindle_rpm || st_prep_block->dynamic_rpm)) {
+#else
         if (sys.step_control.update_spindle_rpm || st_prep_block->dynamic_rpm) {
+#endif
             float rpm;
             if (pl_block->condition.spindle.on) {
                 // NOTE: Feed and rapid overrides are independent of PWM value and do not alter laser power/rate.
                 // If current_speed is zero, then may need to be rpm_min*(100/MAX_SPINDLE_RPM_OVERRIDE)
                 // but this would be instantaneous only and during a motion. May not matter at all.
+              #ifdef LASER_POWER_RATE_SYNC
+                if(pl_block->condition.is_rpm_rate_adjusted && !pl_block->condition.is_laser_ppi_mode) {
+                    // Use the average speed of the segment, the speed its steps are executed at.
+                    float speed = dt > 0.0f ? (pl_block->profile->millimeters - mm_remaining) / dt : prep.current_speed;
+                  #ifdef LASER_POWER_INTERPOLATION
+                    rpm = spindle_set_rpm((laser_rpm = pl_block->spindle.rpm * speed * prep.inv_feedrate), sys.override.spindle_rpm);
+                  #else
+                    rpm = spindle_set_rpm(pl_block->spindle.rpm * speed * prep.inv_feedrate, sys.override.spindle_rpm);
+                  #endif
+                } else
+                    rpm = spindle_set_rpm(pl_block->spindle.rpm, sys.override.spindle_rpm);
+              #else
                 rpm = spindle_set_rpm(pl_block->condition.is_rpm_rate_adjusted && !pl_block->condition.is_laser_ppi_mode
                                        ? pl_block->spindle.rpm * prep.current_speed * prep.inv_feedrate
                                        : pl_block->spindle.rpm, sys.override.spindle_rpm);
+              #endif
 
                 if(pl_block->condition.is_rpm_pos_adjusted) {
                     float npos = (float)(pl_block->step_event_count - prep.steps_remaining) / (float)pl_block->step_event_count;
-                    rpm += (spindle_set_rpm(pl_block->spindle.css.target_rpm, sys.override.spindle_rpm) - prep.current_spindle_rpm) * npos;
+                    rpm += (spindle_set_rpm(pl_block->spindle.target_rpm, sys.override.spindle_rpm) - prep.current_spindle_rpm) * npos;
                 }
             } else
                 sys.spindle_rpm = rpm = 0.0f;
@@ -890,6 +1386,11 @@ void st_prep_buffer()
         float step_dist_remaining = prep.steps_per_mm * mm_remaining; // Convert mm_remaining to steps
         uint32_t n_steps_remaining = (uint32_t)ceilf(step_dist_remaining); // Round-up current steps remaining
 
+#ifdef ENABLE_NATIVE_ARCS
+        if(pl_block->arc)
+            prep_segment->n_step = st_arc_chord(mm_remaining);
+        else
+#endif
         prep_segment->n_step = (uint_fast16_t)(prep.steps_remaining - n_steps_remaining); // Compute number of steps to execute.
 
         // Bail if we are at the end of a feed hold and don't have a step to execute.
@@ -902,6 +1403,44 @@ void st_prep_buffer()
             return; // Segment not generated, but current step data still retained.
         }
 
+#ifdef ENABLE_NATIVE_ARCS
+        if(pl_block->arc) {
+
+            // Arc segment end points are rounded to the nearest step, there is no partial step time to carry over.
+            // NOTE: A segment without steps, at the end of the arc, is executed as a single tick.
+            st_arc_commit(prep_segment);
+
+            uint32_t cycles = (uint32_t)ceilf(cycles_per_min * dt / (float)(prep_segment->n_step ? prep_segment->n_step : 1));
+
+            prep_segment->spindle_sync = false;
+            prep_segment->amass_level = 0;
+
+          #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
+            if (cycles >= amass.level_1 && prep_segment->n_step) {
+                prep_segment->amass_level = cycles < amass.level_2 ? 1 : (cycles < amass.level_3 ? 2 : 3);
+                cycles >>= prep_segment->amass_level;
+                prep_segment->n_step <<= prep_segment->amass_level;
+            }
+          #endif
+
+            prep_segment->cycles_per_tick = cycles;
+          #ifdef STEP_RATE_INTERPOLATION
+            st_rate_ramp(prep_segment, cycles, speed_start);
+          #endif
+          #ifdef LASER_POWER_INTERPOLATION
+            st_power_ramp(prep_segment, cycles, laser_rpm);
+          #endif
+
+            // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
+            segment_buffer_head = segment_next_head;
+            segment_next_head = segment_next_head == (SEGMENT_BUFFER_SIZE - 1) ? 0 : segment_next_head + 1;
+
+            pl_block->profile->millimeters = mm_remaining;
+            prep.steps_remaining = n_steps_remaining;
+            prep.dt_remainder = 0.0f;
+
+        } else {
+#endif
         // Compute segment step rate. Since steps are integers and mm distances traveled are not,
         // the end of every segment can have a partial step of varying magnitudes that are not
         // executed, because the stepper ISR requires whole steps due to the AMASS algorithm. To
@@ -920,7 +1459,7 @@ void st_prep_buffer()
         if((prep_segment->spindle_sync = pl_block->condition.spindle.synchronized)) {
             prep.target_position += dt * prep.target_feed;
             prep_segment->cruising = prep.ramp_type == Ramp_Cruise;
-            prep_segment->target_position = prep.target_position; //st_prep_block->millimeters - pl_block->millimeters;
+            prep_segment->target_position = prep.target_position; //st_prep_block->millimeters - pl_block->profile->millimeters;
         }
 
       #ifdef ADAPTIVE_MULTI_AXIS_STEP_SMOOTHING
@@ -936,15 +1475,31 @@ void st_prep_buffer()
       #endif
 
         prep_segment->cycles_per_tick = cycles;
+#ifdef STEP_RATE_INTERPOLATION
+        st_rate_ramp(prep_segment, cycles, speed_start);
+#endif
+#ifdef LASER_POWER_INTERPOLATION
+        st_power_ramp(prep_segment, cycles, laser_rpm);
+#endif
 
         // Segment complete! Increment segment buffer indices, so stepper ISR can immediately execute it.
         segment_buffer_head = segment_next_head;
         segment_next_head = segment_next_head == (SEGMENT_BUFFER_SIZE - 1) ? 0 : segment_next_head + 1;
 
         // Update the appropriate planner and segment data.
-        pl_block->millimeters = mm_remaining;
+        pl_block->profile->millimeters = mm_remaining;
         prep.steps_remaining = n_steps_remaining;
         prep.dt_remainder = ((float)n_steps_remaining - step_dist_remaining) * inv_rate;
+#ifdef ENABLE_NATIVE_ARCS
+        }
+#endif
+
+#ifdef STEP_SEGMENT_STATISTICS
+        stats.segments++;
+#endif
+#ifdef ADAPTIVE_STEP_SEGMENTS
+        segments_since_low_water++;
+#endif
 
         // Check for exit conditions and flag to load next planner block.
         if (mm_remaining <= prep.mm_complete) {
@@ -966,6 +1521,7 @@ void st_prep_buffer()
                 }
                 pl_block = NULL; // Set pointer to indicate check and load next planner block.
                 plan_discard_current_block();
+                motion_pending = plan_get_current_block() != NULL;
             }
         }
     }
@@ -980,3 +1536,13 @@ float st_get_realtime_rate()
 {
     return sys.state & (STATE_CYCLE|STATE_HOMING|STATE_HOLD|STATE_JOG|STATE_SAFETY_DOOR) ? prep.current_speed : 0.0f;
 }
+
+#ifdef STEP_SEGMENT_STATISTICS
+
+// Returns step segment buffer statistics.
+st_stats_t *st_get_stats (void)
+{
+    return &stats;
+}
+
+#endif
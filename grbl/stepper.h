@@ -25,10 +25,37 @@
 #ifndef stepper_h
 #define stepper_h
 
+#if N_AXIS > 8
+  #error "The stepper step mask is limited to 8 axes"
+#endif
+
 #ifndef SEGMENT_BUFFER_SIZE
   #define SEGMENT_BUFFER_SIZE 10
 #endif
 
+#ifdef STEP_RATE_INTERPOLATION
+  #define STEP_RATE_FRAC_BITS 8 // Fraction bits of the interpolated step interval
+#endif
+
+#if defined(LASER_POWER_RATE_SYNC) && defined(STEP_RATE_INTERPOLATION) && defined(SPINDLE_PWM_DIRECT)
+  #define LASER_POWER_INTERPOLATION
+#endif
+
+#ifdef ADAPTIVE_STEP_SEGMENTS
+  #ifndef ADAPTIVE_SEGMENT_STEP_RATE
+    #define ADAPTIVE_SEGMENT_STEP_RATE 10000
+  #endif
+  #ifndef ADAPTIVE_SEGMENT_CRUISE_MAX
+    #define ADAPTIVE_SEGMENT_CRUISE_MAX 4
+  #endif
+  #ifndef ADAPTIVE_SEGMENT_MIN_DEPTH
+    #define ADAPTIVE_SEGMENT_MIN_DEPTH (SEGMENT_BUFFER_SIZE / 2)
+  #endif
+  #if ADAPTIVE_SEGMENT_MIN_DEPTH < 2 || ADAPTIVE_SEGMENT_MIN_DEPTH > SEGMENT_BUFFER_SIZE - 1
+    #error "ADAPTIVE_SEGMENT_MIN_DEPTH must be in the range 2 to SEGMENT_BUFFER_SIZE - 1"
+  #endif
+#endif
+
 typedef enum {
     SquaringMode_Both = 0,
     SquaringMode_A,
@@ -53,6 +80,11 @@ typedef struct st_block {
     output_command_t *output_commands; // Output commands (linked list) to be performed when block is executed
     bool dynamic_rpm;                  // Tracks motions that require dynamic RPM adjustment
     bool backlash_motion;
+#ifdef ENABLE_LASER_RASTER
+    uint_fast16_t raster_pixels;       // Number of raster pixels, 0 if not a raster scanline
+    uint32_t raster_steps;             // Raster pixel count scaled as the axis step counts, for the Bresenham pixel counter
+    uint16_t raster_pwm[LASER_RASTER_MAX_PIXELS]; // Laser PWM values of the raster pixels
+#endif
 } st_block_t;
 
 typedef struct {
@@ -61,8 +93,15 @@ typedef struct {
     uint32_t cycles_per_tick;       // Step distance traveled per ISR tick, aka step rate.
     float target_position;          // Target position of segment relative to block start, used by spindle sync code
     uint_fast16_t n_step;           // Number of step events to be executed for this segment
+#ifdef STEP_RATE_INTERPOLATION
+    int32_t cycles_delta;           // Change of step interval per tick in 1/2^STEP_RATE_FRAC_BITS cycles, 0 for constant step rate
+#endif
 #ifdef SPINDLE_PWM_DIRECT
     uint_fast16_t spindle_pwm;      // Spindle PWM to be set at the start of segment execution
+#ifdef LASER_POWER_INTERPOLATION
+    int32_t pwm_base;               // Laser PWM per tick is pwm_base + pwm_gain / step interval in cycles,
+    int32_t pwm_gain;               // proportional to the step rate. pwm_gain is 0 for constant power.
+#endif
 #else
     float spindle_rpm;              // Spindle RPM to be set at the start of the segment execution
 #endif
@@ -75,24 +114,21 @@ typedef struct {
 // Stepper ISR data struct. Contains the running data for the main stepper ISR.
 typedef struct {
     // Used by the bresenham line algorithm
-    uint32_t counter_x,        // Counter variables for the bresenham line tracer
-             counter_y,
-             counter_z
-    #ifdef A_AXIS
-           , counter_a
-    #endif
-    #ifdef B_AXIS
-          , counter_b
-    #endif
-    #ifdef C_AXIS
-          , counter_c
-    #endif
-;
+    uint32_t counter[N_AXIS];       // Counter variables for the bresenham line tracer
+    int32_t position_delta[N_AXIS]; // Machine position change per step, -1, 1 or 0 for backlash compensation motions
     bool new_block;                 // Set to true when a new block is started, might be used by driver for advanced functionality
     axes_signals_t step_outbits;    // The next stepping-bits to be output
     axes_signals_t dir_outbits;     // The next direction-bits to be output
     uint32_t steps[N_AXIS];
     uint_fast8_t amass_level;       // AMASS level for this segment
+#ifdef ENABLE_LASER_RASTER
+    uint32_t raster_steps;          // Bresenham increment of the raster pixel counter, 0 if not a raster scanline
+    uint32_t raster_counter;        // Bresenham counter for raster pixel boundaries
+    uint_fast16_t raster_pixel;     // Current raster pixel
+#endif
+#ifdef STEP_RATE_INTERPOLATION
+    uint32_t cycles_per_tick;       // Current step interval in 1/2^STEP_RATE_FRAC_BITS cycles
+#endif
 //    uint_fast16_t spindle_pwm;
     uint_fast16_t step_count;       // Steps remaining in line segment motion
     uint32_t step_event_count;
@@ -100,6 +136,19 @@ typedef struct {
     segment_t *exec_segment;        // Pointer to the segment being executed
 } stepper_t;
 
+#ifdef STEP_SEGMENT_STATISTICS
+
+// Step segment buffer statistics
+typedef struct {
+    uint32_t segments;          // Number of segments prepared
+    uint32_t underruns;         // Number of times the segment buffer ran dry while motion was pending
+    uint32_t low_water;         // Number of times the stepper took the last queued segment while motion was pending
+    uint_fast8_t depth;         // Current limit of queued segments
+    uint_fast8_t max_depth;     // Largest limit of queued segments used
+} st_stats_t;
+
+#endif
+
 // Initialize and setup the stepper motor subsystem
 void stepper_init();
 
@@ -130,6 +179,11 @@ void st_update_plan_block_parameters();
 // Called by realtime status reporting if realtime rate reporting is enabled in config.h.
 float st_get_realtime_rate();
 
+#ifdef STEP_SEGMENT_STATISTICS
+// Returns step segment buffer statistics.
+st_stats_t *st_get_stats (void);
+#endif
+
 void stepper_driver_interrupt_handler (void);
 
 #endif
@@ -84,6 +84,12 @@ status_code_t system_execute_line (char *line)
     status_code_t retval = Status_OK;
     char c, *org = line, *ucline = line, *lcline = line + (LINE_BUFFER_SIZE / 2);
 
+#ifdef ENABLE_LASER_RASTER
+    // Laser raster data, executed in any state and decoded in place so that it may use the full line buffer.
+    if(line[1] == 'L' && line[2] == '=')
+        return sys.state & (STATE_ALARM|STATE_ESTOP|STATE_JOG) ? Status_SystemGClock : gc_raster_load(&line[3]);
+#endif
+
     if(strlen(line) >= ((LINE_BUFFER_SIZE / 2) - 1))
         return Status_Overflow;
 
@@ -283,8 +289,13 @@ status_code_t system_execute_line (char *line)
                 retval = Status_InvalidStatement;
             break;
 
-        case 'R': // Restore defaults [IDLE/ALARM]
-            {
+        case 'R': // Restore defaults [IDLE/ALARM] or select realtime report format
+            if(line[2] == 'B') {
+                if(line[3] == '=' && (line[4] == '0' || line[4] == '1') && line[5] == '\0')
+                    report_set_binary_status(line[4] == '1');
+                else
+                    retval = Status_InvalidStatement;
+            } else {
                 settings_restore_t restore = {0};
                 if (!(line[2] == 'S' && line[3] == 'T' && line[4] == '=' && line[6] == '\0'))
                     retval = Status_InvalidStatement;
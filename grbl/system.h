@@ -224,10 +224,10 @@ typedef struct {
     axes_signals_t homed;               // Indicates which axes has been homed.
     overrides_t override;               // Override values & states
     report_tracking_flags_t report;     // Tracks when to add data to status reports.
+    bool binary_status;                 // Output realtime status reports as binary frames, set by $RB=1, cleared when the output stream changes.
     parking_state_t parking_state;      // Tracks parking state
     hold_state_t holding_state;         // Tracks holding state
     float spindle_rpm;
-    char *message;                      // Message to be displayed
 #ifdef PID_LOG
     pid_data_t pid_log;
 #endif
@@ -29,7 +29,6 @@
 
 #define A_MOTOR X_AXIS // Must be X_AXIS
 #define B_MOTOR Y_AXIS // Must be Y_AXIS
-#define MAX_SEG_LENGTH_MM 2.0f
 
 typedef struct {
     int32_t width;
@@ -49,19 +48,53 @@ typedef struct {
 
 static machine_t machine = {0};
 
-// Returns machine position in mm converted from system position steps.
+// Transform motor positions (mm) to cartesian position (mm).
 // TODO: perhaps change to double precision here - float calculation results in errors of a couple of micrometers.
-static void wp_convert_array_steps_to_mpos (float *position, int32_t *steps)
+static void wp_transform_to_cartesian (float *position, float *target)
 {
+    uint_fast8_t idx = N_AXIS - 1;
     coord_t len;
 
-    len.a = (float)steps[A_MOTOR] / settings.steps_per_mm[A_MOTOR];
-    len.b = (float)steps[B_MOTOR] / settings.steps_per_mm[B_MOTOR];
+    do {
+        position[idx] = target[idx];
+    } while(--idx > Y_AXIS);
+
+    len.a = target[A_MOTOR];
+    len.b = target[B_MOTOR];
 
     position[X_AXIS] = (machine.width_pow + len.a * len.a - len.b * len.b) / (2.0f * machine.width_mm);
     len.a = machine.width_mm - position[X_AXIS];
     position[Y_AXIS] = sqrtf(len.b * len.b - len.a * len.a );
-    position[Z_AXIS] = steps[Z_AXIS] / settings.steps_per_mm[Z_AXIS];
+}
+
+// Transform cartesian position (mm) to motor positions (mm).
+// A length = sqrt( X^2 + Y^2 )
+// B length = sqrt( (MACHINE_WIDTH - X)^2 + Y^2 )
+static void wp_transform_from_cartesian (float *target, float *position)
+{
+    uint_fast8_t idx = N_AXIS - 1;
+    float xpos = machine.width_mm - position[A_MOTOR];
+
+    do {
+        target[idx] = position[idx];
+    } while(--idx > Y_AXIS);
+
+    target[A_MOTOR] = sqrtf(position[A_MOTOR] * position[A_MOTOR] + position[B_MOTOR] * position[B_MOTOR]);
+    target[B_MOTOR] = sqrtf(xpos * xpos + position[B_MOTOR] * position[B_MOTOR]);
+}
+
+// Returns machine position in mm converted from system position steps.
+static void wp_convert_array_steps_to_mpos (float *position, int32_t *steps)
+{
+    uint_fast8_t idx = N_AXIS;
+    float target[N_AXIS];
+
+    do {
+        idx--;
+        target[idx] = (float)steps[idx] / settings.steps_per_mm[idx];
+    } while(idx);
+
+    wp_transform_to_cartesian(position, target);
 }
 
 // Wall plotter calculation only. Returns x or y-axis "steps" based on wall plotter motor steps.
@@ -91,62 +124,6 @@ static void wp_plan_target_to_steps (int32_t *target_steps, float *target)
     target_steps[B_MOTOR] = wp_convert_to_b_motor_steps(target);
 }
 
-// Wall plotter is circular in motion, so long lines must be divided up
-static bool wp_segment_line (float *target, plan_line_data_t *pl_data, bool init)
-{
-    static uint_fast16_t iterations;
-    static bool segmented;
-    static float delta[N_AXIS], segment_target[N_AXIS];
-//    static plan_line_data_t plan;
-
-    uint_fast8_t idx = N_AXIS;
-
-    if(init) {
-
-        float max_delta = 0.0f;
-
-        do {
-            idx--;
-            delta[idx] = target[idx] - gc_state.position[idx];
-            max_delta = max(max_delta, fabs(delta[idx]));
-        } while(idx);
-
-        if((segmented = !(pl_data->condition.rapid_motion || pl_data->condition.jog_motion) &&
-                           max_delta > MAX_SEG_LENGTH_MM && !(delta[X_AXIS] == 0.0f && delta[Y_AXIS] == 0.0f))) {
-
-            idx = N_AXIS;
-            iterations = (uint_fast16_t)ceilf(max_delta / MAX_SEG_LENGTH_MM);
-
-            memcpy(segment_target, gc_state.position, sizeof(segment_target));
-//            memcpy(&plan, pl_data, sizeof(plan_line_data_t));
-
-            do {
-                delta[--idx] /= (float)iterations;
-                target[idx] = gc_state.position[idx];
-            } while(idx);
-
-        } else
-            iterations = 1;
-
-        iterations++; // return at least one iteration
-
-    } else {
-
-        iterations--;
-
-        if(segmented && iterations) do {
-            idx--;
-            segment_target[idx] += delta[idx];
-            target[idx] = segment_target[idx];
-//            memcpy(pl_data, &plan, sizeof(plan_line_data_t));
-        } while(idx);
-
-    }
-
-    return iterations != 0;
-}
-
-
 static uint_fast8_t wp_limits_get_axis_mask (uint_fast8_t idx)
 {
     return ((idx == A_MOTOR) || (idx == B_MOTOR)) ? (bit(X_AXIS) | bit(Y_AXIS)) : bit(idx);
@@ -250,7 +227,9 @@ void wall_plotter_init (void)
     kinematics.limits_set_machine_positions = wp_limits_set_machine_positions;
     kinematics.plan_target_to_steps = wp_plan_target_to_steps;
     kinematics.convert_array_steps_to_mpos = wp_convert_array_steps_to_mpos;
-    kinematics.segment_line = wp_segment_line;
+    kinematics.transform_from_cartesian = wp_transform_from_cartesian;
+    kinematics.transform_to_cartesian = wp_transform_to_cartesian;
+    kinematics.segment_line = mc_segment_line; // Wall plotter is circular in motion, so long lines must be divided up
 }
 
 #endif
@@ -145,6 +145,34 @@ int16_t TCPStreamGetC (void)
     return data;
 }
 
+//
+// TCPStreamReadSpan - copies input up to and including the first end of line character, returns 0 if no data available
+//
+uint16_t TCPStreamReadSpan (char *buf, uint16_t max)
+{
+    char c;
+    SYS_ARCH_DECL_PROTECT(lev);
+    uint16_t count = 0;
+    uint_fast16_t tail = streamSession.rxbuf.tail, bptr = tail, head = streamSession.rxbuf.head;
+
+    while(count < max && bptr != head) {
+        buf[count++] = c = streamSession.rxbuf.data[bptr];
+        bptr = (bptr + 1) & (RX_BUFFER_SIZE - 1);
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    // Keep the tail set by a stop or jog cancel received while copying, the span is cancelled input then.
+    SYS_ARCH_PROTECT(lev);
+    if(streamSession.rxbuf.tail == tail)
+        streamSession.rxbuf.tail = bptr; // Update pointer
+    else
+        count = 0;
+    SYS_ARCH_UNPROTECT(lev);
+
+    return count;
+}
+
 inline uint16_t TCPStreamRxCount (void)
 {
     uint_fast16_t head = streamSession.rxbuf.head, tail = streamSession.rxbuf.tail;
@@ -169,24 +197,6 @@ void TCPStreamRxCancel (void)
     streamSession.rxbuf.head = (streamSession.rxbuf.tail + 1) & (RX_BUFFER_SIZE - 1);
 }
 
-static bool streamBufferRX (char c)
-{
-    // discard input if MPG has taken over...
-    if(hal.stream.type != StreamType_MPG) {
-
-        uint_fast16_t bptr = (streamSession.rxbuf.head + 1) & (RX_BUFFER_SIZE - 1); // Get next head pointer
-
-        if(bptr == streamSession.rxbuf.tail)                        // If buffer full
-            streamSession.rxbuf.overflow = true;                    // flag overflow
-        else if(!hal.stream.enqueue_realtime_command(c)) {          // If not a real time command
-            streamSession.rxbuf.data[streamSession.rxbuf.head] = c; // add data to buffer
-            streamSession.rxbuf.head = bptr;                        // and update pointer
-        }
-    }
-
-    return !streamSession.rxbuf.overflow;
-}
-
 bool TCPStreamPutC (const char c)
 {
     uint32_t next_head = (streamSession.txbuf.head + 1) & (TX_BUFFER_SIZE - 1);  // Get and update head pointer
@@ -341,9 +351,9 @@ static err_t streamReceive (void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_
             SYS_ARCH_PROTECT(lev);
 
             if(session->rcvHead->next == session->rcvTail) {
-                // Queue full, discard
+                // Queue full, refuse data. lwIP holds on to the pbuf and delivers it again later
                 SYS_ARCH_UNPROTECT(lev);
-                pbuf_free(p);
+                return ERR_MEM;
             } else {
                 session->rcvHead->pbuf = p;
                 session->rcvHead = session->rcvHead->next;
@@ -487,7 +497,12 @@ void TCPStreamPoll (void)
         if(payload == NULL)
             break; // No more data to be processed...
 
-        streamBufferRX(payload[streamSession.bufferIndex++]);
+        // Add as much of the current pbuf as fits to the input buffer, remaining data is processed when there is room.
+        // Input is discarded if MPG has taken over...
+        if(hal.stream.type == StreamType_MPG)
+            streamSession.bufferIndex = streamSession.pbufCurrent->len;
+        else
+            streamSession.bufferIndex += protocol_enqueue_input(&streamSession.rxbuf, (char *)&payload[streamSession.bufferIndex], streamSession.pbufCurrent->len - streamSession.bufferIndex);
 
         if(streamSession.bufferIndex >= streamSession.pbufCurrent->len) {
             streamSession.pbufCurrent = streamSession.pbufCurrent->next;
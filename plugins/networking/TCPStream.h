@@ -45,6 +45,7 @@ void TCPStreamClose(void);
 void TCPStreamPoll(void);
 void TCPStreamNotifyLinkStatus(bool bLinkStatusUp);
 int16_t TCPStreamGetC(void);
+uint16_t TCPStreamReadSpan(char *buf, uint16_t max);
 bool TCPStreamPutC(const char data);
 void TCPStreamWriteS(const char *data);
 void TCPStreamWriteLn(const char *data);
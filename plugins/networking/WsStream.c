@@ -80,6 +80,9 @@ typedef enum {
     WsOpcode_Pong = 0xA
 } websocket_opcode_t;
 
+#define WS_STATUS_PROTOCOL_ERROR 1002
+#define WS_CONTROL_PAYLOAD_MAX 125   // Max payload length of control frames (RFC 6455 5.5)
+
 typedef enum
 {
     WsState_Idle,
@@ -101,14 +104,15 @@ typedef union {
 
 typedef struct {
     uint32_t idx;
-    uint32_t payload_len;
-    uint32_t payload_rem;
-    uint32_t rx_index;
+    uint32_t size;
+    uint64_t payload_len;
+    uint64_t payload_rem;
+    uint64_t rx_index;
     uint8_t *frame;
     uint32_t mask;
     bool masked;
     bool complete;
-    uint8_t data[13];
+    uint8_t data[14];   // 2 + 8 bytes extended payload length + 4 bytes mask
 } frame_header_t;
 
 typedef struct pbuf_entry
@@ -167,6 +171,11 @@ static const ws_frame_start_t wshdr_ping = {
   .opcode = WsOpcode_Ping
 };
 
+static const ws_frame_start_t wshdr_close = {
+  .fin    = true,
+  .opcode = WsOpcode_Close
+};
+
 static const ws_sessiondata_t defaultSettings =
 {
     .port = 80,
@@ -226,6 +235,34 @@ int16_t WsStreamGetC (void)
     return data;
 }
 
+//
+// WsStreamReadSpan - copies input up to and including the first end of line character, returns 0 if no data available
+//
+uint16_t WsStreamReadSpan (char *buf, uint16_t max)
+{
+    char c;
+    SYS_ARCH_DECL_PROTECT(lev);
+    uint16_t count = 0;
+    uint_fast16_t tail = streamSession.rxbuf.tail, bptr = tail, head = streamSession.rxbuf.head;
+
+    while(count < max && bptr != head) {
+        buf[count++] = c = streamSession.rxbuf.data[bptr];
+        bptr = (bptr + 1) & (RX_BUFFER_SIZE - 1);
+        if(c == ASCII_LF || c == ASCII_CR)
+            break;
+    }
+
+    // Keep the tail set by a stop or jog cancel received while copying, the span is cancelled input then.
+    SYS_ARCH_PROTECT(lev);
+    if(streamSession.rxbuf.tail == tail)
+        streamSession.rxbuf.tail = bptr; // Update pointer
+    else
+        count = 0;
+    SYS_ARCH_UNPROTECT(lev);
+
+    return count;
+}
+
 inline uint16_t WsStreamRxCount (void)
 {
     uint_fast16_t head = streamSession.rxbuf.head, tail = streamSession.rxbuf.tail;
@@ -768,48 +805,132 @@ static void WsConnectionHandler (ws_sessiondata_t *session)
 // Process data for streaming
 //
 
+// Collects control frame payloads spanning several pbufs, the payload length is checked against the
+// control frame limit when the header is parsed and again here before it is used as an allocation size.
 static bool WsCollectFrame (frame_header_t *header, uint8_t *payload, uint32_t len)
 {
-    if(header->payload_rem > len && header->payload_rem == header->payload_len) {
-        if((header->frame = malloc(header->payload_len + header->idx)))
+    if(header->payload_rem > len && header->payload_rem == header->payload_len && header->payload_len <= WS_CONTROL_PAYLOAD_MAX) {
+        if((header->frame = malloc((size_t)header->payload_len + header->idx)))
             memcpy(header->frame, &header->data, header->idx);
     }
 
-    header->payload_rem -= len;
-
     if(header->frame)
-        memcpy(header->frame + header->idx + header->payload_len - header->payload_rem - 1, payload, len);
+        memcpy(header->frame + header->idx + (size_t)(header->payload_len - header->payload_rem), payload, len);
+
+    header->payload_rem -= len;
 
     return header->frame != NULL;
 }
 
+// Unmasks payload data in place, a word at a time when aligned. phase is the payload offset in the frame modulo 4.
+static void WsUnmask (uint8_t *payload, uint32_t len, uint32_t mask, uint_fast8_t phase)
+{
+    uint32_t wmask, *wpayload;
+    uint8_t *m = (uint8_t *)&mask, *wm = (uint8_t *)&wmask;
+
+    while(len && ((uintptr_t)payload & 0x03)) {
+        *payload++ ^= m[phase++ & 0x03];
+        len--;
+    }
+
+    if(len >= 4) {
+
+        wm[0] = m[phase & 0x03];
+        wm[1] = m[(phase + 1) & 0x03];
+        wm[2] = m[(phase + 2) & 0x03];
+        wm[3] = m[(phase + 3) & 0x03];
+
+        wpayload = (uint32_t *)payload;
+
+        do {
+            *wpayload++ ^= wmask;
+        } while((len -= 4) >= 4);
+
+        payload = (uint8_t *)wpayload;
+    }
+
+    while(len--)
+        *payload++ ^= m[phase++ & 0x03];
+}
+
+// Fails the connection by sending a close frame with a protocol error status, further input is discarded.
+static void WsFailConnection (ws_sessiondata_t *session)
+{
+    uint8_t close_frame[4];
+
+    close_frame[0] = wshdr_close.token;
+    close_frame[1] = 2;
+    close_frame[2] = WS_STATUS_PROTOCOL_ERROR >> 8;
+    close_frame[3] = WS_STATUS_PROTOCOL_ERROR & 0xFF;
+    tcp_write(session->pcbConnect, close_frame, 4, 1);
+    tcp_output(session->pcbConnect);
+
+    if(session->header.frame)
+        free(session->header.frame);
+    memset(&session->header, 0, sizeof(frame_header_t));
+    session->state = WsStateClosing;
+}
+
 static uint32_t WsParse (ws_sessiondata_t *session, uint8_t *payload, uint32_t len)
 {
     bool frame_done = false;
-    uint32_t plen = len;
+    uint32_t plen = len, count;
 
-    // Collect frame header
+    if(session->state == WsStateClosing)
+        return len; // Discard any input received after the connection is failed or closed
+
+    // Collect frame header, first the two bytes holding the header size then the remainder
     while(!session->header.complete && plen) {
 
-        session->header.data[session->header.idx++] = *payload++;
+        count = (session->header.idx < 2 ? 2 : session->header.size) - session->header.idx;
+        if(count > plen)
+            count = plen;
+
+        memcpy(&session->header.data[session->header.idx], payload, count);
+        session->header.idx += count;
+        payload += count;
+        plen -= count;
 
         if(session->header.idx == 2) {
-            session->header.masked      = session->header.data[1] & 0x80; // always true from client
+            session->header.masked      = session->header.data[1] & 0x80;
             session->header.payload_len = session->header.data[1] & 0x7F;
-        }
 
-        if(session->header.idx >= 6) {
-            if((session->header.complete = (session->header.idx == (session->header.payload_len == 126 ? 8 : 6)))) {
-                if(session->header.payload_len == 126) {
-                    session->header.payload_len = (session->header.data[2] << 8) | session->header.data[3];
-                    memcpy(&session->header.mask, &session->header.data[4], sizeof(uint32_t));
-                } else
-                    memcpy(&session->header.mask, &session->header.data[2], sizeof(uint32_t));
-                session->header.payload_rem = session->header.payload_len;
+            // Client frames must be masked, fail the connection with a protocol error close frame if not (RFC 6455 5.1).
+            if(!session->header.masked) {
+                WsFailConnection(session);
+                return len;
             }
+
+            session->header.size = 2 + (session->header.payload_len == 126 ? 2 : (session->header.payload_len == 127 ? 8 : 0)) + 4;
         }
 
-        plen--;
+        if((session->header.complete = session->header.idx == session->header.size)) {
+
+            uint8_t *data = &session->header.data[2];
+
+            if(session->header.payload_len == 126) {
+                session->header.payload_len = (data[0] << 8) | data[1];
+                data += 2;
+            } else if(session->header.payload_len == 127) {
+                session->header.payload_len = 0;
+                for(count = 0; count < 8; count++)
+                    session->header.payload_len = (session->header.payload_len << 8) | *data++;
+            }
+
+            memcpy(&session->header.mask, data, sizeof(uint32_t));
+
+            // Control frames must not be fragmented and carry at most 125 bytes, and the most significant bit
+            // of a 64 bit length must be 0 (RFC 6455 5.2 and 5.5). Fail the connection if not.
+            ws_frame_start_t fs = (ws_frame_start_t)session->header.data[0];
+
+            if((session->header.payload_len & 0x8000000000000000ULL) ||
+                ((fs.opcode & 0x08) && (!fs.fin || session->header.payload_len > WS_CONTROL_PAYLOAD_MAX))) {
+                WsFailConnection(session);
+                return len;
+            }
+
+            session->header.payload_rem = session->header.payload_len;
+        }
     }
 
 //    if(session->start.token != FRAME_NONE)
@@ -843,8 +964,7 @@ static uint32_t WsParse (ws_sessiondata_t *session, uint8_t *payload, uint32_t l
 
                 if (session->header.payload_rem) {
 
-                    uint8_t *mask = (uint8_t *)&session->header.mask;
-                    uint_fast16_t payload_len = session->header.payload_rem > plen ? plen : session->header.payload_rem;
+                    count = session->header.payload_rem > plen ? plen : (uint32_t)session->header.payload_rem;
 
                     session->start.token = session->header.payload_rem > plen ? fs.token : FRAME_NONE;
 /*
@@ -858,29 +978,37 @@ static uint32_t WsParse (ws_sessiondata_t *session, uint8_t *payload, uint32_t l
                     DEBUG_PRINT(uitoa(payload_len));
                     DEBUG_PRINT("\r\n");
 */
-                    // Unmask and add data to input buffer
-                    uint_fast16_t i = session->header.rx_index;
-                    session->rxbuf.overflow = false;
-
-                    while (payload_len--) {
-                        if(!WsStreamRxInsert(*payload++ ^ mask[i % 4]))
-                            break; // If overflow pend buffering rest of data until next polling
-                        plen--;
-                        i++;
-                    }
+                    // Unmask and add data to input buffer. Only data that is guaranteed to fit is unmasked in place,
+                    // if there is no room for all pend buffering rest of data until next polling.
+                    if((session->rxbuf.overflow = count > WsStreamRxFree()))
+                        count = WsStreamRxFree();
+
+                    WsUnmask(payload, count, session->header.mask, (uint_fast8_t)session->header.rx_index & 0x03);
 
-                    session->header.rx_index = i;
+                    // discard input if MPG has taken over...
+                    if(hal.stream.type != StreamType_MPG)
+                        protocol_enqueue_input(&session->rxbuf, (char *)payload, count);
+
+                    payload += count;
+                    plen -= count;
+                    session->header.rx_index += count;
                     frame_done = (session->header.payload_rem = session->header.payload_len - session->header.rx_index) == 0;
-                }
+                } else
+                    frame_done = true; // Empty frame
                 break;
 
             case WsOpcode_Close:
                 if((frame_done = plen >= session->header.payload_rem)) {
+                    bool whole = session->header.payload_rem == session->header.payload_len;
                     plen -= session->header.payload_rem;
                     if(WsCollectFrame(&session->header, payload, session->header.payload_rem))
                         payload = session->header.frame;
-                    tcp_write(session->pcbConnect, payload, session->header.payload_len, 1);
-                    tcp_output(session->pcbConnect);
+                    else if(!whole)
+                        payload = NULL; // Spans pbufs and could not be collected
+                    if(payload) {
+                        tcp_write(session->pcbConnect, payload, (u16_t)session->header.payload_len, 1);
+                        tcp_output(session->pcbConnect);
+                    }
                     session->state = WsStateClosing;
                 } else {
                     WsCollectFrame(&session->header, payload, plen);
@@ -891,13 +1019,18 @@ static uint32_t WsParse (ws_sessiondata_t *session, uint8_t *payload, uint32_t l
             case WsOpcode_Ping:
                 if((frame_done = plen >= session->header.payload_rem)) {
                     if(streamSession.state != WsStateClosing) {
+                        bool whole = session->header.payload_rem == session->header.payload_len;
                         plen -= session->header.payload_rem;
                         if(WsCollectFrame(&session->header, payload, session->header.payload_rem))
                             payload = session->header.frame;
-                        fs.opcode = WsOpcode_Pong;
-                        payload[0] = fs.token;
-                        tcp_write(session->pcbConnect, payload, session->header.payload_len, 1);
-                        tcp_output(session->pcbConnect);
+                        else if(!whole)
+                            payload = NULL; // Spans pbufs and could not be collected
+                        if(payload && session->header.payload_len) {
+                            fs.opcode = WsOpcode_Pong;
+                            payload[0] = fs.token;
+                            tcp_write(session->pcbConnect, payload, (u16_t)session->header.payload_len, 1);
+                            tcp_output(session->pcbConnect);
+                        }
                     }
                 } else {
                     WsCollectFrame(&session->header, payload, plen);
@@ -45,6 +45,7 @@ void WsStreamClose(void);
 void WsStreamPoll(void);
 void WsStreamNotifyLinkStatus(bool bLinkStatusUp);
 int16_t WsStreamGetC(void);
+uint16_t WsStreamReadSpan(char *buf, uint16_t max);
 bool WsStreamPutC(const char data);
 void WsStreamWriteS(const char *data);
 void WsStreamWriteLn(const char *data);
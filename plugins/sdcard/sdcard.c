@@ -30,6 +30,12 @@
 /* uses fatfs - http://www.elm-chan.org/fsw/ff/00index_e.html */
 
 #define MAX_PATHLEN 128
+
+// Size of read ahead buffer, should be a multiple of the sector size (512 bytes) since FatFs then transfers
+// whole sectors directly to the buffer instead of via its sector cache.
+#ifndef SDCARD_READ_BUFFER_SIZE
+#define SDCARD_READ_BUFFER_SIZE 1024
+#endif
 #define LCAPS(c) ((c >= 'A' && c <= 'Z') ? c | 0x20 : c)
 
 
@@ -56,6 +62,13 @@ typedef enum {
     Filename_Invalid
 } file_status_t;
 
+typedef struct
+{
+    UINT head;      // Index of next character to return
+    UINT count;     // Number of characters in buffer
+    uint8_t data[SDCARD_READ_BUFFER_SIZE];
+} file_buffer_t;
+
 typedef struct
 {
     FATFS *fs;
@@ -65,6 +78,7 @@ typedef struct
     size_t pos;
     uint32_t line;
     uint8_t eol;
+    file_buffer_t buffer;
 } file_t;
 
 static file_t file = {
@@ -225,6 +239,7 @@ static bool file_open (char *filename)
         file.pos = 0;
         file.line = 0;
         file.eol = false;
+        file.buffer.head = file.buffer.count = 0;
         char *leafname = strrchr(filename, '/');
         strncpy(file.name, leafname ? leafname + 1 : filename, sizeof(file.name));
         file.name[sizeof(file.name) - 1] = '\0';
@@ -233,15 +248,21 @@ static bool file_open (char *filename)
     return file.handle != NULL;
 }
 
+// Returns next character from read ahead buffer, the buffer is refilled by a single f_read() call when empty.
 static int16_t file_read (void)
 {
-    signed char c;
-    UINT count;
+    int16_t c = -1;
 
-    if(f_read(file.handle, &c, 1, &count) == FR_OK && count == 1)
-        file.pos = f_tell(file.handle);
-    else
-        c = -1;
+    if(file.buffer.head == file.buffer.count) {
+        file.buffer.head = 0;
+        if(f_read(file.handle, file.buffer.data, sizeof(file.buffer.data), &file.buffer.count) != FR_OK)
+            file.buffer.count = 0;
+    }
+
+    if(file.buffer.head < file.buffer.count) {
+        c = (int16_t)file.buffer.data[file.buffer.head++];
+        file.pos++;
+    }
 
     if(c == '\r' || c == '\n')
         file.eol++;
@@ -315,6 +336,21 @@ static int16_t sdcard_read (void)
     return c;
 }
 
+// Returns input up to and including the first end of line character, line counting and end of job handling as sdcard_read().
+static uint16_t sdcard_read_span (char *buf, uint16_t max)
+{
+    int16_t c;
+    uint16_t count = 0;
+
+    while(count < max && (c = sdcard_read()) != -1) {
+        buf[count++] = (char)c;
+        if(c == '\r' || c == '\n')
+            break;
+    }
+
+    return count;
+}
+
 static int16_t await_cycle_start (void)
 {
     return -1;
@@ -331,8 +367,10 @@ static ISR_CODE bool drop_input_stream (char c)
 static void trap_state_change_request(uint_fast16_t state)
 {
     if(state == STATE_CYCLE) {
-        if(hal.stream.read == await_cycle_start)
+        if(hal.stream.read == await_cycle_start) {
             hal.stream.read = sdcard_read;
+            hal.stream.read_span = sdcard_read_span;
+        }
         hal.state_change_requested = NULL;
     }
 }
@@ -358,8 +396,10 @@ static message_code_t trap_feedback_message (message_code_t message_code)
             f_lseek(file.handle, 0);
             file.pos = file.line = 0;
             file.eol = false;
+            file.buffer.head = file.buffer.count = 0;
             report_feedback_message(Message_CycleStartToRerun);
             hal.stream.read = await_cycle_start;
+            hal.stream.read_span = NULL;
             hal.state_change_requested = trap_state_change_request;
         } else
             sdcard_end_job();
@@ -388,10 +428,12 @@ static bool sdcard_suspend (bool suspend)
     if(suspend) {
         hal.stream.reset_read_buffer();
         hal.stream.read = active_stream.read;               // Restore normal stream input for tool change (jog etc)
+        hal.stream.read_span = active_stream.read_span;
         hal.stream.enqueue_realtime_command = active_stream.enqueue_realtime_command;
         hal.report.status_message = report_status_message;  // as well as normal status messages reporting
     } else {
         hal.stream.read = sdcard_read;                      // Resume reading from SD card
+        hal.stream.read_span = sdcard_read_span;
         hal.stream.enqueue_realtime_command = drop_input_stream;
         hal.report.status_message = trap_status_report;     // and redirect status messages back to us
     }
@@ -431,6 +473,7 @@ static status_code_t sdcard_parse (uint_fast16_t state, char *line, char *lcline
                     memcpy(&active_stream, &hal.stream, sizeof(io_stream_t));   // Save current stream pointers
                     hal.stream.type = StreamType_SDCard;                        // then redirect to read from SD card instead
                     hal.stream.read = sdcard_read;                              // ...
+                    hal.stream.read_span = sdcard_read_span;                    // ...
                     hal.stream.enqueue_realtime_command = drop_input_stream;    // Drop input from current stream except realtime commands
 #if M6_ENABLE
                     hal.stream.suspend_read = sdcard_suspend;                   // ...